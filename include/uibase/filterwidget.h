@@ -3,13 +3,16 @@
 
 #include "dllimport.h"
 #include <QAbstractItemView>
+#include <QHash>
 #include <QLineEdit>
 #include <QList>
 #include <QObject>
 #include <QRegularExpression>
+#include <QSet>
 #include <QShortcut>
 #include <QSortFilterProxyModel>
 #include <QToolButton>
+#include <memory>
 
 namespace MOBase
 {
@@ -23,7 +26,25 @@ class QDLLEXPORT FilterWidgetProxyModel : public QSortFilterProxyModel
 
 public:
   FilterWidgetProxyModel(FilterWidget& fw, QWidget* parent = nullptr);
-  using QSortFilterProxyModel::invalidateFilter;
+  ~FilterWidgetProxyModel() override;
+
+  // filters all the rows again
+  //
+  void invalidateFilter();
+
+  // filters again only the rows that passed the filter the last time, for when the
+  // filter became more restrictive and cannot accept rows it rejected before
+  //
+  void refineFilter();
+
+  // evaluates the filter for all the rows on a thread pool and applies the result in
+  // a single pass once it is ready; the result is dropped if the filter changed or
+  // rows were added or removed in the meantime, rows whose data changed are filtered
+  // again when it is applied
+  //
+  void filterInBackground(bool refining);
+
+  void setSourceModel(QAbstractItemModel* model) override;
 
 protected:
   bool filterAcceptsRow(int row, const QModelIndex& parent) const override;
@@ -31,10 +52,61 @@ protected:
   bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
 
 private:
+  friend class FilterWidget;
+
   FilterWidget& m_filter;
 
-  bool columnMatches(int sourceRow, const QModelIndex& sourceParent, int c,
-                     const QRegularExpression& what) const;
+  // first column of the source rows that the filter rejected since the last full
+  // pass, forgotten whenever the rows are filtered again except by refineFilter()
+  mutable QSet<QModelIndex> m_rejected;
+
+  // whether m_rejected can be used, only during refineFilter()
+  bool m_refining;
+
+  // first column of the source rows that were filtered, and whether the row or one
+  // of its descendants matched; every row is evaluated at most once until the
+  // filter or the source model change
+  mutable QHash<QModelIndex, bool> m_accepted;
+
+  QList<QMetaObject::Connection> m_sourceConnections;
+
+  // text of the rows for background filtering and the jobs that filter them
+  struct Snapshot;
+  struct Job;
+
+  std::shared_ptr<const Snapshot> m_snapshot;
+  std::shared_ptr<Job> m_pending;
+  std::shared_ptr<const Job> m_applied;
+
+  // first column of the rows of the snapshot whose data changed since it was taken,
+  // they are filtered again when the result of a job is applied
+  QSet<QModelIndex> m_changed;
+
+  // the job whose result filterAcceptsRow() returns, only while it is applied
+  const Job* m_applying;
+
+  // forgets which rows were accepted and rejected, called before every pass of the
+  // base class over all the rows
+  void forgetResults();
+
+  // forgets the rejected rows and the snapshot, called when the rows of the source
+  // change
+  void forgetRows();
+
+  // forgets the results of the rows whose data changed, the snapshot is kept
+  void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                           const QList<int>& roles);
+
+  // whether the row matches the filter, ignoring its descendants
+  bool matchesRow(int row, const QModelIndex& parent, const QModelIndex& first) const;
+
+  // whether the row or one of its descendants matches the filter
+  bool acceptsRowOrChildren(int row, const QModelIndex& parent,
+                            const QModelIndex& first) const;
+
+  std::shared_ptr<const Snapshot> snapshot();
+  void onJobFinished(std::shared_ptr<Job> job);
+  void stopBackgroundFiltering();
 };
 
 class QDLLEXPORT FilterWidget : public QObject
@@ -50,8 +122,23 @@ public:
     bool scrollToSelection  = false;
   };
 
-  using predFun = std::function<bool(const QRegularExpression& what)>;
-  using sortFun = std::function<bool(const QModelIndex&, const QModelIndex&)>;
+  // a keyword of the filter, the regex is always set so it can be given to the
+  // predicates of matches(), but plain keywords are matched as literals instead
+  //
+  struct Keyword
+  {
+    QRegularExpression regex;
+
+    // case folded keyword, empty if the keyword is a regular expression
+    QString literal;
+  };
+
+  // segments that are OR'ed, made of keywords that are AND'ed
+  using Compiled = QList<QList<Keyword>>;
+
+  using predFun    = std::function<bool(const QRegularExpression& what)>;
+  using sortFun    = std::function<bool(const QModelIndex&, const QModelIndex&)>;
+  using keywordFun = std::function<bool(const Keyword& keyword)>;
 
   FilterWidget();
 
@@ -82,6 +169,12 @@ public:
   void setFilteredBorder(bool b);
   bool filteredBorder() const;
 
+  // when set, the rows are filtered on a thread pool while the list keeps showing
+  // the previous result, for models that are too large to filter while typing
+  //
+  void setBackgroundFiltering(bool b);
+  bool backgroundFiltering() const;
+
   FilterWidgetProxyModel* proxyModel();
   QAbstractItemModel* sourceModel();
 
@@ -93,12 +186,32 @@ public:
   bool matches(predFun pred) const;
   bool matches(const QString& s) const;
 
+  // whether the given predicate accepts the keywords of one of the segments,
+  // thread-safe
+  //
+  static bool matchesKeywords(const Compiled& compiled, const keywordFun& pred);
+
+  // whether the string matches the keywords of one of the segments, plain keywords
+  // are matched regardless of case, thread-safe
+  //
+  static bool matches(const Compiled& compiled, const QString& s);
+
+  // compiles the text of a filter, the regular expressions of the keywords are not
+  // checked for validity
+  //
+  static Compiled compile(const QString& text, const Options& options);
+
+  // whether the current filter can only accept rows that the previous one accepted,
+  // which is the case when only plain keywords were extended or added
+  //
+  static bool isRefinement(const Compiled& previous, const Compiled& current);
+
 signals:
   void aboutToChange(const QString& oldFilter, const QString& newFilter);
   void changed(const QString& oldFilter, const QString& newFilter);
 
 private:
-  using Compiled = QList<QList<QRegularExpression>>;
+  friend class FilterWidgetProxyModel;
 
   QLineEdit* m_edit;
   QAbstractItemView* m_list;
@@ -116,6 +229,7 @@ private:
   int m_filterColumn;
   bool m_filteringEnabled;
   bool m_filteredBorder;
+  bool m_backgroundFiltering;
 
   void hookEdit();
   void unhookEdit();
@@ -49,6 +49,20 @@ public:
 
   ~FindDialog();
 
+  /**
+   * @brief shows the number of matches of the pattern
+   *
+   * @param current index of the selected match, -1 if none
+   * @param count number of matches found so far
+   * @param complete whether the search is done
+   **/
+  void setMatches(qint64 current, qint64 count, bool complete);
+
+  /**
+   * @brief shows an error about the pattern instead of the matches
+   **/
+  void setError(const QString& error);
+
 signals:
 
   /**
@@ -57,6 +71,12 @@ signals:
    **/
   void findNext();
 
+  /**
+   * @brief emitted when the user wants to jump to the previous location matching the
+   *        pattern
+   **/
+  void findPrevious();
+
   /**
    * @brief emitted when the user changes the pattern to search for
    *
@@ -64,9 +84,18 @@ signals:
    **/
   void patternChanged(const QString& pattern);
 
+  /**
+   * @brief emitted when the user toggles whether the pattern is a regular expression
+   **/
+  void regexChanged(bool regex);
+
 private slots:
   void on_nextBtn_clicked();
 
+  void on_prevBtn_clicked();
+
+  void on_regexBox_toggled(bool checked);
+
   void on_patternEdit_textChanged(const QString& arg1);
 
   void on_closeBtn_clicked();
@@ -23,10 +23,22 @@
 #ifndef JSON_H
 #define JSON_H
 
+#include <QAnyStringView>
+#include <QByteArray>
 #include <QList>
 #include <QString>
+#include <QStringEncoder>
+#include <QStringList>
 #include <QVariant>
 
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "dllimport.h"
+
+class QIODevice;
+
 /**
  * \namespace QtJson
  * \brief A JSON data parser
@@ -38,12 +50,216 @@ namespace QtJson
 typedef QVariantMap JsonObject;
 typedef QVariantList JsonArray;
 
+namespace detail
+{
+struct Tape;
+}
+
+/**
+ * A read-only view of a single value inside a parsed Document
+ *
+ * Values are cheap to copy and keep the underlying document alive. Strings and
+ * numbers are only decoded when they are requested, so walking to a handful of
+ * fields in a large payload does not pay for the rest of it.
+ */
+class QDLLEXPORT Value
+{
+public:
+  enum class Type
+  {
+    Invalid,
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+  /**
+   * an invalid value, returned for lookups that do not match anything
+   */
+  Value();
+
+  Type type() const;
+
+  bool isValid() const { return type() != Type::Invalid; }
+  bool isNull() const { return type() == Type::Null; }
+  bool isBool() const { return type() == Type::Bool; }
+  bool isNumber() const { return type() == Type::Number; }
+  bool isString() const { return type() == Type::String; }
+  bool isArray() const { return type() == Type::Array; }
+  bool isObject() const { return type() == Type::Object; }
+
+  /**
+   * \return the boolean value, or false if this is not a boolean
+   */
+  bool toBool() const;
+
+  /**
+   * \return the number as a double, or 0 if this is not a number
+   */
+  double toDouble() const;
+
+  /**
+   * \return the decoded string, or the raw text of a number; empty for
+   *         anything else
+   */
+  QString toString() const;
+
+  /**
+   * \return the number of elements of an array or members of an object, 0 for
+   *         anything else
+   */
+  qsizetype size() const;
+
+  /**
+   * \return the i-th element of an array or the value of the i-th member of an
+   *         object; this is linear in i
+   */
+  Value at(qsizetype i) const;
+
+  /**
+   * \return the key of the i-th member of an object; this is linear in i
+   */
+  QString keyAt(qsizetype i) const;
+
+  /**
+   * \return all keys of an object, in document order
+   */
+  QStringList keys() const;
+
+  /**
+   * \return the value of the first member with the given key, or an invalid
+   *         value if there is none or this is not an object
+   */
+  Value value(QAnyStringView key) const;
+  Value operator[](QAnyStringView key) const { return value(key); }
+
+  /**
+   * converts this value and everything below it to the same QVariant hierarchy
+   * that parse() returns
+   */
+  QVariant toVariant() const;
+
+private:
+  friend class Document;
+
+  std::shared_ptr<const detail::Tape> m_tape;
+  std::uint32_t m_node;
+
+  Value(std::shared_ptr<const detail::Tape> tape, std::uint32_t node);
+};
+
+/**
+ * A parsed JSON document
+ *
+ * The input is scanned in 64 byte blocks to find all structural characters
+ * first, the tree is then built from that index without looking at the bytes in
+ * between. The document implicitly shares the input buffer and refers to it
+ * instead of copying strings out.
+ */
+class QDLLEXPORT Document
+{
+public:
+  /**
+   * an empty, invalid document
+   */
+  Document();
+
+  /**
+   * parses UTF-8 encoded JSON data
+   *
+   * like parse(), this tolerates stray commas and ignores anything after the
+   * first complete value
+   */
+  static Document parse(const QByteArray& json);
+
+  /**
+   * \return true if the data was parsed successfully
+   */
+  bool isValid() const;
+
+  /**
+   * \return the top level value, invalid if parsing failed
+   */
+  Value root() const;
+
+private:
+  std::shared_ptr<const detail::Tape> m_tape;
+};
+
+/**
+ * Writes the textual JSON representation of QVariant hierarchies straight into
+ * a device or a byte array, without building the pieces in between
+ *
+ * The output is the same as serialize().
+ */
+class QDLLEXPORT Writer
+{
+public:
+  /**
+   * output is buffered and written to the device in large chunks, the device
+   * must stay alive until the writer is destroyed or flush() is called
+   */
+  explicit Writer(QIODevice* device);
+
+  /**
+   * output is appended to the given array
+   */
+  explicit Writer(QByteArray* buffer);
+
+  /**
+   * flushes the remaining output to the device
+   */
+  ~Writer();
+
+  Writer(const Writer&)            = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  /**
+   * writes the given value
+   *
+   * \return false if the value contains something that cannot be serialized,
+   *         like an infinite double or a type with no conversion to a string;
+   *         what was written before the failure is not rolled back
+   */
+  bool write(const QVariant& data);
+
+  /**
+   * writes buffered output to the device, does nothing when writing into an
+   * array
+   *
+   * \return false if the device reported an error
+   */
+  bool flush();
+
+private:
+  QIODevice* m_device;
+  QByteArray* m_out;
+  QByteArray m_buffer;
+  QStringEncoder m_encoder;
+  bool m_deviceOk;
+
+  bool writeValue(const QVariant& data);
+  bool writeList(const QVariantList& list);
+
+  template <class Map>
+  bool writeMap(const Map& map);
+
+  void writeString(QStringView s);
+  void writeRaw(std::string_view s);
+  void writeInteger(qlonglong value);
+  void writeInteger(qulonglong value);
+  void flushIfFull();
+};
+
 /**
  * Parse a JSON string
  *
  * \param json The JSON data
  */
-QVariant parse(const QString& json);
+QDLLEXPORT QVariant parse(const QString& json);
 
 /**
  * Parse a JSON string
@@ -51,7 +267,23 @@ QVariant parse(const QString& json);
  * \param json The JSON data
  * \param success The success of the parsing
  */
-QVariant parse(const QString& json, bool& success);
+QDLLEXPORT QVariant parse(const QString& json, bool& success);
+
+/**
+ * Parse UTF-8 encoded JSON data, this avoids the conversion to UTF-16 that
+ * parse() needs
+ *
+ * \param json The JSON data
+ */
+QDLLEXPORT QVariant parseUtf8(const QByteArray& json);
+
+/**
+ * Parse UTF-8 encoded JSON data
+ *
+ * \param json The JSON data
+ * \param success The success of the parsing
+ */
+QDLLEXPORT QVariant parseUtf8(const QByteArray& json, bool& success);
 
 /**
  * This method generates a textual JSON representation
@@ -60,7 +292,7 @@ QVariant parse(const QString& json, bool& success);
  *
  * \return QByteArray Textual JSON representation in UTF-8
  */
-QByteArray serialize(const QVariant& data);
+QDLLEXPORT QByteArray serialize(const QVariant& data);
 
 /**
  * This method generates a textual JSON representation
@@ -70,7 +302,7 @@ QByteArray serialize(const QVariant& data);
  *
  * \return QByteArray Textual JSON representation in UTF-8
  */
-QByteArray serialize(const QVariant& data, bool& success);
+QDLLEXPORT QByteArray serialize(const QVariant& data, bool& success);
 
 /**
  * This method generates a textual JSON representation
@@ -79,7 +311,7 @@ QByteArray serialize(const QVariant& data, bool& success);
  *
  * \return QString Textual JSON representation
  */
-QString serializeStr(const QVariant& data);
+QDLLEXPORT QString serializeStr(const QVariant& data);
 
 /**
  * This method generates a textual JSON representation
@@ -89,7 +321,8 @@ QString serializeStr(const QVariant& data);
  *
  * \return QString Textual JSON representation
  */
-QString serializeStr(const QVariant& data, bool& success);
+QDLLEXPORT QString serializeStr(const QVariant& data, bool& success);
+
 }  // namespace QtJson
 
 #endif  // JSON_H
@@ -0,0 +1,177 @@
+#ifndef LARGETEXTVIEW_H
+#define LARGETEXTVIEW_H
+
+#include "dllimport.h"
+#include "textsearch.h"
+#include <QAbstractScrollArea>
+#include <QTextOption>
+#include <memory>
+#include <vector>
+
+class QFile;
+class QTextLayout;
+
+namespace MOBase
+{
+
+/**
+ * @brief read-only view of a utf-8 text file that is too large for a QTextEdit
+ *
+ * the file is memory mapped and only the lines that are visible are decoded and
+ * drawn, the offsets of the lines are indexed in the background after the file is
+ * opened; a file that is refreshed is read in memory instead, so it can be
+ * truncated or rotated safely while it is shown
+ **/
+class QDLLEXPORT LargeTextView : public QAbstractScrollArea
+{
+  Q_OBJECT
+
+public:
+  explicit LargeTextView(QWidget* parent = nullptr);
+  ~LargeTextView();
+
+  /**
+   * @brief maps the given file and starts indexing its lines
+   *
+   * @param fileName the file to show
+   * @return false if the file could not be opened or mapped
+   **/
+  bool open(const QString& fileName);
+
+  /**
+   * @brief reads and indexes what was appended to the file since it was opened or
+   *        last refreshed, the file is read again if it was truncated or replaced
+   *
+   * the file stops being mapped, it is read in memory and only kept open while it
+   * is read
+   *
+   * the view stays scrolled to the bottom if it was
+   *
+   * @return false if the file could not be read
+   **/
+  bool refresh();
+
+  /**
+   * @return the file that is shown, empty if none
+   **/
+  QString fileName() const;
+
+  /**
+   * @return whether the lines have been indexed, the view can only be scrolled
+   *         once they are
+   **/
+  bool isIndexed() const;
+
+  /**
+   * @return the number of lines in the file, 0 until the lines have been indexed
+   **/
+  qint64 lineCount() const;
+
+  /**
+   * @return the text of the given line, without the line break
+   **/
+  QString lineText(qint64 line) const;
+
+  /**
+   * @brief draws tabs and spaces
+   **/
+  void setShowWhitespace(bool show);
+
+  /**
+   * @brief the matches of the find pattern in the file, they are highlighted
+   **/
+  TextSearch& search() { return *m_search; }
+
+  /**
+   * @brief selects the given bytes and scrolls to them
+   **/
+  void select(qint64 begin, qint64 end);
+
+  /**
+   * @return the start of the selected bytes, of the first selected line if there are
+   *         none, or of the first visible line
+   **/
+  qint64 selectionStart() const;
+
+  /**
+   * @return the end of the selected bytes, or selectionStart() if there are none
+   **/
+  qint64 selectionEnd() const;
+
+signals:
+  /**
+   * @brief emitted on the gui thread when the lines have been indexed
+   **/
+  void indexed();
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void resizeEvent(QResizeEvent* event) override;
+  void keyPressEvent(QKeyEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+  struct Buffer;
+  struct Mapping;
+  struct Indexer;
+
+  struct Range
+  {
+    qint64 begin;
+    qint64 end;
+  };
+
+  std::shared_ptr<const Mapping> m_mapping;
+
+  // offset of the first byte after the bom
+  qint64 m_begin;
+
+  // offset of the start of each line, complete once indexed
+  std::vector<qint64> m_lineStarts;
+  qint64 m_longestLine;
+  std::shared_ptr<Indexer> m_indexer;
+  TextSearch* m_search;
+
+  QTextOption m_textOption;
+
+  // selected bytes, -1 if none
+  Range m_match;
+
+  // lines selected with the mouse, -1 if none
+  qint64 m_anchorLine;
+  qint64 m_cursorLine;
+
+  // scrolls to the end once the lines appended by refresh() are indexed
+  bool m_stickToBottom;
+
+  void startIndexing(qint64 from);
+  void onIndexed(std::shared_ptr<Indexer> indexer);
+
+  // shows the given bytes from the top and starts indexing them
+  void setMapping(std::shared_ptr<const Mapping> mapping);
+
+  static std::shared_ptr<Mapping> map(const QString& fileName);
+
+  // the bytes of `previous` followed by what was appended to the file, or the whole
+  // file if `previous` is null or mapped
+  static std::shared_ptr<Mapping> read(QFile& file,
+                                       const std::shared_ptr<const Mapping>& previous);
+  const char* data() const;
+  qint64 size() const;
+
+  Range lineRange(qint64 line) const;
+  std::vector<Range> visibleLines() const;
+  qint64 lineAt(qint64 offset) const;
+  qint64 lineAtY(int y) const;
+  QString decode(Range range) const;
+
+  void layoutLine(QTextLayout& layout) const;
+  void updateScrollBars();
+  void scrollToMatch();
+  void copy() const;
+};
+
+}  // namespace MOBase
+
+#endif  // LARGETEXTVIEW_H
@@ -15,10 +15,12 @@
 
 #include <QtGlobal>
 
+class QByteArray;
 class QString;
 class QIODevice;
 class QImage;
 class QImageReader;
+class PeInfo;
 
 namespace IcoUtils
 {
@@ -28,12 +30,21 @@ bool loadIcoImageFromExe(QIODevice* inputDevice, QImage& image, int needWidth =
 bool loadIcoImageFromExe(const QString& inputFileName, QImage& image,
                          int needWidth = 512, int needHeight = 512);
 
+// picks the image from the icon directory in info and only reads that one from the
+// file, the file is parsed again if the directory doesn't match it
+bool loadIcoImageFromExe(QIODevice* inputDevice, const PeInfo& info, QImage& image,
+                         int needWidth = 512, int needHeight = 512);
+
 bool loadIcoImage(QIODevice* inputDevice, QImage& image, int needWidth = 512,
                   int needHeight = 512);
 bool loadIcoImage(const QString& inputFileName, QImage& image, int needWidth = 512,
                   int needHeight = 512);
 bool loadIcoImage(QImageReader& reader, QImage& image, int needWidth, int needHeight);
 
+// decodes only the image of the .ico file that is closest to the requested size
+bool loadIcoImageFromData(const QByteArray& icoData, QImage& image, int needWidth = 512,
+                          int needHeight = 512);
+
 }  // namespace IcoUtils
 
 #endif  // ICO_UTILS_H
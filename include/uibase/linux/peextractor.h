@@ -7,17 +7,85 @@
 
 #include "dllimport.h"
 #include "petypes.h"
-#include <QDataStream>
+#include <QByteArray>
+#include <QList>
 #include <QMap>
+#include <QString>
 #include <QVector>
 #include <optional>
+#include <span>
 
-class QDataStream;
+class QFile;
 class QIODevice;
 
+/**
+ * @brief The contents of a device, memory mapped if it is a file and read into memory
+ * otherwise.
+ */
+class QDLLEXPORT PeDeviceData
+{
+public:
+  explicit PeDeviceData(QIODevice* device);
+  ~PeDeviceData();
+
+  PeDeviceData(const PeDeviceData&)            = delete;
+  PeDeviceData& operator=(const PeDeviceData&) = delete;
+
+  std::span<const uchar> bytes() const { return m_bytes; }
+
+private:
+  QFile* m_file   = nullptr;
+  uchar* m_mapped = nullptr;
+  QByteArray m_data;
+  std::span<const uchar> m_bytes;
+};
+
 class QDLLEXPORT PeExtractor
 {
 public:
+  struct IconImage
+  {
+    peTypes::RtGroupIconDirectoryEntry entry;
+
+    // the image, points into the data given to the extractor
+    std::span<const uchar> data;
+  };
+
+  /**
+   * @brief Parses the headers and resource tree of the PE file in the given data.
+   * @param data Contents of the file, must outlive the extractor.
+   */
+  explicit PeExtractor(std::span<const uchar> data);
+
+  /**
+   * @return True if the data is a PE file with a resource tree that could be read.
+   */
+  bool isValid() const { return m_valid; }
+
+  /**
+   * @return The images of the primary icon group, empty if the file has no icon or it
+   * could not be read.
+   */
+  QList<IconImage> primaryIcon() const;
+
+  /**
+   * @return The primary icon group as the contents of an .ico file, empty if the file
+   * has no icon or it could not be read.
+   */
+  QByteArray primaryIconFile() const;
+
+  /**
+   * @return The file version as `a.b.c.d`, nothing if the file has no version
+   * resource.
+   */
+  std::optional<QString> fileVersion() const { return m_fileVersion; }
+
+  /**
+   * @return The product version as `a.b.c.d`, nothing if the file has no version
+   * resource.
+   */
+  std::optional<QString> productVersion() const { return m_productVersion; }
+
   /**
    * @brief Extracts the primary icon contained in the provided PE file.
    * @param inputDevice Input device to read from.
@@ -50,19 +118,16 @@ public:
   static bool loadVersionData(const QString& exeFile, QIODevice* outputDevice);
 
 private:
-  explicit PeExtractor(QIODevice* inputDevice, QIODevice* outputDevice);
+  std::span<const uchar> m_data;
+  bool m_valid = false;
 
   QVector<peTypes::PeSection> m_sections;
-  QIODevice* m_inputDevice  = nullptr;
-  QIODevice* m_outputDevice = nullptr;
-  QDataStream m_inputStream;
-  peTypes::DosHeader m_dosHeader{};
-
   QMap<quint32, peTypes::PeResourceDataEntry> m_iconResources;
   std::optional<peTypes::PeResourceDataEntry> m_primaryIconGroupResource;
-  std::optional<peTypes::PeResourceDataEntry> m_versionResource;
+  std::optional<QString> m_fileVersion;
+  std::optional<QString> m_productVersion;
 
   bool readPeData();
-  bool readIcon();
-  bool readVersionInfo() const;
+  void readVersionInfo(const peTypes::PeResourceDataEntry& resource);
+  std::span<const uchar> resourceData(const peTypes::PeResourceDataEntry& entry) const;
 };
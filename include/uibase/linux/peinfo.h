@@ -0,0 +1,84 @@
+#pragma once
+
+#include "dllimport.h"
+#include "petypes.h"
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+
+/**
+ * @brief Metadata of a PE file that is read in a single pass: the file and product
+ * versions and the directory of the primary icon group.
+ */
+class QDLLEXPORT PeInfo
+{
+public:
+  /**
+   * @brief An image of the primary icon group, only its location in the file is kept.
+   */
+  struct IconImage
+  {
+    peTypes::RtGroupIconDirectoryEntry entry;
+    quint64 offset;
+    quint32 size;
+  };
+
+  PeInfo() = default;
+
+  /**
+   * @brief Parses the given file, without going through the cache.
+   */
+  static PeInfo read(const QString& exeFile);
+
+  /**
+   * @brief Parses the PE file in the given device.
+   */
+  static PeInfo read(QIODevice* inputDevice);
+
+  /**
+   * @brief Returns the metadata of the given file, the file is only parsed if it is not
+   * in the cache or its size or modification time have changed since.
+   */
+  static PeInfo cached(const QString& exeFile);
+
+  /**
+   * @brief Returns the metadata of all the given files, in the same order. Files that
+   * are not cached are parsed in parallel, this blocks until all of them are done.
+   */
+  static QList<PeInfo> cached(const QStringList& exeFiles);
+
+  /**
+   * @brief Removes all entries from the cache.
+   */
+  static void clearCache();
+
+  /**
+   * @brief Whether the file is a PE file, false if it could not be read.
+   */
+  bool isValid() const { return m_valid; }
+
+  /**
+   * @brief The file version as `a.b.c.d`, empty if the file has no version resource.
+   */
+  const QString& fileVersion() const { return m_fileVersion; }
+
+  /**
+   * @brief The product version as `a.b.c.d`, empty if the file has no version
+   * resource.
+   */
+  const QString& productVersion() const { return m_productVersion; }
+
+  /**
+   * @brief The images of the primary icon group, empty if the file has no icon. The
+   * images themselves are read from the file when one is needed.
+   */
+  const QList<IconImage>& icons() const { return m_icons; }
+
+private:
+  bool m_valid = false;
+  QString m_fileVersion;
+  QString m_productVersion;
+  QList<IconImage> m_icons;
+};
@@ -4,9 +4,9 @@
 #include "../dllimport.h"
 #include <QMutexLocker>
 #include <QObject>
-#include <QTime>
 #include <QTimer>
-#include <map>
+#include <array>
+#include <atomic>
 
 namespace MOBase
 {
@@ -29,10 +29,50 @@ public slots:
   bool tryCreateTaskbar();
 
 private:
+  // progress of one task, written by the task without locking
+  struct Slot
+  {
+    // id of the task using the slot, 0 if free
+    std::atomic<quint32> id{0};
+    std::atomic<int> percent{0};
+
+    // steady clock time of the last update in milliseconds
+    std::atomic<qint64> updated{0};
+  };
+
+  // what was last sent, nothing is sent while it does not change
+  struct Published
+  {
+    bool visible;
+    quint64 count;
+    int percent;
+
+    bool operator==(const Published&) const = default;
+  };
+
   TaskProgressManager();
+
+  // returns the slot used by the given task, null if it has none
+  Slot* findSlot(quint32 id);
+
+  // takes the first free slot for the given task, null if all are used
+  Slot* claimSlot(quint32 id);
+
+  void schedulePublish();
   void showProgress();
 
-  std::map<quint32, std::pair<QTime, qint64>> m_Percentages;
+  // a task takes any free slot on its first update and keeps it until it is done
+  // or stops reporting, tasks beyond this many at the same time are not shown
+  // until a slot is freed
+  std::array<Slot, 64> m_Slots;
+
+  // set by updates, cleared when the progress is published
+  std::atomic<bool> m_Dirty;
+
+  // publishes the progress at most a few times per second
+  QTimer m_PublishTimer;
+  Published m_Published;
+
   QMutex m_Mutex;
   quint32 m_NextId;
   QTimer m_CreateTimer;
@@ -1,10 +1,20 @@
 #pragma once
 
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
 #include <QString>
 #include <QStringList>
 #include <QTextStream>
+#include <algorithm>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 // modified version of https://github.com/mcmtroffaes/inipp
@@ -55,6 +65,639 @@ public:
   }
 };
 
+namespace detail
+{
+
+inline char ascii_lower(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline bool ascii_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline QByteArrayView ascii_trimmed(QByteArrayView s)
+{
+  qsizetype begin = 0, end = s.size();
+  while (begin < end && ascii_space(s[begin]))
+    ++begin;
+  while (end > begin && ascii_space(s[end - 1]))
+    --end;
+  return s.sliced(begin, end - begin);
+}
+
+inline bool iequals(QByteArrayView a, QByteArrayView b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (qsizetype i = 0; i < a.size(); ++i)
+    if (ascii_lower(a[i]) != ascii_lower(b[i]))
+      return false;
+  return true;
+}
+
+// FNV-1a over the lowercased bytes
+inline std::uint32_t ihash(QByteArrayView s, std::uint32_t basis)
+{
+  std::uint32_t h = basis;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(ascii_lower(c));
+    h *= 16777619u;
+  }
+  return h;
+}
+
+inline std::uint32_t ihash(QByteArrayView name)
+{
+  return ihash(name, 2166136261u);
+}
+
+// keys are hashed together with the index of their section
+inline std::uint32_t ihash_key(QByteArrayView key, std::uint32_t section)
+{
+  return ihash(key, 2166136261u ^ (section * 0x9e3779b9u));
+}
+
+// open addressing table from hashes to indices, the caller resolves collisions
+class HashIndex
+{
+public:
+  static constexpr std::uint32_t npos = 0xffffffffu;
+
+  template <class Equal>
+  std::uint32_t find(std::uint32_t hash, Equal&& equal) const
+  {
+    if (m_slots.empty())
+      return npos;
+    const std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+      const Slot& slot = m_slots[i];
+      if (slot.index == npos)
+        return npos;
+      if (slot.hash == hash && equal(slot.index))
+        return slot.index;
+    }
+  }
+
+  void insert(std::uint32_t hash, std::uint32_t index)
+  {
+    if ((m_size + 1) * 2 > m_slots.size())
+      rehash(std::max<std::size_t>(16, m_slots.size() * 2));
+    place(hash, index);
+    ++m_size;
+  }
+
+  // replaces every stored index by remap[index]
+  void remap(const std::vector<std::uint32_t>& remap)
+  {
+    for (Slot& slot : m_slots)
+      if (slot.index != npos)
+        slot.index = remap[slot.index];
+  }
+
+private:
+  struct Slot
+  {
+    std::uint32_t hash  = 0;
+    std::uint32_t index = npos;
+  };
+
+  std::vector<Slot> m_slots;
+  std::size_t m_size = 0;
+
+  void place(std::uint32_t hash, std::uint32_t index)
+  {
+    const std::size_t mask = m_slots.size() - 1;
+    std::size_t i          = hash & mask;
+    while (m_slots[i].index != npos)
+      i = (i + 1) & mask;
+    m_slots[i] = {hash, index};
+  }
+
+  void rehash(std::size_t capacity)
+  {
+    std::vector<Slot> old = std::exchange(m_slots, std::vector<Slot>(capacity));
+    for (const Slot& slot : old)
+      if (slot.index != npos)
+        place(slot.hash, slot.index);
+  }
+};
+
+// reads the lines of an ini file in a UTF-8 buffer and calls
+//   on_section(name, raw) for section headers,
+//   on_entry(key, value, raw, line) for "key=value" lines and
+//   on_error(line) for lines that are neither,
+// where raw is the whole line including the line break and line is trimmed;
+// blank lines and comments are skipped
+template <class OnSection, class OnEntry, class OnError>
+void scan_lines(QByteArrayView data, const Format& format, OnSection&& on_section,
+                OnEntry&& on_entry, OnError&& on_error)
+{
+  const char assign = format.char_assign.toLatin1();
+
+  const auto is = [](auto pred, char c) {
+    return static_cast<unsigned char>(c) < 0x80 && pred(QChar::fromLatin1(c));
+  };
+
+  QByteArrayView rest(data);
+  if (rest.startsWith("\xef\xbb\xbf"))
+    rest = rest.sliced(3);
+
+  while (!rest.isEmpty()) {
+    const qsizetype eol       = rest.indexOf('\n');
+    const QByteArrayView raw  = eol == -1 ? rest : rest.first(eol + 1);
+    const QByteArrayView line = ascii_trimmed(raw);
+    rest                      = rest.sliced(raw.size());
+
+    if (line.isEmpty())
+      continue;
+
+    const char front = line.front();
+
+    if (is([&](QChar c) { return format.is_comment(c); }, front))
+      continue;
+
+    if (is([&](QChar c) { return format.is_section_start(c); }, front)) {
+      if (line.size() >= 2 &&
+          is([&](QChar c) { return format.is_section_end(c); }, line.back()))
+        on_section(line.sliced(1, line.size() - 2), raw);
+      else
+        on_error(line);
+      continue;
+    }
+
+    const qsizetype pos = line.indexOf(assign);
+    if (pos <= 0) {
+      on_error(line);
+      continue;
+    }
+
+    on_entry(ascii_trimmed(line.first(pos)), ascii_trimmed(line.sliced(pos + 1)), raw,
+             line);
+  }
+}
+
+}  // namespace detail
+
+// flat, read-only view of an ini file in a UTF-8 buffer, built in a single pass
+//
+// sections are kept in the order they first appear in and the entries of a
+// section are contiguous, even if the section shows up more than once in the
+// file; keys and values are views into the buffer, which is owned (and
+// implicitly shared) by the table
+//
+// lookups are case-insensitive for ASCII, like the Windows profile API
+class Table
+{
+public:
+  struct Entry
+  {
+    QByteArrayView key;
+    QByteArrayView value;
+
+    // the whole line, including the line break
+    QByteArrayView line;
+  };
+
+  struct Section
+  {
+    QByteArrayView name;
+
+    // range in entries()
+    std::size_t first = 0;
+    std::size_t count = 0;
+
+    // first header line including the line break, empty for the unnamed section
+    QByteArrayView header;
+  };
+
+  // part of the file that belongs to a section, from a header line up to the
+  // next one; a section has one block for every time it appears in the file
+  struct Block
+  {
+    std::uint32_t section;
+    QByteArrayView text;
+  };
+
+  Table() = default;
+
+  explicit Table(QByteArray data, const Format& format = Format())
+  {
+    parse(std::move(data), format);
+  }
+
+  void parse(QByteArray data, const Format& format = Format())
+  {
+    m_data = std::move(data);
+    m_sections.clear();
+    m_entries.clear();
+    m_errors.clear();
+    m_blocks.clear();
+    m_section_index = {};
+    m_entry_index   = {};
+
+    // entries in file order with the index of their section, they are grouped
+    // by section once everything has been read
+    struct Pending
+    {
+      Entry entry;
+      std::uint32_t section;
+    };
+    std::vector<Pending> pending;
+
+    // the unnamed section starts at the top of the file, after the BOM
+    const bool bom          = QByteArrayView(m_data).startsWith("\xef\xbb\xbf");
+    std::uint32_t current   = detail::HashIndex::npos;
+    const char* block_begin = m_data.constData() + (bom ? 3 : 0);
+
+    const auto end_block = [&](const char* end) {
+      if (current != detail::HashIndex::npos)
+        m_blocks.push_back({current, QByteArrayView(block_begin, end)});
+    };
+
+    const auto on_section = [&](QByteArrayView name, QByteArrayView raw) {
+      end_block(raw.data());
+      block_begin = raw.data();
+      current     = add_section(name, raw);
+    };
+
+    const auto on_entry = [&](QByteArrayView key, QByteArrayView value,
+                              QByteArrayView raw, QByteArrayView line) {
+      // entries before the first section header go to the unnamed section
+      if (current == detail::HashIndex::npos)
+        current = add_section(QByteArrayView(""), QByteArrayView());
+
+      // the first occurrence of a key wins
+      const std::uint32_t hash = detail::ihash_key(key, current);
+      const auto found = m_entry_index.find(hash, [&](std::uint32_t i) {
+        return pending[i].section == current &&
+               detail::iequals(pending[i].entry.key, key);
+      });
+
+      if (found != detail::HashIndex::npos) {
+        m_errors.push_back(QString::fromUtf8(line));
+        return;
+      }
+
+      m_entry_index.insert(hash, static_cast<std::uint32_t>(pending.size()));
+      pending.push_back({{key, value, raw}, current});
+    };
+
+    const auto on_error = [&](QByteArrayView line) {
+      m_errors.push_back(QString::fromUtf8(line));
+    };
+
+    detail::scan_lines(m_data, format, on_section, on_entry, on_error);
+    end_block(m_data.constData() + m_data.size());
+
+    // stable grouping by section, counting sort
+    for (const Pending& p : pending)
+      ++m_sections[p.section].count;
+
+    std::size_t offset = 0;
+    for (Section& sec : m_sections) {
+      sec.first = offset;
+      offset += sec.count;
+    }
+
+    std::vector<std::size_t> next(m_sections.size());
+    for (std::size_t i = 0; i < m_sections.size(); ++i)
+      next[i] = m_sections[i].first;
+
+    std::vector<std::uint32_t> remap(pending.size());
+    m_entries.resize(pending.size());
+
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+      const std::size_t to = next[pending[i].section]++;
+      m_entries[to]        = pending[i].entry;
+      remap[i]             = static_cast<std::uint32_t>(to);
+    }
+
+    m_entry_index.remap(remap);
+  }
+
+  const QByteArray& data() const { return m_data; }
+
+  std::span<const Section> sections() const { return m_sections; }
+
+  std::span<const Entry> entries() const { return m_entries; }
+
+  std::span<const Entry> entries(const Section& sec) const
+  {
+    return entries().subspan(sec.first, sec.count);
+  }
+
+  std::span<const Block> blocks() const { return m_blocks; }
+
+  // lines that could not be parsed and duplicate keys
+  const QStringList& errors() const { return m_errors; }
+
+  const Section* find_section(QByteArrayView name) const
+  {
+    const auto i = find_section_index(name);
+    return i == detail::HashIndex::npos ? nullptr : &m_sections[i];
+  }
+
+  const Entry* find(QByteArrayView section, QByteArrayView key) const
+  {
+    const auto sec = find_section_index(section);
+    if (sec == detail::HashIndex::npos)
+      return nullptr;
+
+    const Section& s = m_sections[sec];
+    const auto found =
+        m_entry_index.find(detail::ihash_key(key, sec), [&](std::uint32_t i) {
+          return i >= s.first && i < s.first + s.count &&
+                 detail::iequals(m_entries[i].key, key);
+        });
+
+    return found == detail::HashIndex::npos ? nullptr : &m_entries[found];
+  }
+
+private:
+  QByteArray m_data;
+  std::vector<Section> m_sections;
+  std::vector<Entry> m_entries;
+  QStringList m_errors;
+  std::vector<Block> m_blocks;
+  detail::HashIndex m_section_index;
+  detail::HashIndex m_entry_index;
+
+  std::uint32_t find_section_index(QByteArrayView name) const
+  {
+    return m_section_index.find(detail::ihash(name), [&](std::uint32_t i) {
+      return detail::iequals(m_sections[i].name, name);
+    });
+  }
+
+  std::uint32_t add_section(QByteArrayView name, QByteArrayView header)
+  {
+    const auto found = find_section_index(name);
+    if (found != detail::HashIndex::npos)
+      return found;
+
+    const auto index = static_cast<std::uint32_t>(m_sections.size());
+    m_sections.push_back({name, 0, 0, header});
+    m_section_index.insert(detail::ihash(name), index);
+    return index;
+  }
+};
+
+// edits an ini file by patching its text, everything that is not changed is
+// written back exactly as it was, including comments, blank lines and the
+// order of sections and keys
+//
+// sections and keys are matched case-insensitively, new keys are added after
+// the last key of their section and new sections at the end of the file
+class Editor
+{
+public:
+  explicit Editor(QByteArray data, const Format& format = Format())
+      : m_table(std::move(data), format),
+        m_assign(format.char_assign.toLatin1()),
+        m_section_start(format.char_section_start.toLatin1()),
+        m_section_end(format.char_section_end.toLatin1()),
+        m_entry_edits(m_table.entries().size()),
+        m_removed_sections(m_table.sections().size(), false)
+  {}
+
+  // the file as it was read
+  const Table& table() const { return m_table; }
+
+  bool modified() const { return m_modified; }
+
+  void set(QByteArrayView section, QByteArrayView key, QByteArrayView value)
+  {
+    m_modified = true;
+
+    const auto sec = live_section(section);
+
+    if (sec != detail::HashIndex::npos) {
+      if (const auto* entry = m_table.find(section, key)) {
+        auto& edit   = m_entry_edits[entry - m_table.entries().data()];
+        edit.removed = false;
+        edit.value   = QByteArray(value.data(), value.size());
+        return;
+      }
+    }
+
+    auto& added = added_section(section, sec);
+    for (auto& [k, v] : added.entries) {
+      if (detail::iequals(k, key)) {
+        v = QByteArray(value.data(), value.size());
+        return;
+      }
+    }
+
+    added.entries.emplace_back(QByteArray(key.data(), key.size()),
+                               QByteArray(value.data(), value.size()));
+  }
+
+  void remove(QByteArrayView section, QByteArrayView key)
+  {
+    m_modified = true;
+
+    if (live_section(section) != detail::HashIndex::npos) {
+      if (const auto* entry = m_table.find(section, key))
+        m_entry_edits[entry - m_table.entries().data()].removed = true;
+    }
+
+    for (auto& added : m_added) {
+      if (detail::iequals(added.name, section))
+        std::erase_if(added.entries,
+                      [&](const auto& e) { return detail::iequals(e.first, key); });
+    }
+  }
+
+  void remove_section(QByteArrayView section)
+  {
+    m_modified = true;
+
+    if (const auto* sec = m_table.find_section(section))
+      m_removed_sections[sec - m_table.sections().data()] = true;
+
+    std::erase_if(m_added,
+                  [&](const Added& a) { return detail::iequals(a.name, section); });
+  }
+
+  // writes the unchanged parts of the original text and the patches
+  bool write(QIODevice* out) const
+  {
+    bool ok = true;
+    apply([&](QByteArrayView text) {
+      if (ok && !text.isEmpty())
+        ok = out->write(text.data(), text.size()) == text.size();
+    });
+    return ok;
+  }
+
+  QByteArray result() const
+  {
+    QByteArray out;
+    out.reserve(m_table.data().size());
+    apply([&](QByteArrayView text) { out.append(text); });
+    return out;
+  }
+
+private:
+  struct EntryEdit
+  {
+    bool removed = false;
+    std::optional<QByteArray> value;
+  };
+
+  struct Added
+  {
+    QByteArray name;
+
+    // index of the section in the table, npos for new sections
+    std::uint32_t section;
+
+    std::vector<std::pair<QByteArray, QByteArray>> entries;
+  };
+
+  struct Patch
+  {
+    qsizetype begin;
+    qsizetype end;
+    QByteArray text;
+  };
+
+  Table m_table;
+  char m_assign;
+  char m_section_start;
+  char m_section_end;
+  std::vector<EntryEdit> m_entry_edits;
+  std::vector<bool> m_removed_sections;
+  std::vector<Added> m_added;
+  bool m_modified = false;
+
+  // index of the section in the table if it exists and was not removed
+  std::uint32_t live_section(QByteArrayView name) const
+  {
+    const auto* sec = m_table.find_section(name);
+    if (sec == nullptr)
+      return detail::HashIndex::npos;
+
+    const auto index = static_cast<std::uint32_t>(sec - m_table.sections().data());
+    return m_removed_sections[index] ? detail::HashIndex::npos : index;
+  }
+
+  Added& added_section(QByteArrayView name, std::uint32_t section)
+  {
+    for (auto& added : m_added) {
+      if (added.section == section && detail::iequals(added.name, name))
+        return added;
+    }
+
+    return m_added.emplace_back(
+        Added{QByteArray(name.data(), name.size()), section, {}});
+  }
+
+  // the one the file already uses, the platform's for new files
+  QByteArray line_break() const
+  {
+    if (m_table.data().contains("\r\n"))
+      return "\r\n";
+    if (m_table.data().contains('\n'))
+      return "\n";
+#ifdef _WIN32
+    return "\r\n";
+#else
+    return "\n";
+#endif
+  }
+
+  QByteArray lines(const Added& added, const QByteArray& eol) const
+  {
+    QByteArray text;
+    for (const auto& [key, value] : added.entries)
+      text += key + m_assign + value + eol;
+    return text;
+  }
+
+  template <class Sink>
+  void apply(Sink&& sink) const
+  {
+    const QByteArrayView data(m_table.data());
+    const auto offset = [&](QByteArrayView v) { return v.data() - data.data(); };
+    const QByteArray eol = line_break();
+
+    // inserting after a last line that has no line break
+    const auto separated = [&](qsizetype at, QByteArray text) {
+      if (at > 0 && data[at - 1] != '\n')
+        text.prepend(eol);
+      return text;
+    };
+
+    std::vector<Patch> patches;
+
+    for (const auto& block : m_table.blocks()) {
+      if (m_removed_sections[block.section])
+        patches.push_back({offset(block.text), offset(block.text) + block.text.size(),
+                           {}});
+    }
+
+    for (std::size_t i = 0; i < m_table.sections().size(); ++i) {
+      if (m_removed_sections[i])
+        continue;
+
+      const auto& sec = m_table.sections()[i];
+      for (std::size_t j = sec.first; j < sec.first + sec.count; ++j) {
+        const auto& entry = m_table.entries()[j];
+        const auto& edit  = m_entry_edits[j];
+
+        if (edit.removed)
+          patches.push_back({offset(entry.line),
+                             offset(entry.line) + entry.line.size(), {}});
+        else if (edit.value)
+          patches.push_back({offset(entry.value),
+                             offset(entry.value) + entry.value.size(), *edit.value});
+      }
+    }
+
+    QByteArray appended;
+
+    for (const auto& added : m_added) {
+      if (added.entries.empty())
+        continue;
+
+      if (added.section != detail::HashIndex::npos) {
+        // after the last key of the section, or its header if it has none
+        const auto& sec = m_table.sections()[added.section];
+        const QByteArrayView last =
+            sec.count > 0 ? m_table.entries()[sec.first + sec.count - 1].line
+                          : sec.header;
+        const qsizetype at = offset(last) + last.size();
+
+        patches.push_back({at, at, separated(at, lines(added, eol))});
+      } else {
+        appended += m_section_start + added.name + m_section_end + eol +
+                    lines(added, eol);
+      }
+    }
+
+    if (!appended.isEmpty())
+      patches.push_back(
+          {data.size(), data.size(), separated(data.size(), std::move(appended))});
+
+    std::stable_sort(patches.begin(), patches.end(),
+                     [](const Patch& a, const Patch& b) { return a.begin < b.begin; });
+
+    qsizetype pos = 0;
+    for (const auto& patch : patches) {
+      if (patch.begin > pos)
+        sink(data.sliced(pos, patch.begin - pos));
+      sink(QByteArrayView(patch.text));
+      pos = std::max(pos, patch.end);
+    }
+
+    sink(data.sliced(pos));
+  }
+};
+
 class Ini
 {
 public:
@@ -65,6 +708,8 @@ public:
   QStringList errors;
   std::shared_ptr<Format> format;
 
+  // no longer used, interpolate() detects circular references instead of
+  // giving up after a number of passes
   static constexpr int max_interpolation_depth = 10;
 
   Ini() : format(std::make_shared<Format>()) {}
@@ -81,57 +726,52 @@ public:
     }
   }
 
-  void parse(QTextStream& is)
+  void parse(QTextStream& is) { parse(is.readAll().toUtf8()); }
+
+  // same line rules as Table, but section and key names are case sensitive like
+  // they have always been for Ini: "[General]" and "[general]" are different
+  // sections, and sections only exist once they have a key
+  void parse(const QByteArray& data)
   {
-    QString line;
     QString section;
-    while (is.readLineInto(&line)) {
-      line              = line.trimmed();
-      const auto length = line.length();
-      if (length > 0) {
-        const auto pos    = line.indexOf(format->char_assign);
-        const auto& front = line.front();
-        if (format->is_comment(front)) {
-          continue;
-        }
 
-        if (format->is_section_start(front)) {
-          if (format->is_section_end(line.back()))
-            section = line.sliced(1, length - 2);
-          else
-            errors.push_back(line);
-        } else if (pos != 0 && pos != -1) {
-          QString variable = line.first(pos);
-          QString value    = line.sliced(pos + 1);
-          variable         = variable.trimmed();
-          value            = value.trimmed();
-
-          auto& sec = sections[section];
-          if (!sec.contains(variable))
-            sec.emplace(variable, value);
-          else
-            errors.push_back(line);
-        } else {
-          errors.push_back(line);
-        }
-      }
-    }
+    detail::scan_lines(
+        data, *format,
+        [&](QByteArrayView name, QByteArrayView) {
+          section = QString::fromUtf8(name);
+        },
+        [&](QByteArrayView key, QByteArrayView value, QByteArrayView,
+            QByteArrayView line) {
+          // the first occurrence of a key wins
+          if (!sections[section]
+                   .try_emplace(QString::fromUtf8(key), QString::fromUtf8(value))
+                   .second)
+            errors.push_back(QString::fromUtf8(line));
+        },
+        [&](QByteArrayView line) {
+          errors.push_back(QString::fromUtf8(line));
+        });
   }
 
+  // replaces "${variable}" by the value of variable in the same section and
+  // "${section:variable}" by the value in the given section
+  //
+  // every value is scanned once and resolved at most once, references that
+  // cannot be resolved and circular references are left as they are and
+  // reported in errors
   void interpolate()
   {
-    int global_iteration = 0;
-    auto changed         = false;
-    // replace each "${variable}" by "${section:variable}"
-    for (auto& sec : sections)
-      replace_symbols(local_symbols(sec.first, sec.second), sec.second);
-    // replace each "${section:variable}" by its value
-    do {
-      changed         = false;
-      const auto syms = global_symbols();
-      for (auto& section : sections | std::views::values)
-        changed |= replace_symbols(syms, section);
-    } while (changed && (max_interpolation_depth > global_iteration++));
+    std::vector<Node> nodes;
+    std::unordered_map<const QString*, std::size_t> ids;
+
+    for (auto& [name, section] : sections)
+      for (auto& [key, value] : section) {
+        ids.emplace(&value, nodes.size());
+        nodes.push_back({&name, &key, &section, &value, NodeState::Pending});
+      }
+
+    for (std::size_t id = 0; id < nodes.size(); ++id)
+      resolve(nodes, ids, id);
   }
 
   void default_section(const Section& sec)
@@ -160,35 +800,128 @@ public:
   }
 
 private:
-  using Symbols = std::vector<std::pair<QString, QString>>;
+  enum class NodeState
+  {
+    Pending,
+    Resolving,
+    Done
+  };
 
-  Symbols local_symbols(const QString& sec_name, const Section& sec) const
+  struct Node
   {
-    Symbols result;
-    for (const auto& symbol : sec | std::views::keys)
-      result.emplace_back(format->local_symbol(symbol),
-                          format->global_symbol(sec_name, symbol));
-    return result;
-  }
+    const QString* section_name;
+    const QString* key;
+    const Section* section;
+    QString* value;
+    NodeState state;
+  };
 
-  Symbols global_symbols() const
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  std::size_t
+  find_reference(const Node& node, const QString& name,
+                 const std::unordered_map<const QString*, std::size_t>& ids) const
   {
-    Symbols result;
-    for (const auto& sec : sections)
-      for (const auto& val : sec.second)
-        result.emplace_back(format->global_symbol(sec.first, val.first), val.second);
-    return result;
+    // local variables first, that is what "${name}" refers to when the section
+    // has such a key
+    if (auto it = node.section->find(name); it != node.section->end())
+      return ids.at(&it->second);
+
+    const auto sep = name.indexOf(format->char_interpol_sep);
+    if (sep == -1)
+      return npos;
+
+    const auto sec = sections.find(name.first(sep));
+    if (sec == sections.end())
+      return npos;
+
+    const auto it = sec->second.find(name.sliced(sep + 1));
+    if (it == sec->second.end())
+      return npos;
+
+    return ids.at(&it->second);
   }
 
-  static bool replace_symbols(const Symbols& syms, Section& sec)
+  // resolves the references of a value depth first, with an explicit stack so a
+  // long chain of references in the file cannot overflow the call stack
+  void resolve(std::vector<Node>& nodes,
+               const std::unordered_map<const QString*, std::size_t>& ids,
+               std::size_t id)
   {
-    auto changed = false;
-    for (auto& sym : syms)
-      for (auto& string : sec | std::views::values) {
-        changed |= string.contains(sym.first);
-        string.replace(sym.first, sym.second);
+    if (nodes[id].state != NodeState::Pending)
+      return;
+
+    struct Frame
+    {
+      std::size_t id;
+      QString source;
+      QString result;
+      qsizetype pos;
+    };
+
+    const QString start = QString(format->char_interpol) + format->char_interpol_start;
+
+    std::vector<Frame> stack;
+    nodes[id].state = NodeState::Resolving;
+    stack.push_back({id, *nodes[id].value, {}, 0});
+
+    while (!stack.empty()) {
+      Frame& frame     = stack.back();
+      const Node& node = nodes[frame.id];
+
+      // a reference that must be resolved before going on with this value
+      std::size_t pending = npos;
+
+      for (;;) {
+        const auto begin = frame.source.indexOf(start, frame.pos);
+        if (begin == -1)
+          break;
+
+        const auto end = frame.source.indexOf(format->char_interpol_end, begin + 2);
+        if (end == -1)
+          break;
+
+        const QString name       = frame.source.sliced(begin + 2, end - begin - 2);
+        const std::size_t target = find_reference(node, name, ids);
+
+        if (target != npos && nodes[target].state == NodeState::Pending) {
+          // this reference is looked at again once the target is done
+          pending = target;
+          break;
+        }
+
+        const QString token = frame.source.sliced(begin, end + 1 - begin);
+
+        frame.result += QStringView(frame.source).sliced(frame.pos, begin - frame.pos);
+        frame.pos = end + 1;
+
+        if (target == npos) {
+          errors.push_back(QString("unresolved reference %1 in [%2] %3")
+                               .arg(token, *node.section_name, *node.key));
+          frame.result += token;
+        } else if (nodes[target].state == NodeState::Resolving) {
+          errors.push_back(QString("circular reference %1 in [%2] %3")
+                               .arg(token, *node.section_name, *node.key));
+          frame.result += token;
+        } else {
+          frame.result += *nodes[target].value;
+        }
+      }
+
+      if (pending != npos) {
+        // invalidates `frame`
+        nodes[pending].state = NodeState::Resolving;
+        stack.push_back({pending, *nodes[pending].value, {}, 0});
+        continue;
       }
-    return changed;
+
+      frame.result += QStringView(frame.source).sliced(frame.pos);
+
+      Node& done  = nodes[frame.id];
+      done.state  = NodeState::Done;
+      *done.value = std::move(frame.result);
+      stack.pop_back();
+    }
   }
 };
 
@@ -63,6 +63,17 @@ public:
   static void setCallbacks(GetButton get, SetWindowButton setWindow,
                            SetFileButton setFile);
 
+  // remembers the choices in the given ini file instead of going through the
+  // callbacks; the file is read once and changes are written to it shortly after
+  // they're made, an empty name goes back to the callbacks
+  //
+  static void setStorageFile(const QString& fileName);
+
+  // writes the choices that haven't been written yet, this is done after a choice
+  // is made in a dialog and when the application quits
+  //
+  static void flushMemory();
+
   static Button
   query(QWidget* parent, const QString& windowName, const QString& title,
         const QString& text,
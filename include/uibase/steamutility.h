@@ -23,7 +23,21 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "dllimport.h"
 #include <QDir>
+#include <QList>
 #include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <optional>
+
+#ifdef __unix__
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#endif
 
 namespace MOBase
 {
@@ -56,6 +70,91 @@ QDLLEXPORT QString findSteamGame(const QString& appName, const QString& validFil
  */
 QDLLEXPORT QString appIdByGamePath(const QString& gameLocation);
 
+/**
+ * @brief The libraries, installed apps and compatibility tool mappings of a Steam
+ * installation.
+ * @details `libraryfolders.vdf`, the app manifests of every library and
+ * `config/config.vdf` are parsed on first use and only parsed again once their
+ * modification time changes. Files are checked for changes at most once per second,
+ * invalidate() forces a check on the next query.
+ *
+ * All functions can be called from any thread.
+ */
+class QDLLEXPORT SteamInstallationCache
+{
+public:
+  struct App
+  {
+    QString appID;
+    QString name;
+
+    // absolute path of the `steamapps` folder of the library the app is in
+    QString steamApps;
+
+    // name of the directory in `steamapps/common`
+    QString installDir;
+
+    // installed beta branch, empty for the default branch
+    QString branch;
+
+    // absolute path of the installation
+    QString path() const { return steamApps + "/common/" + installDir; }
+  };
+
+  /**
+   * @param steamPath Steam installation directory
+   */
+  explicit SteamInstallationCache(const QString& steamPath);
+  ~SteamInstallationCache();
+
+  SteamInstallationCache(const SteamInstallationCache&)            = delete;
+  SteamInstallationCache& operator=(const SteamInstallationCache&) = delete;
+
+  /**
+   * @brief The cache for the installation returned by findSteamCached().
+   */
+  static SteamInstallationCache& instance();
+
+  /**
+   * @brief Absolute paths of the Steam libraries, the Steam installation first.
+   */
+  QStringList libraries() const;
+
+  /**
+   * @brief All installed apps, in library order.
+   */
+  QList<App> apps() const;
+
+  /**
+   * @brief The installed app with the given id, if any.
+   */
+  std::optional<App> app(const QString& appID) const;
+
+  /**
+   * @brief Reads `<gameLocation>/../../appmanifest_<appID>.acf` directly, for games
+   * installed in a library that is not known to the cache.
+   */
+  static std::optional<App> appManifest(const QString& gameLocation,
+                                        const QString& appID);
+
+  /**
+   * @brief Name of the compatibility tool Steam runs the given app with, the default
+   * tool if the app has no explicit mapping, empty if there is none.
+   */
+  QString compatTool(const QString& appID) const;
+
+  /**
+   * @brief Checks all files for changes on the next query.
+   */
+  void invalidate();
+
+private:
+  struct Data;
+  std::unique_ptr<Data> m_data;
+
+  Data& fresh() const;
+};
+
 #ifdef __unix__
 // proton and linux-specific functions
 
@@ -79,6 +178,236 @@ QDLLEXPORT QString protonByPrefixPath(const QDir& prefixPath);
 QDLLEXPORT QString getRequiredLinuxRuntime(const QString& gameLocation,
                                            const QString& appID) noexcept(false);
 
+/**
+ * @brief Read-only view of a binary VDF document, as used by Steam's `appinfo.vdf`.
+ * @details Values are found by walking the raw data, nothing is copied and no tree is
+ * built. Paths are key names separated by `/`, e.g. `common/name`, and a `*` in place
+ * of a name matches any key. Subtrees that do not match are skipped without looking
+ * at their values.
+ *
+ * The data (and the string table, if any) must outlive the view and every value
+ * obtained from it.
+ */
+class QDLLEXPORT BinaryVdfView
+{
+public:
+  enum class Type : std::uint8_t
+  {
+    Document   = 0,
+    String     = 1,
+    Int        = 2,
+    Float      = 3,
+    Pointer    = 4,
+    WideString = 5,
+    Color      = 6,
+    UInt64     = 7
+  };
+
+  class QDLLEXPORT Value
+  {
+  public:
+    Type type() const { return m_type; }
+    std::string_view name() const { return m_name; }
+
+    /**
+     * @brief The raw bytes of the value, for documents this is everything from the
+     * first child on.
+     */
+    std::span<const std::uint8_t> data() const { return m_data; }
+
+    /**
+     * @brief The contents of a String value without the terminator, empty for other
+     * types.
+     */
+    std::string_view asString() const;
+
+    /**
+     * @brief Converts String and WideString values, empty for other types.
+     */
+    QString toString() const;
+
+    /**
+     * @brief Int, Pointer and Color values, 0 for other types.
+     */
+    std::int32_t asInt() const;
+
+    /**
+     * @brief Float values, 0 for other types.
+     */
+    float asFloat() const;
+
+    /**
+     * @brief UInt64 values, 0 for other types.
+     */
+    std::uint64_t asUInt64() const;
+
+    /**
+     * @brief The children of a Document value, an empty view for other types.
+     */
+    BinaryVdfView asDocument() const;
+
+  private:
+    friend class BinaryVdfView;
+
+    Value(Type type, std::string_view name, std::span<const std::uint8_t> data,
+          std::span<const std::string_view> strings)
+        : m_type(type), m_name(name), m_data(data), m_strings(strings)
+    {}
+
+    Type m_type;
+    std::string_view m_name;
+    std::span<const std::uint8_t> m_data;
+    std::span<const std::string_view> m_strings;
+  };
+
+  BinaryVdfView() = default;
+
+  /**
+   * @param data The values of a document, up to its end marker or the end of the data
+   * @param strings String table key names refer to, empty if they are stored inline
+   */
+  explicit BinaryVdfView(std::span<const std::uint8_t> data,
+                         std::span<const std::string_view> strings = {})
+      : m_data(data), m_strings(strings)
+  {}
+
+  /**
+   * @brief Calls `f` with every value matching the given path, in file order.
+   * @details `f` may return a bool, returning false stops the walk.
+   * @throws std::runtime_error if the data is malformed
+   */
+  template <class F>
+  void forEach(std::string_view path, F&& f) const noexcept(false)
+  {
+    using Callable = std::remove_reference_t<F>;
+
+    visit(
+        path,
+        [](void* context, const Value& value) {
+          auto& callable = *static_cast<Callable*>(context);
+          if constexpr (std::is_void_v<std::invoke_result_t<Callable&, const Value&>>) {
+            callable(value);
+            return true;
+          } else {
+            return static_cast<bool>(callable(value));
+          }
+        },
+        const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+  }
+
+  /**
+   * @brief The first value matching the given path, if any.
+   * @throws std::runtime_error if the data is malformed
+   */
+  std::optional<Value> find(std::string_view path) const noexcept(false);
+
+  /**
+   * @brief All values matching the given path.
+   * @throws std::runtime_error if the data is malformed
+   */
+  std::vector<Value> query(std::string_view path) const noexcept(false);
+
+private:
+  using Visitor = bool (*)(void* context, const Value& value);
+
+  std::span<const std::uint8_t> m_data;
+  std::span<const std::string_view> m_strings;
+
+  void visit(std::string_view path, Visitor visitor, void* context) const;
+};
+
+/**
+ * @brief Index of the app entries in Steam's `appcache/appinfo.vdf`.
+ * @details The file is memory mapped and the location of every app entry is collected
+ * once, lookups are then a hash lookup and only the requested entry is parsed. The
+ * index is rebuilt when the size or modification time of the file change.
+ *
+ * The index can be persisted with setCacheFile(), it is then loaded from there as long
+ * as appinfo.vdf has not changed, which skips the scan entirely.
+ */
+class QDLLEXPORT AppInfoIndex
+{
+  struct Data;
+
+public:
+  /**
+   * @brief The binary VDF document of a single app.
+   * @details Keeps the mapped file alive, the data stays valid for as long as the
+   * entry exists, even if the index is rebuilt in the meantime.
+   */
+  class QDLLEXPORT Entry
+  {
+  public:
+    Entry();
+
+    bool isValid() const { return m_data != nullptr; }
+    explicit operator bool() const { return isValid(); }
+
+    std::uint32_t appID() const { return m_appID; }
+
+    /**
+     * @brief The binary VDF document of the app.
+     */
+    std::span<const std::uint8_t> document() const { return m_document; }
+
+    /**
+     * @brief The string table that key names refer to, empty for appinfo versions
+     * older than 41, which store key names inline.
+     */
+    std::span<const std::string_view> strings() const;
+
+    /**
+     * @brief The contents of the app's root `appinfo` document, e.g. `common/name`.
+     * @throws std::runtime_error if the document is malformed
+     */
+    BinaryVdfView vdf() const noexcept(false);
+
+  private:
+    friend class AppInfoIndex;
+
+    std::shared_ptr<const Data> m_data;
+    std::uint32_t m_appID;
+    std::span<const std::uint8_t> m_document;
+  };
+
+  /**
+   * @param path Path to appinfo.vdf
+   */
+  explicit AppInfoIndex(QString path);
+  ~AppInfoIndex();
+
+  AppInfoIndex(const AppInfoIndex&)            = delete;
+  AppInfoIndex& operator=(const AppInfoIndex&) = delete;
+
+  /**
+   * @brief The index for the appinfo.vdf of the Steam installation returned by
+   * findSteamCached().
+   */
+  static AppInfoIndex& instance();
+
+  /**
+   * @brief Sets a file the index is saved to after it has been built, and loaded from
+   * if it still matches appinfo.vdf. An empty path disables persisting.
+   */
+  void setCacheFile(const QString& path);
+
+  /**
+   * @brief Gets the entry of the given app.
+   * @return The entry, or an invalid entry if the app is not in the file
+   * @throws std::runtime_error if the file cannot be read or has an unsupported
+   * version
+   */
+  Entry find(std::uint32_t appID) noexcept(false);
+
+private:
+  QString m_path;
+  QString m_cacheFile;
+  std::mutex m_mutex;
+  std::shared_ptr<const Data> m_data;
+
+  std::shared_ptr<const Data> current();
+};
+
 #endif  // __unix__
 
 }  // namespace MOBase
@@ -0,0 +1,174 @@
+#ifndef TEXTSEARCH_H
+#define TEXTSEARCH_H
+
+#include "dllimport.h"
+#include <QObject>
+#include <QString>
+#include <QStringView>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+namespace MOBase
+{
+
+/**
+ * @brief finds all the matches of a pattern in a text in the background
+ *
+ * the text is split in chunks of whole lines that are searched by a thread pool, the
+ * matches are merged in order on the gui thread as the chunks are done; literal
+ * patterns are case insensitive and their matches may overlap, regular expressions
+ * are matched line by line
+ *
+ * literal patterns in data given to setData() are compared byte by byte and only
+ * ignore the case of ascii letters, "É" does not match "é" there; regular
+ * expressions, and literal patterns in a text given to setText(), ignore the case
+ * of all letters
+ **/
+class QDLLEXPORT TextSearch : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Match
+  {
+    qint64 begin;
+    qint64 end;
+  };
+
+  explicit TextSearch(QObject* parent = nullptr);
+  ~TextSearch();
+
+  /**
+   * @brief searches the given text, offsets are in utf-16 code units
+   **/
+  void setText(QString text);
+
+  /**
+   * @brief appends to the text given to setText(), only what was appended is
+   *        searched if the previous search is complete
+   **/
+  void appendText(QStringView text);
+
+  /**
+   * @brief searches the utf-8 bytes in [begin, end) of the given data, offsets are in
+   *        bytes from the start of the data
+   *
+   * @param owner keeps the data alive while the search runs
+   **/
+  void setData(std::shared_ptr<const void> owner, const char* data, qint64 begin,
+               qint64 end);
+
+  /**
+   * @brief the data given to setData() grew to `end`, only what was appended is
+   *        searched if the previous search is complete
+   *
+   * @param owner keeps the data alive while the search runs
+   **/
+  void extendData(std::shared_ptr<const void> owner, const char* data, qint64 end);
+
+  /**
+   * @brief starts searching for the given pattern, the matches of the previous one
+   *        are dropped
+   *
+   * when a literal pattern extends the previous one, only the previous matches are
+   * checked again
+   **/
+  void setPattern(const QString& pattern, bool regex);
+
+  /**
+   * @return the end of the text or data that is searched
+   **/
+  qint64 end() const { return m_end; }
+
+  const QString& pattern() const { return m_pattern; }
+  bool isRegex() const { return m_regex; }
+
+  /**
+   * @return false if the pattern is not a valid regular expression
+   **/
+  bool isValid() const;
+
+  /**
+   * @return whether the whole text has been searched, the search stops early if there
+   *         are too many matches
+   **/
+  bool isComplete() const;
+
+  /**
+   * @return the number of matches found so far
+   **/
+  qint64 count() const;
+
+  Match at(qint64 index) const;
+
+  /**
+   * @return the index of the first match that starts at or after the offset, count()
+   *         if none has been found
+   **/
+  qint64 indexAt(qint64 offset) const;
+
+  /**
+   * @brief the match that was last jumped to, -1 if none; reset when the pattern or
+   *        the text change
+   **/
+  qint64 current() const { return m_current; }
+  void setCurrent(qint64 index);
+
+  /**
+   * @return the index of the match after the current one, or of the first one that
+   *         starts at or after the offset if there is no current match, wrapping
+   *         around; -1 if there is none or it has not been found yet
+   **/
+  qint64 nextIndex(qint64 offset) const;
+
+  /**
+   * @return the index of the match before the current one, or of the last one that
+   *         starts before the offset if there is no current match, wrapping around;
+   *         -1 if there is none or it has not been found yet
+   **/
+  qint64 previousIndex(qint64 offset) const;
+
+signals:
+  /**
+   * @brief emitted when matches were found, when the search is done and when the
+   *        pattern or the text change
+   **/
+  void matchesChanged();
+
+private:
+  struct TextBuffer;
+  struct Job;
+
+  QString m_pattern;
+  bool m_regex;
+
+  // either utf-16 text or utf-8 data is searched, the owner keeps it alive
+  std::shared_ptr<const void> m_owner;
+  const QChar* m_text;
+  const char* m_data;
+  qint64 m_begin;
+  qint64 m_end;
+
+  // the text once appendText() was called, it is appended to in place
+  std::shared_ptr<TextBuffer> m_buffer;
+
+  std::shared_ptr<Job> m_job;
+  qint64 m_current;
+
+  // merges finished chunks while a search runs
+  QTimer m_timer;
+
+  void restart(bool refine);
+
+  // searches what follows the line that contains `oldEnd` if the previous search is
+  // complete, everything otherwise
+  void extend(qint64 oldEnd);
+  std::shared_ptr<Job> makeJob(qint64 from) const;
+  void start(std::shared_ptr<Job> job);
+  void merge();
+};
+
+}  // namespace MOBase
+
+#endif  // TEXTSEARCH_H
@@ -23,10 +23,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "dllimport.h"
 #include <QDialog>
+#include <QSet>
 #include <QTabWidget>
 #include <QTextEdit>
+#include <map>
+#include <memory>
 #include <set>
 
+class QFileSystemWatcher;
+class QTimer;
+
 namespace Ui
 {
 class TextViewer;
@@ -36,6 +42,7 @@ namespace MOBase
 {
 
 class FindDialog;
+class TextSearch;
 
 /**
  * @brief rudimentary tabbed text editor
@@ -63,11 +70,29 @@ public:
   /**
    * @brief add a new tab with the specified file open
    *
+   * large read-only files are memory mapped and shown in a LargeTextView instead of
+   * being loaded in a QTextEdit
+   *
    * @param fileName name of the file to open
    * @param writable if true, the file can be modified
    **/
   void addFile(const QString& fileName, bool writable);
 
+  /**
+   * @brief shows what is written to the read-only files while they are open
+   *
+   * only the bytes that were appended are read, a file that is truncated or replaced
+   * by a rotating log is read again from the start
+   *
+   * @param follow whether to follow the files
+   **/
+  void setFollowing(bool follow);
+
+  /**
+   * @return whether the files are followed
+   **/
+  bool isFollowing() const;
+
 protected:
   void closeEvent(QCloseEvent* event);
   bool eventFilter(QObject* obj, QEvent* event);
@@ -77,12 +102,36 @@ private slots:
   void saveFile();
   void modified();
   void patternChanged(QString newPattern);
+  void regexChanged(bool regex);
   void findNext();
+  void findPrevious();
+  void matchesChanged();
   void showWhitespaceChanged(int state);
+  void followChanged(int state);
+  void followFiles();
 
 private:
+  struct Follow;
+
+  enum class PendingFind
+  {
+    None,
+    Next,
+    Previous
+  };
+
   void saveFile(const QTextEdit* editor);
   void find();
+  bool addLargeFile(const QString& fileName);
+
+  // the matches in the current tab, the search is created and given the current
+  // pattern if `create` is true
+  TextSearch* findSearch(bool create);
+  void findMatch(bool forward);
+  void updateFindStatus();
+
+  // appends what was written to the file of the editor, returns whether there is more
+  bool followDocument(QTextEdit* editor, Follow& follow);
 
 private:
   Ui::TextViewer* ui;
@@ -90,6 +139,19 @@ private:
   std::set<QTextEdit*> m_Modified;
   FindDialog* m_FindDialog;
   QString m_FindPattern;
+  bool m_FindRegex;
+
+  // a jump to a match that has not been found yet
+  PendingFind m_PendingFind;
+
+  // what was read from the files of the read-only editors
+  std::map<QTextEdit*, std::unique_ptr<Follow>> m_Follow;
+  QFileSystemWatcher* m_Watcher;
+  QTimer* m_FollowTimer;
+  int m_FollowTicks;
+
+  // files that changed since the last refresh
+  QSet<QString> m_ChangedFiles;
 };
 
 }  // namespace MOBase
@@ -21,8 +21,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef MO_UIBASE_UTILITY_INCLUDED
 #define MO_UIBASE_UTILITY_INCLUDED
 
+#include <QCollator>
 #include <QDir>
 #include <QIcon>
+#include <QImage>
 #include <QList>
 #include <QStandardPaths>
 #include <QString>
@@ -30,6 +32,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <QUrl>
 #include <QVariant>
 #include <algorithm>
+#include <functional>
+#include <numeric>
+#include <ranges>
 #include <set>
 #include <vector>
 
@@ -448,7 +453,49 @@ QDLLEXPORT QDateTime fileTimeToQDateTime(const FILETIME& time,
 QDLLEXPORT int naturalCompare(const QString& a, const QString& b,
                               Qt::CaseSensitivity cs = Qt::CaseInsensitive);
 
-// calls naturalCompare()
+// key for natural sorting, comparing the keys of two strings with
+// QCollatorSortKey::compare() gives the same result as naturalCompare(), but is much
+// cheaper when the same strings are compared over and over, like when sorting
+//
+QDLLEXPORT QCollatorSortKey
+naturalSortKey(const QString& s, Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+
+// sorts the given range naturally by the string that proj returns for each element,
+// this computes the key of each element once instead of comparing strings in every
+// comparison like sorting with NaturalSort does; the order of equal elements is kept
+//
+template <std::ranges::random_access_range Range, class Proj = std::identity>
+void naturalSort(Range&& range, Proj proj = {},
+                 Qt::CaseSensitivity cs = Qt::CaseInsensitive)
+{
+  const auto size = static_cast<std::size_t>(std::ranges::size(range));
+  if (size < 2) {
+    return;
+  }
+
+  std::vector<QCollatorSortKey> keys;
+  keys.reserve(size);
+  for (auto&& element : range) {
+    keys.push_back(naturalSortKey(std::invoke(proj, element), cs));
+  }
+
+  std::vector<std::size_t> order(size);
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  std::ranges::stable_sort(order, [&keys](std::size_t a, std::size_t b) {
+    return keys[a].compare(keys[b]) < 0;
+  });
+
+  std::vector<std::ranges::range_value_t<Range>> sorted;
+  sorted.reserve(size);
+  auto begin = std::ranges::begin(range);
+  for (const std::size_t i : order) {
+    sorted.push_back(std::move(begin[i]));
+  }
+
+  std::ranges::move(sorted, begin);
+}
+
+// calls naturalCompare(), see naturalSort() for sorting large ranges
 //
 class QDLLEXPORT NaturalSort
 {
@@ -543,6 +590,41 @@ QDLLEXPORT void removeOldFiles(const QString& path, const QString& pattern,
  **/
 QDLLEXPORT QIcon iconForExecutable(const QString& filePath);
 
+/**
+ * @brief Retrieves the icon of an executable as an image, unlike iconForExecutable()
+ * this can be called from any thread.
+ *
+ * @param filePath absolute path to the executable
+ * @return the image, or a null image if the executable has no icon
+ **/
+QDLLEXPORT QImage iconImageForExecutable(const QString& filePath);
+
+/**
+ * @brief Loads the icon of an executable on a background thread.
+ *
+ * Concurrent requests for the same file share a single load. The callback is invoked
+ * on the thread of `context`, and not at all if `context` is destroyed first.
+ *
+ * @param filePath absolute path to the executable
+ * @param context object the callback belongs to
+ * @param callback receives the icon, or the generic executable icon if the file has
+ *   none
+ * @return an icon to show until the callback is invoked
+ **/
+QDLLEXPORT QIcon iconForExecutableAsync(const QString& filePath, QObject* context,
+                                        std::function<void(const QIcon&)> callback);
+
+#ifdef __unix__
+/**
+ * @brief Sets a directory where the icons extracted by iconForExecutable() are kept
+ * between runs, so they don't have to be decoded again. An empty path disables this,
+ * which is the default.
+ *
+ * @param path Directory for the icons, created if it doesn't exist.
+ */
+QDLLEXPORT void setExecutableIconCacheDirectory(const QString& path);
+#endif
+
 /**
  * @brief Retrieve the file version of the given executable.
  *
@@ -563,6 +645,20 @@ QDLLEXPORT QString getFileVersion(QString const& filepath);
  */
 QDLLEXPORT QString getProductVersion(QString const& program);
 
+/**
+ * @brief Retrieves the file version of the given executable on a background thread.
+ *
+ * Concurrent requests for the same file share a single load. The callback is invoked
+ * on the thread of `context`, and not at all if `context` is destroyed first.
+ *
+ * @param filepath Absolute path to the executable.
+ * @param context Object the callback belongs to.
+ * @param callback Receives the file version, or an empty string if it could not be
+ *   retrieved.
+ */
+QDLLEXPORT void fileVersionAsync(const QString& filepath, QObject* context,
+                                 std::function<void(const QString&)> callback);
+
 // removes and deletes all the children of the given widget
 //
 QDLLEXPORT void deleteChildWidgets(QWidget* w);
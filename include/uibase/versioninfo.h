@@ -163,7 +163,7 @@ private:
    * @param versionString the version string to parse
    * @return the version string with the release type removed
    **/
-  QString parseReleaseType(QString versionString);
+  QString parseReleaseType(QStringView versionString);
 
 private:
   VersionScheme m_Scheme;
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <compare>
+#include <cstdint>
 #include <string>
 #include <variant>
 #include <vector>
 
 #include <QFlags>
+#include <QHashFunctions>
 #include <QString>
+#include <QStringView>
 
 #include "dllimport.h"
 #include "exceptions.h"
@@ -94,11 +97,44 @@ public:
   };
   using enum ReleaseType;
 
+  // a packed key built on construction that orders versions like operator<=>, so
+  // sorting or hashing versions mostly compares two integers
+  //
+  // the key is only exact if every field fits, two versions with equal keys that are
+  // not both exact must be compared with operator<=>, which does this already
+  //
+  struct SortKey
+  {
+    // major, minor, patch and sub-patch, 16 bits each
+    std::uint64_t high = 0;
+
+    // whether this is a release in the top byte, then up to 7 normalized pre-release
+    // identifiers, one byte each
+    std::uint64_t low = 0;
+
+    bool exact = true;
+
+    // compares the packed values only, see above
+    friend std::strong_ordering operator<=>(const SortKey& lhs, const SortKey& rhs)
+    {
+      if (const auto cmp = lhs.high <=> rhs.high; cmp != 0) {
+        return cmp;
+      }
+      return lhs.low <=> rhs.low;
+    }
+
+    friend bool operator==(const SortKey& lhs, const SortKey& rhs)
+    {
+      return lhs.high == rhs.high && lhs.low == rhs.low;
+    }
+  };
+
 public:  // parsing
   // parse version from the given string, throw InvalidVersionException if the string
   // cannot be parsed
   //
   static Version parse(QString const& value, ParseMode mode = ParseMode::SemVer);
+  static Version parse(QStringView value, ParseMode mode = ParseMode::SemVer);
 
 public:  // constructors
   Version(int major, int minor, int patch, QString metadata = {});
@@ -144,11 +180,17 @@ public:
   //
   const auto& buildMetadata() const { return m_BuildMetadata; }
 
+  // retrieve the packed sort key of this version
+  //
+  const SortKey& sortKey() const { return m_SortKey; }
+
   // convert this version to a string
   //
   QString string(const FormatModes& modes = {}) const;
 
 private:
+  SortKey makeSortKey() const;
+
   // major.minor.patch
   int m_Major, m_Minor, m_Patch, m_SubPatch;
 
@@ -157,6 +199,9 @@ private:
 
   // metadata
   QString m_BuildMetadata;
+
+  // built from the fields above by the constructors
+  SortKey m_SortKey;
 };
 
 QDLLEXPORT std::strong_ordering operator<=>(const Version& lhs, const Version& rhs);
@@ -166,6 +211,13 @@ inline bool operator==(const Version& lhs, const Version& rhs)
   return (lhs <=> rhs) == 0;
 }
 
+// equal versions have equal sort keys, even if the keys are not exact
+//
+inline size_t qHash(const Version& version, size_t seed = 0) noexcept
+{
+  return qHashMulti(seed, version.sortKey().high, version.sortKey().low);
+}
+
 Q_DECLARE_OPERATORS_FOR_FLAGS(Version::FormatModes);
 
 }  // namespace MOBase
@@ -179,3 +231,12 @@ struct std::formatter<MOBase::Version, CharT> : std::formatter<QString, CharT>
     return std::formatter<QString, CharT>::format(v.string(), ctx);
   }
 };
+
+template <>
+struct std::hash<MOBase::Version>
+{
+  std::size_t operator()(const MOBase::Version& v) const noexcept
+  {
+    return MOBase::qHash(v);
+  }
+};
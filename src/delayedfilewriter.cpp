@@ -3,7 +3,9 @@
 
 using namespace MOBase;
 
-DelayedFileWriterBase::DelayedFileWriterBase(int delay) : m_TimerDelay(delay), m_Timer()
+// the timer is a child so it follows the writer when it is moved to another thread
+DelayedFileWriterBase::DelayedFileWriterBase(int delay)
+    : m_TimerDelay(delay), m_Timer(this)
 {
   QObject::connect(&m_Timer, &QTimer::timeout, this, &DelayedFileWriter::timerExpired);
   m_Timer.setSingleShot(true);
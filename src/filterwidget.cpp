@@ -5,9 +5,18 @@
 #include <QContextMenuEvent>
 #include <QDialog>
 #include <QEvent>
+#include <QFuture>
+#include <QHash>
 #include <QMenu>
+#include <QPromise>
 #include <QSortFilterProxyModel>
+#include <QThreadPool>
 #include <QTimer>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <vector>
 
 namespace MOBase
 {
@@ -30,10 +39,459 @@ void setStyleProperty(QWidget* w, const char* k, const QVariant& v)
   w->updateGeometry();
 }
 
+namespace
+{
+
+  // display text of the columns of a row, each column is only fetched from the model
+  // once and only if a keyword needs it
+  //
+  class RowText
+  {
+  public:
+    RowText(const QAbstractItemModel& model, int row, const QModelIndex& parent,
+            int columns)
+        : m_model(model), m_row(row), m_parent(parent), m_columns(columns)
+    {}
+
+    const QString& text(int c) { return column(c).text; }
+
+    // case folded text, for literal keywords
+    const QString& folded(int c)
+    {
+      auto& col = column(c);
+
+      if (!col.folded) {
+        col.folded = col.text.toCaseFolded();
+      }
+
+      return *col.folded;
+    }
+
+  private:
+    struct Column
+    {
+      QString text;
+      std::optional<QString> folded;
+    };
+
+    const QAbstractItemModel& m_model;
+    const int m_row;
+    const QModelIndex& m_parent;
+    QVarLengthArray<std::optional<Column>, 16> m_columns;
+
+    Column& column(int c)
+    {
+      if (c >= m_columns.size()) {
+        m_columns.resize(c + 1);
+      }
+
+      auto& col = m_columns[c];
+
+      if (!col) {
+        const auto index = m_model.index(m_row, c, m_parent);
+        col = Column{m_model.data(index, Qt::DisplayRole).toString(), std::nullopt};
+      }
+
+      return *col;
+    }
+  };
+
+  // same as RowText for text that was already fetched, used by background filtering
+  //
+  class FetchedText
+  {
+  public:
+    explicit FetchedText(const QStringList& texts)
+        : m_texts(texts), m_folded(texts.size())
+    {}
+
+    const QString& text(int c) const { return m_texts[c]; }
+
+    const QString& folded(int c)
+    {
+      auto& folded = m_folded[c];
+
+      if (!folded) {
+        folded = m_texts[c].toCaseFolded();
+      }
+
+      return *folded;
+    }
+
+  private:
+    const QStringList& m_texts;
+    QVarLengthArray<std::optional<QString>, 16> m_folded;
+  };
+
+  // whether the row matches the filter in the given column, or in any of the columns
+  // if it's -1
+  //
+  template <class Row>
+  bool rowMatches(const FilterWidget::Compiled& compiled, Row& row, int columns,
+                  int column)
+  {
+    const auto columnMatches = [&](int c, const FilterWidget::Keyword& keyword) {
+      if (keyword.literal.isEmpty()) {
+        return keyword.regex.match(row.text(c)).hasMatch();
+      }
+
+      return row.folded(c).contains(keyword.literal);
+    };
+
+    return FilterWidget::matchesKeywords(compiled, [&](auto&& keyword) {
+      if (column == -1) {
+        for (int c = 0; c < columns; ++c) {
+          if (columnMatches(c, keyword)) {
+            return true;
+          }
+        }
+
+        return false;
+      } else {
+        return columnMatches(column, keyword);
+      }
+    });
+  }
+
+  // background filtering splits the rows in chunks of this size
+  constexpr qsizetype FilterChunkSize = 512;
+
+  QThreadPool& filterThreadPool()
+  {
+    static QThreadPool pool;
+    return pool;
+  }
+
+}  // namespace
+
+struct FilterWidgetProxyModel::Snapshot
+{
+  struct Row
+  {
+    // first column of the row, only used on the GUI thread
+    QModelIndex index;
+
+    // the filtered columns
+    QStringList texts;
+  };
+
+  // depth first, children are filtered too with recursive filtering
+  std::vector<Row> rows;
+
+  // position of each row in `rows`, by index
+  QHash<QModelIndex, qsizetype> positions;
+};
+
+struct FilterWidgetProxyModel::Job
+{
+  std::shared_ptr<const Snapshot> snapshot;
+  FilterWidget::Compiled compiled;
+
+  // result of the previous filter if this one refines it, the rows it rejected are
+  // skipped
+  std::shared_ptr<const Job> previous;
+
+  // whether each row of the snapshot was accepted
+  std::vector<char> accepted;
+
+  std::atomic<qsizetype> next = 0;
+  std::atomic<qsizetype> done = 0;
+  std::atomic<bool> cancelled = false;
+  QPromise<void> promise;
+
+  qsizetype chunks() const
+  {
+    const auto size = static_cast<qsizetype>(snapshot->rows.size());
+    return (size + FilterChunkSize - 1) / FilterChunkSize;
+  }
+
+  // filters chunks until none are left, the thread that filters the last one
+  // finishes the promise
+  void work()
+  {
+    const auto size  = static_cast<qsizetype>(snapshot->rows.size());
+    const auto count = chunks();
+
+    for (qsizetype chunk = next++; chunk < count; chunk = next++) {
+      const qsizetype end = std::min(size, (chunk + 1) * FilterChunkSize);
+
+      for (qsizetype i = chunk * FilterChunkSize; i < end && !cancelled; ++i) {
+        const auto p = static_cast<std::size_t>(i);
+
+        if (previous && !previous->accepted[p]) {
+          continue;
+        }
+
+        const auto& texts = snapshot->rows[p].texts;
+        FetchedText row(texts);
+        accepted[p] = rowMatches(compiled, row, int(texts.size()), -1);
+      }
+
+      if (++done == count) {
+        promise.finish();
+      }
+    }
+  }
+};
+
 FilterWidgetProxyModel::FilterWidgetProxyModel(FilterWidget& fw, QWidget* parent)
-    : QSortFilterProxyModel(parent), m_filter(fw)
+    : QSortFilterProxyModel(parent), m_filter(fw), m_refining(false),
+      m_applying(nullptr)
 {
   setRecursiveFilteringEnabled(true);
+
+  // invalidate() and the source model go through these before filtering all the
+  // rows again, outside of invalidateFilter()
+  connect(this, &QAbstractItemModel::layoutAboutToBeChanged, this,
+          [this](const QList<QPersistentModelIndex>&,
+                 QAbstractItemModel::LayoutChangeHint hint) {
+            // sorting does not change which rows are accepted
+            if (hint != QAbstractItemModel::VerticalSortHint) {
+              forgetResults();
+            }
+          });
+
+  connect(this, &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+    forgetResults();
+  });
+}
+
+FilterWidgetProxyModel::~FilterWidgetProxyModel()
+{
+  stopBackgroundFiltering();
+}
+
+void FilterWidgetProxyModel::invalidateFilter()
+{
+  forgetResults();
+  QSortFilterProxyModel::invalidateFilter();
+}
+
+void FilterWidgetProxyModel::refineFilter()
+{
+  m_refining = true;
+  forgetResults();
+  QSortFilterProxyModel::invalidateFilter();
+  m_refining = false;
+}
+
+void FilterWidgetProxyModel::filterInBackground(bool refining)
+{
+  // the changed rows are filtered on the GUI thread when the result is applied,
+  // past a point taking a new snapshot is cheaper
+  if (m_snapshot &&
+      m_changed.size() > static_cast<qsizetype>(m_snapshot->rows.size() / 4)) {
+    m_snapshot.reset();
+    m_changed.clear();
+  }
+
+  const auto snapshot = this->snapshot();
+
+  auto job      = std::make_shared<Job>();
+  job->snapshot = snapshot;
+  job->compiled = m_filter.m_compiled;
+  job->accepted.resize(snapshot->rows.size(), 0);
+
+  // the rows rejected by the previous filter can only be skipped if its result is
+  // the one that is shown and it filtered the same rows
+  if (refining && m_applied && m_applied == m_pending &&
+      m_applied->snapshot == snapshot) {
+    job->previous = m_applied;
+  }
+
+  if (m_pending) {
+    m_pending->cancelled = true;
+  }
+
+  m_pending = job;
+
+  job->promise.start();
+  // the continuation only holds a weak pointer, the job owns the promise
+  job->promise.future().then(this, [this, weak = std::weak_ptr<Job>(job)] {
+    if (auto finished = weak.lock()) {
+      onJobFinished(std::move(finished));
+    }
+  });
+
+  const qsizetype chunks = job->chunks();
+  if (chunks == 0) {
+    job->promise.finish();
+    return;
+  }
+
+  const auto workers =
+      std::min<qsizetype>(filterThreadPool().maxThreadCount(), chunks);
+
+  for (qsizetype i = 0; i < workers; ++i) {
+    filterThreadPool().start([job] {
+      job->work();
+    });
+  }
+}
+
+void FilterWidgetProxyModel::onJobFinished(std::shared_ptr<Job> job)
+{
+  if (job != m_pending) {
+    // the filter changed since
+    return;
+  }
+
+  if (job->snapshot != m_snapshot) {
+    // rows were added, removed or moved since, the indexes in the snapshot are
+    // stale; rows whose data changed are filtered again when the result is applied
+    filterInBackground(false);
+    return;
+  }
+
+  m_applied = job;
+  forgetResults();
+
+  m_applying = job.get();
+  QSortFilterProxyModel::invalidateFilter();
+  m_applying = nullptr;
+}
+
+std::shared_ptr<const FilterWidgetProxyModel::Snapshot>
+FilterWidgetProxyModel::snapshot()
+{
+  if (m_snapshot) {
+    return m_snapshot;
+  }
+
+  auto snapshot = std::make_shared<Snapshot>();
+
+  if (const auto* model = sourceModel()) {
+    const int column      = m_filter.filterColumn();
+    const int firstColumn = (column == -1 ? 0 : column);
+    const int lastColumn  = (column == -1 ? model->columnCount() - 1 : column);
+
+    std::vector<QModelIndex> parents{QModelIndex()};
+
+    while (!parents.empty()) {
+      const QModelIndex parent = parents.back();
+      parents.pop_back();
+
+      const int rows = model->rowCount(parent);
+
+      for (int r = 0; r < rows; ++r) {
+        Snapshot::Row row{model->index(r, 0, parent), {}};
+
+        for (int c = firstColumn; c <= lastColumn; ++c) {
+          row.texts.push_back(
+              model->data(model->index(r, c, parent), Qt::DisplayRole).toString());
+        }
+
+        if (model->hasChildren(row.index)) {
+          parents.push_back(row.index);
+        }
+
+        snapshot->positions.insert(row.index, snapshot->rows.size());
+        snapshot->rows.push_back(std::move(row));
+      }
+    }
+  }
+
+  m_snapshot = std::move(snapshot);
+  return m_snapshot;
+}
+
+void FilterWidgetProxyModel::stopBackgroundFiltering()
+{
+  if (m_pending) {
+    m_pending->cancelled = true;
+  }
+
+  m_pending.reset();
+  m_applied.reset();
+  m_snapshot.reset();
+  m_changed.clear();
+}
+
+void FilterWidgetProxyModel::setSourceModel(QAbstractItemModel* model)
+{
+  for (auto&& c : m_sourceConnections) {
+    disconnect(c);
+  }
+
+  m_sourceConnections.clear();
+  forgetRows();
+
+  if (model) {
+    // the rows are remembered by index, so they are only valid as long as the
+    // rows of the source do not change; this is connected before the base class so
+    // the rows are forgotten before it filters the changed rows again
+    const auto forget = [this] {
+      forgetRows();
+    };
+
+    m_sourceConnections = {
+        connect(model, &QAbstractItemModel::dataChanged, this,
+                &FilterWidgetProxyModel::onSourceDataChanged),
+        connect(model, &QAbstractItemModel::rowsInserted, this, forget),
+        connect(model, &QAbstractItemModel::rowsRemoved, this, forget),
+        connect(model, &QAbstractItemModel::rowsMoved, this, forget),
+        connect(model, &QAbstractItemModel::columnsInserted, this, forget),
+        connect(model, &QAbstractItemModel::columnsRemoved, this, forget),
+        connect(model, &QAbstractItemModel::columnsMoved, this, forget),
+        connect(model, &QAbstractItemModel::layoutChanged, this, forget),
+        connect(model, &QAbstractItemModel::modelReset, this, forget)};
+  }
+
+  QSortFilterProxyModel::setSourceModel(model);
+}
+
+void FilterWidgetProxyModel::forgetResults()
+{
+  // the rows rejected by the last full pass are still rejected by a more restrictive
+  // filter
+  if (!m_refining) {
+    m_rejected.clear();
+  }
+
+  m_accepted.clear();
+}
+
+void FilterWidgetProxyModel::forgetRows()
+{
+  // a pending background job is restarted when it finishes
+  m_rejected.clear();
+  m_accepted.clear();
+  m_applied.reset();
+  m_snapshot.reset();
+  m_changed.clear();
+}
+
+void FilterWidgetProxyModel::onSourceDataChanged(const QModelIndex& topLeft,
+                                                 const QModelIndex& bottomRight,
+                                                 const QList<int>& roles)
+{
+  if (!roles.isEmpty() && !roles.contains(Qt::DisplayRole)) {
+    return;
+  }
+
+  const int column = m_filter.filterColumn();
+  if (column != -1 && (column < topLeft.column() || column > bottomRight.column())) {
+    return;
+  }
+
+  const auto* model        = sourceModel();
+  const QModelIndex parent = topLeft.parent();
+
+  // whether an ancestor is accepted depends on its descendants
+  for (QModelIndex p = parent; p.isValid(); p = p.parent()) {
+    m_accepted.remove(p.siblingAtColumn(0));
+  }
+
+  for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+    const QModelIndex first = model->index(row, 0, parent);
+
+    m_accepted.remove(first);
+    m_rejected.remove(first);
+
+    if (m_snapshot && m_snapshot->positions.contains(first)) {
+      m_changed.insert(first);
+    }
+  }
 }
 
 bool FilterWidgetProxyModel::filterAcceptsRow(int sourceRow,
@@ -43,33 +501,120 @@ bool FilterWidgetProxyModel::filterAcceptsRow(int sourceRow,
     return true;
   }
 
-  const auto cols = sourceModel()->columnCount();
+  const auto first = sourceModel()->index(sourceRow, 0, sourceParent);
 
-  const auto m = m_filter.matches([&](auto&& regex) {
-    if (m_filter.filterColumn() == -1) {
-      for (int c = 0; c < cols; ++c) {
-        if (columnMatches(sourceRow, sourceParent, c, regex)) {
-          return true;
-        }
-      }
+  // with recursive filtering, the base class looks at the descendants of a row only
+  // if this rejects it, and it does so again for every ancestor it filters; this
+  // accepts the rows that have a matching descendant instead, so that every row is
+  // evaluated once and the descendants of a rejected row are only looked up
+  if (const auto itor = m_accepted.constFind(first); itor != m_accepted.constEnd()) {
+    return *itor;
+  }
 
-      return false;
-    } else {
-      return columnMatches(sourceRow, sourceParent, m_filter.filterColumn(), regex);
+  return acceptsRowOrChildren(sourceRow, sourceParent, first);
+}
+
+bool FilterWidgetProxyModel::matchesRow(int sourceRow, const QModelIndex& sourceParent,
+                                        const QModelIndex& first) const
+{
+  if (m_refining && m_rejected.contains(first)) {
+    return false;
+  }
+
+  // rows filtered in the background, any row that is not in the snapshot or whose
+  // data changed since it was taken is filtered here
+  std::optional<qsizetype> position;
+  if (m_applying && !m_changed.contains(first)) {
+    const auto& positions = m_applying->snapshot->positions;
+    if (const auto itor = positions.constFind(first); itor != positions.constEnd()) {
+      position = *itor;
     }
-  });
+  }
+
+  bool accepted = false;
+
+  if (position) {
+    accepted = m_applying->accepted[static_cast<std::size_t>(*position)];
+  } else {
+    // every column is fetched at most once for all the keywords
+    const auto cols = sourceModel()->columnCount();
+    RowText row(*sourceModel(), sourceRow, sourceParent, cols);
+
+    accepted = rowMatches(m_filter.m_compiled, row, cols, m_filter.filterColumn());
+  }
+
+  if (!accepted) {
+    m_rejected.insert(first);
+  }
 
-  return m;
+  return accepted;
 }
 
-bool FilterWidgetProxyModel::columnMatches(int sourceRow,
-                                           const QModelIndex& sourceParent, int c,
-                                           const QRegularExpression& regex) const
+bool FilterWidgetProxyModel::acceptsRowOrChildren(int sourceRow,
+                                                  const QModelIndex& sourceParent,
+                                                  const QModelIndex& first) const
 {
-  QModelIndex index = sourceModel()->index(sourceRow, c, sourceParent);
-  const auto text   = sourceModel()->data(index, Qt::DisplayRole).toString();
+  if (matchesRow(sourceRow, sourceParent, first)) {
+    m_accepted.insert(first, true);
+    return true;
+  }
+
+  const auto* model = sourceModel();
+
+  // depth first over the descendants, a row is accepted as soon as one of its
+  // children is; the result of every row that is visited is remembered, so rows
+  // that were already visited for another ancestor are not walked again
+  struct Frame
+  {
+    QModelIndex index;
+    int next;
+    int rows;
+    bool accepted;
+  };
+
+  std::vector<Frame> stack{{first, 0, model->rowCount(first), false}};
+
+  while (!stack.empty()) {
+    Frame& top = stack.back();
+
+    if (top.accepted || top.next == top.rows) {
+      const bool accepted = top.accepted;
+
+      m_accepted.insert(top.index, accepted);
+      stack.pop_back();
+
+      if (accepted && !stack.empty()) {
+        stack.back().accepted = true;
+      }
+
+      continue;
+    }
+
+    const int row           = top.next++;
+    const QModelIndex child = model->index(row, 0, top.index);
+
+    if (const auto itor = m_accepted.constFind(child); itor != m_accepted.constEnd()) {
+      top.accepted = *itor;
+      continue;
+    }
+
+    if (matchesRow(row, top.index, child)) {
+      m_accepted.insert(child, true);
+      top.accepted = true;
+      continue;
+    }
+
+    const int rows = model->rowCount(child);
+    if (rows == 0) {
+      m_accepted.insert(child, false);
+      continue;
+    }
 
-  return regex.match(text).hasMatch();
+    // invalidates `top`
+    stack.push_back({child, 0, rows, false});
+  }
+
+  return m_accepted.value(first);
 }
 
 void FilterWidgetProxyModel::sort(int column, Qt::SortOrder order)
@@ -101,7 +646,7 @@ FilterWidget::FilterWidget()
     : m_edit(nullptr), m_list(nullptr), m_proxy(nullptr), m_eventFilter(nullptr),
       m_clear(nullptr), m_timer(nullptr), m_useDelay(false), m_valid(true),
       m_useSourceSort(false), m_filterColumn(-1), m_filteringEnabled(true),
-      m_filteredBorder(true)
+      m_filteredBorder(true), m_backgroundFiltering(false)
 {
   m_timer = new QTimer(this);
   m_timer->setSingleShot(true);
@@ -206,6 +751,10 @@ const FilterWidget::sortFun& FilterWidget::sortPredicate() const
 void FilterWidget::setFilterColumn(int i)
 {
   m_filterColumn = i;
+
+  if (m_proxy) {
+    m_proxy->forgetRows();
+  }
 }
 
 int FilterWidget::filterColumn() const
@@ -216,6 +765,10 @@ int FilterWidget::filterColumn() const
 void FilterWidget::setFilteringEnabled(bool b)
 {
   m_filteringEnabled = b;
+
+  if (m_proxy) {
+    m_proxy->forgetRows();
+  }
 }
 
 bool FilterWidget::filteringEnabled() const
@@ -233,6 +786,22 @@ bool FilterWidget::filteredBorder() const
   return m_filteredBorder;
 }
 
+void FilterWidget::setBackgroundFiltering(bool b)
+{
+  m_backgroundFiltering = b;
+
+  if (!b && m_proxy) {
+    // the result of the pending job, if any, is dropped
+    m_proxy->stopBackgroundFiltering();
+    m_proxy->invalidateFilter();
+  }
+}
+
+bool FilterWidget::backgroundFiltering() const
+{
+  return m_backgroundFiltering;
+}
+
 FilterWidgetProxyModel* FilterWidget::proxyModel()
 {
   return m_proxy;
@@ -289,26 +858,27 @@ QItemSelection FilterWidget::mapSelectionToSource(const QItemSelection& sel) con
   }
 }
 
-void FilterWidget::compile()
+FilterWidget::Compiled FilterWidget::compile(const QString& text,
+                                             const Options& options)
 {
   Compiled compiled;
 
-  if (s_options.useRegex) {
+  if (options.useRegex) {
     QRegularExpression::PatternOptions flags =
         QRegularExpression::DotMatchesEverythingOption;
 
-    if (!s_options.regexCaseSensitive) {
+    if (!options.regexCaseSensitive) {
       flags |= QRegularExpression::CaseInsensitiveOption;
     }
 
-    if (s_options.regexExtended) {
+    if (options.regexExtended) {
       flags |= QRegularExpression::ExtendedPatternSyntaxOption;
     }
 
-    compiled.push_back({QRegularExpression(m_text, flags)});
+    compiled.push_back({Keyword{QRegularExpression(text, flags), {}}});
   } else {
     const QStringList ORList = [&] {
-      QString filterCopy = QString(m_text);
+      QString filterCopy = QString(text);
       filterCopy.replace("||", ";").replace("OR", ";").replace("|", ";");
       return filterCopy.split(";", Qt::SkipEmptyParts);
     }();
@@ -316,7 +886,7 @@ void FilterWidget::compile()
     // split in ORSegments that internally use AND logic
     for (const auto& ORSegment : ORList) {
       const auto keywords = ORSegment.split(" ", Qt::SkipEmptyParts);
-      QList<QRegularExpression> regexes;
+      QList<Keyword> ANDKeywords;
 
       for (const auto& keyword : keywords) {
         const QString escaped = QRegularExpression::escape(keyword);
@@ -324,18 +894,29 @@ void FilterWidget::compile()
         const auto flags = QRegularExpression::CaseInsensitiveOption |
                            QRegularExpression::DotMatchesEverythingOption;
 
-        regexes.push_back(QRegularExpression(escaped, flags));
+        // the escaped regex matches the keyword anywhere in the text regardless of
+        // case, which is what a search for the case folded keyword does, without
+        // going through the regex engine
+        ANDKeywords.push_back(
+            Keyword{QRegularExpression(escaped, flags), keyword.toCaseFolded()});
       }
 
-      compiled.push_back(regexes);
+      compiled.push_back(ANDKeywords);
     }
   }
 
+  return compiled;
+}
+
+void FilterWidget::compile()
+{
+  Compiled compiled = compile(m_text, s_options);
+
   bool valid = true;
 
   for (auto&& ANDKeywords : compiled) {
     for (auto&& keyword : ANDKeywords) {
-      if (!keyword.isValid()) {
+      if (!keyword.regex.isValid()) {
         valid = false;
         break;
       }
@@ -356,11 +937,69 @@ void FilterWidget::compile()
 
 bool FilterWidget::matches(predFun pred) const
 {
-  if (m_compiled.isEmpty() || !pred) {
+  if (!pred) {
+    return true;
+  }
+
+  return matchesKeywords(m_compiled, [&](const Keyword& keyword) {
+    return pred(keyword.regex);
+  });
+}
+
+bool FilterWidget::matches(const QString& s) const
+{
+  return matches(m_compiled, s);
+}
+
+bool FilterWidget::matches(const Compiled& compiled, const QString& s)
+{
+  std::optional<QString> folded;
+
+  return matchesKeywords(compiled, [&](const Keyword& keyword) {
+    if (keyword.literal.isEmpty()) {
+      return keyword.regex.match(s).hasMatch();
+    }
+
+    if (!folded) {
+      folded = s.toCaseFolded();
+    }
+
+    return folded->contains(keyword.literal);
+  });
+}
+
+bool FilterWidget::isRefinement(const Compiled& previous, const Compiled& current)
+{
+  // an empty filter accepts everything, there is nothing to skip
+  if (previous.isEmpty() || previous.size() != current.size()) {
+    return false;
+  }
+
+  // a row accepted by a segment contains all of its keywords, so it also contains
+  // every keyword of the previous segment that is part of one of them
+  for (qsizetype i = 0; i < current.size(); ++i) {
+    for (auto&& keyword : previous[i]) {
+      const bool contained = std::ranges::any_of(current[i], [&](auto&& k) {
+        return !keyword.literal.isEmpty() && !k.literal.isEmpty() &&
+               k.literal.contains(keyword.literal);
+      });
+
+      if (!contained) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool FilterWidget::matchesKeywords(const Compiled& compiled, const keywordFun& pred)
+{
+  if (compiled.isEmpty()) {
     return true;
   }
 
-  for (auto& ANDKeywords : m_compiled) {
+  for (auto& ANDKeywords : compiled) {
     bool segmentGood = true;
 
     // check each word in the segment for match, each word needs to be matched
@@ -368,6 +1007,7 @@ bool FilterWidget::matches(predFun pred) const
     for (auto& currentKeyword : ANDKeywords) {
       if (!pred(currentKeyword)) {
         segmentGood = false;
+        break;
       }
     }
 
@@ -381,13 +1021,6 @@ bool FilterWidget::matches(predFun pred) const
   return false;
 }
 
-bool FilterWidget::matches(const QString& s) const
-{
-  return matches([&](const QRegularExpression& re) {
-    return re.match(s).hasMatch();
-  });
-}
-
 void FilterWidget::hookEdit()
 {
   m_eventFilter = new EventFilter(m_edit, [&](auto* w, auto* e) {
@@ -561,11 +1194,21 @@ void FilterWidget::set()
 
   emit aboutToChange(old, currentText);
 
+  const Compiled previous = m_compiled;
+
   m_text = currentText;
   compile();
 
   if (m_proxy) {
-    m_proxy->invalidateFilter();
+    const bool refining = isRefinement(previous, m_compiled);
+
+    if (m_backgroundFiltering) {
+      m_proxy->filterInBackground(refining);
+    } else if (refining) {
+      m_proxy->refineFilter();
+    } else {
+      m_proxy->invalidateFilter();
+    }
   }
 
   if (m_list) {
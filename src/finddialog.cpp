@@ -34,11 +34,42 @@ FindDialog::~FindDialog()
   delete ui;
 }
 
+void FindDialog::setMatches(qint64 current, qint64 count, bool complete)
+{
+  if (ui->patternEdit->text().isEmpty()) {
+    ui->matchesLabel->clear();
+  } else if (current >= 0) {
+    ui->matchesLabel->setText(complete ? tr("%1 of %2").arg(current + 1).arg(count)
+                                       : tr("%1 of %2+").arg(current + 1).arg(count));
+  } else if (!complete) {
+    ui->matchesLabel->setText(tr("%1+ matches").arg(count));
+  } else if (count == 0) {
+    ui->matchesLabel->setText(tr("No matches"));
+  } else {
+    ui->matchesLabel->setText(tr("%n match(es)", "", static_cast<int>(count)));
+  }
+}
+
+void FindDialog::setError(const QString& error)
+{
+  ui->matchesLabel->setText(error);
+}
+
 void FindDialog::on_nextBtn_clicked()
 {
   emit findNext();
 }
 
+void FindDialog::on_prevBtn_clicked()
+{
+  emit findPrevious();
+}
+
+void FindDialog::on_regexBox_toggled(bool checked)
+{
+  emit regexChanged(checked);
+}
+
 void FindDialog::on_patternEdit_textChanged(const QString& pattern)
 {
   emit patternChanged(pattern);
@@ -22,39 +22,23 @@
 
 #include "json.h"
 
+#include <QIODevice>
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QTJSON_HAS_SSE2
+#endif
+
 namespace QtJson
 {
-static QString sanitizeString(QString str);
-static QByteArray join(const QList<QByteArray>& list, const QByteArray& sep);
-static QVariant parseValue(const QString& json, int& index, bool& success);
-static QVariant parseObject(const QString& json, int& index, bool& success);
-static QVariant parseArray(const QString& json, int& index, bool& success);
-static QVariant parseString(const QString& json, int& index, bool& success);
-static QVariant parseNumber(const QString& json, int& index);
-static int lastIndexOfNumber(const QString& json, int index);
-static void eatWhitespace(const QString& json, int& index);
-static int lookAhead(const QString& json, int index);
-static int nextToken(const QString& json, int& index);
-
-template <typename T>
-QByteArray serializeMap(const T& map, bool& success)
-{
-  QByteArray str = "{ ";
-  QList<QByteArray> pairs;
-  for (typename T::const_iterator it = map.begin(), itend = map.end(); it != itend;
-       ++it) {
-    QByteArray serializedValue = serialize(it.value());
-    if (serializedValue.isNull()) {
-      success = false;
-      break;
-    }
-    pairs << sanitizeString(it.key()).toUtf8() + " : " + serializedValue;
-  }
-
-  str += join(pairs, ", ");
-  str += " }";
-  return str;
-}
 
 /**
  * parse
@@ -72,81 +56,332 @@ QVariant parse(const QString& json, bool& success)
 {
   success = true;
 
-  // Return an empty QVariant if the JSON data is either null or empty
-  if (!json.isNull() || !json.isEmpty()) {
-    QString data = json;
-    // We'll start from index 0
-    int index = 0;
-
-    // Parse the first value
-    QVariant value = parseValue(data, index, success);
-
-    // Return the parsed value
-    return value;
-  } else {
-    // Return the empty QVariant
+  // a null string has always been accepted as an empty document
+  if (json.isNull()) {
     return QVariant();
   }
+
+  return parseUtf8(json.toUtf8(), success);
 }
 
-QByteArray serialize(const QVariant& data)
+QVariant parseUtf8(const QByteArray& json)
 {
   bool success = true;
-  return serialize(data, success);
+  return parseUtf8(json, success);
 }
 
-QByteArray serialize(const QVariant& data, bool& success)
+QVariant parseUtf8(const QByteArray& json, bool& success)
 {
-  QByteArray str;
   success = true;
 
-  if (!data.isValid()) {  // invalid or null?
-    str = "null";
-  } else if ((data.typeId() == QMetaType::Type::QVariantList) ||
-             (data.typeId() == QMetaType::Type::QStringList)) {  // variant is a list?
-    QList<QByteArray> values;
-    const QVariantList list = data.toList();
-    Q_FOREACH (const QVariant& v, list) {
-      QByteArray serializedValue = serialize(v);
-      if (serializedValue.isNull()) {
-        success = false;
-        break;
+  if (json.isNull()) {
+    return QVariant();
+  }
+
+  const Document doc = Document::parse(json);
+  if (!doc.isValid()) {
+    success = false;
+    return QVariant();
+  }
+
+  return doc.root().toVariant();
+}
+
+namespace
+{
+
+// output is handed to the device in chunks of about this size
+constexpr qsizetype WriterChunkSize = 64 * 1024;
+
+// characters that need an escape in a JSON string, all of them are ASCII
+//
+constexpr bool needsEscape(char16_t c)
+{
+  return c < 0x20 || c == u'"' || c == u'\\';
+}
+
+}  // namespace
+
+Writer::Writer(QIODevice* device)
+    : m_device(device), m_out(&m_buffer), m_encoder(QStringEncoder::Utf8),
+      m_deviceOk(true)
+{
+  m_buffer.reserve(WriterChunkSize + WriterChunkSize / 4);
+}
+
+Writer::Writer(QByteArray* buffer)
+    : m_device(nullptr), m_out(buffer), m_encoder(QStringEncoder::Utf8),
+      m_deviceOk(true)
+{}
+
+Writer::~Writer()
+{
+  flush();
+}
+
+bool Writer::write(const QVariant& data)
+{
+  const bool success = writeValue(data);
+  flushIfFull();
+  return success;
+}
+
+bool Writer::flush()
+{
+  if (m_device == nullptr || m_buffer.isEmpty()) {
+    return m_deviceOk;
+  }
+
+  if (m_device->write(m_buffer) != m_buffer.size()) {
+    m_deviceOk = false;
+  }
+
+  m_buffer.resize(0);
+  return m_deviceOk;
+}
+
+void Writer::flushIfFull()
+{
+  if (m_device != nullptr && m_buffer.size() >= WriterChunkSize) {
+    flush();
+  }
+}
+
+bool Writer::writeValue(const QVariant& data)
+{
+  // the order of these checks matters, many types can be converted to numbers
+  // or strings
+  switch (data.typeId()) {
+  case QMetaType::UnknownType:
+    writeRaw("null");
+    return true;
+
+  case QMetaType::QVariantList:
+    return writeList(data.toList());
+
+  case QMetaType::QStringList: {
+    const QStringList list = data.toStringList();
+
+    writeRaw("[ ");
+    for (qsizetype i = 0; i < list.size(); ++i) {
+      if (i > 0) {
+        writeRaw(", ");
       }
-      values << serializedValue;
+      writeString(list[i]);
     }
+    writeRaw(" ]");
 
-    str = "[ " + join(values, ", ") + " ]";
-  } else if (data.typeId() == QMetaType::Type::QVariantHash) {  // variant is a hash?
-    str = serializeMap<>(data.toHash(), success);
-  } else if (data.typeId() == QMetaType::Type::QVariantMap) {  // variant is a map?
-    str = serializeMap<>(data.toMap(), success);
-  } else if ((data.typeId() == QMetaType::Type::QString) ||
-             (data.typeId() ==
-              QMetaType::Type::QByteArray)) {  // a string or a byte array?
-    str = sanitizeString(data.toString()).toUtf8();
-  } else if (data.typeId() == QMetaType::Type::Double) {  // double?
-    double value = data.toDouble();
-    if ((value - value) == 0.0) {
-      str = QByteArray::number(value, 'g');
-      if (!str.contains(".") && !str.contains("e")) {
-        str += ".0";
-      }
-    } else {
-      success = false;
+    return true;
+  }
+
+  case QMetaType::QVariantHash:
+    return writeMap(data.toHash());
+
+  case QMetaType::QVariantMap:
+    return writeMap(data.toMap());
+
+  case QMetaType::QString:
+    writeString(data.toString());
+    return true;
+
+  case QMetaType::QByteArray:
+    writeString(QString::fromUtf8(data.toByteArray()));
+    return true;
+
+  case QMetaType::Double: {
+    const double value = data.toDouble();
+    if ((value - value) != 0.0) {
+      // infinite or NaN
+      return false;
     }
-  } else if (data.typeId() == QMetaType::Type::Bool) {  // boolean value?
-    str = data.toBool() ? "true" : "false";
-  } else if (data.typeId() == QMetaType::Type::ULongLong) {  // large unsigned number?
-    str = QByteArray::number(data.value<qulonglong>());
-  } else if (data.canConvert<qlonglong>()) {  // any signed number?
-    str = QByteArray::number(data.value<qlonglong>());
-  } else if (data.canConvert<long>()) {  // TODO: this code is never executed
-    str = QString::number(data.value<long>()).toUtf8();
+
+    QByteArray str = QByteArray::number(value, 'g');
+    if (!str.contains('.') && !str.contains('e')) {
+      str += ".0";
+    }
+
+    m_out->append(str);
+    return true;
+  }
+
+  case QMetaType::Bool:
+    writeRaw(data.toBool() ? "true" : "false");
+    return true;
+
+  case QMetaType::ULongLong:
+    writeInteger(data.value<qulonglong>());
+    return true;
+  }
+
+  if (data.canConvert<qlonglong>()) {  // any signed number?
+    writeInteger(data.value<qlonglong>());
+    return true;
   } else if (data.canConvert<QString>()) {  // can value be converted to string?
     // this will catch QDate, QDateTime, QUrl, ...
-    str = sanitizeString(data.toString()).toUtf8();
-  } else {
-    success = false;
+    writeString(data.toString());
+    return true;
+  }
+
+  return false;
+}
+
+bool Writer::writeList(const QVariantList& list)
+{
+  writeRaw("[ ");
+
+  for (qsizetype i = 0; i < list.size(); ++i) {
+    if (i > 0) {
+      writeRaw(", ");
+    }
+
+    if (!writeValue(list[i])) {
+      return false;
+    }
+
+    flushIfFull();
+  }
+
+  writeRaw(" ]");
+  return true;
+}
+
+template <class Map>
+bool Writer::writeMap(const Map& map)
+{
+  writeRaw("{ ");
+
+  bool first = true;
+  for (auto it = map.begin(), itend = map.end(); it != itend; ++it) {
+    if (!first) {
+      writeRaw(", ");
+    }
+    first = false;
+
+    writeString(it.key());
+    writeRaw(" : ");
+
+    if (!writeValue(it.value())) {
+      return false;
+    }
+
+    flushIfFull();
+  }
+
+  writeRaw(" }");
+  return true;
+}
+
+void Writer::writeString(QStringView s)
+{
+  m_out->append('"');
+
+  const char16_t* p   = s.utf16();
+  const char16_t* end = p + s.size();
+
+  while (p < end) {
+    // longest run that can be copied as is, this is usually the whole string
+    const char16_t* run = p;
+    bool ascii          = true;
+    while (p < end && !needsEscape(*p)) {
+      ascii = ascii && *p < 0x80;
+      ++p;
+    }
+
+    if (p > run) {
+      const qsizetype length = p - run;
+      const qsizetype offset = m_out->size();
+
+      if (ascii) {
+        m_out->resize(offset + length);
+        char* out = m_out->data() + offset;
+        for (qsizetype i = 0; i < length; ++i) {
+          out[i] = static_cast<char>(run[i]);
+        }
+      } else {
+        // escapes are ASCII, so a run never ends in the middle of a
+        // surrogate pair
+        m_out->resize(offset + m_encoder.requiredSpace(length));
+        char* out = m_encoder.appendToBuffer(m_out->data() + offset,
+                                             QStringView(run, length));
+        m_out->truncate(out - m_out->constData());
+      }
+    }
+
+    if (p == end) {
+      break;
+    }
+
+    switch (*p) {
+    case u'"':
+      writeRaw("\\\"");
+      break;
+    case u'\\':
+      writeRaw("\\\\");
+      break;
+    case u'\b':
+      writeRaw("\\b");
+      break;
+    case u'\f':
+      writeRaw("\\f");
+      break;
+    case u'\n':
+      writeRaw("\\n");
+      break;
+    case u'\r':
+      writeRaw("\\r");
+      break;
+    case u'\t':
+      writeRaw("\\t");
+      break;
+    default: {
+      // remaining control characters, these used to be written as is, which
+      // is not valid JSON
+      constexpr char hex[] = "0123456789abcdef";
+      const char escape[]  = {'\\', 'u', '0', '0', hex[(*p >> 4) & 0xf],
+                              hex[*p & 0xf]};
+      m_out->append(escape, sizeof(escape));
+      break;
+    }
+    }
+
+    ++p;
+  }
+
+  m_out->append('"');
+}
+
+void Writer::writeRaw(std::string_view s)
+{
+  m_out->append(s.data(), static_cast<qsizetype>(s.size()));
+}
+
+void Writer::writeInteger(qlonglong value)
+{
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  m_out->append(buffer, result.ptr - buffer);
+}
+
+void Writer::writeInteger(qulonglong value)
+{
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  m_out->append(buffer, result.ptr - buffer);
+}
+
+QByteArray serialize(const QVariant& data)
+{
+  bool success = true;
+  return serialize(data, success);
+}
+
+QByteArray serialize(const QVariant& data, bool& success)
+{
+  QByteArray str;
+
+  {
+    Writer writer(&str);
+    success = writer.write(data);
   }
 
   if (success) {
@@ -166,392 +401,862 @@ QString serializeStr(const QVariant& data, bool& success)
   return QString::fromUtf8(serialize(data, success));
 }
 
-/**
- * \enum JsonToken
- */
-enum JsonToken
-{
-  JsonTokenNone         = 0,
-  JsonTokenCurlyOpen    = 1,
-  JsonTokenCurlyClose   = 2,
-  JsonTokenSquaredOpen  = 3,
-  JsonTokenSquaredClose = 4,
-  JsonTokenColon        = 5,
-  JsonTokenComma        = 6,
-  JsonTokenString       = 7,
-  JsonTokenNumber       = 8,
-  JsonTokenTrue         = 9,
-  JsonTokenFalse        = 10,
-  JsonTokenNull         = 11
+namespace detail
+{
+
+enum class NodeType : std::uint8_t
+{
+  Null,
+  True,
+  False,
+  Number,
+  String,
+  Array,
+  Object
+};
+
+struct Node
+{
+  NodeType type;
+
+  // offset of the value in the input, past the opening quote for strings
+  std::uint32_t offset;
+
+  // byte length for strings and numbers, number of elements or members for
+  // arrays and objects
+  std::uint32_t length;
+
+  // index of the first node that is not part of this value; the members of an
+  // object are stored as a key node followed by the value nodes
+  std::uint32_t next;
+};
+
+struct Tape
+{
+  QByteArray data;
+  std::vector<Node> nodes;
 };
 
-static QString sanitizeString(QString str)
+}  // namespace detail
+
+namespace
 {
-  str.replace(QLatin1String("\\"), QLatin1String("\\\\"));
-  str.replace(QLatin1String("\""), QLatin1String("\\\""));
-  str.replace(QLatin1String("\b"), QLatin1String("\\b"));
-  str.replace(QLatin1String("\f"), QLatin1String("\\f"));
-  str.replace(QLatin1String("\n"), QLatin1String("\\n"));
-  str.replace(QLatin1String("\r"), QLatin1String("\\r"));
-  str.replace(QLatin1String("\t"), QLatin1String("\\t"));
-  return QString(QLatin1String("\"%1\"")).arg(str);
+
+using detail::Node;
+using detail::NodeType;
+using detail::Tape;
+
+// deeper documents are rejected instead of risking the stack
+constexpr int MaxDepth = 1024;
+
+enum CharClass : std::uint8_t
+{
+  ClassOther     = 0,
+  ClassQuote     = 1,
+  ClassBackslash = 2,
+  ClassOp        = 4,
+  ClassSpace     = 8
+};
+
+constexpr std::array<std::uint8_t, 256> makeCharClasses()
+{
+  std::array<std::uint8_t, 256> classes{};
+  classes['"']  = ClassQuote;
+  classes['\\'] = ClassBackslash;
+
+  for (unsigned char c : {'{', '}', '[', ']', ':', ','}) {
+    classes[c] = ClassOp;
+  }
+
+  for (unsigned char c : {' ', '\t', '\n', '\r'}) {
+    classes[c] = ClassSpace;
+  }
+
+  return classes;
 }
 
-static QByteArray join(const QList<QByteArray>& list, const QByteArray& sep)
+constexpr std::array<std::uint8_t, 256> s_CharClasses = makeCharClasses();
+
+// one bit per byte of a 64 byte block
+//
+struct BlockMasks
 {
-  QByteArray res;
-  Q_FOREACH (const QByteArray& i, list) {
-    if (!res.isEmpty()) {
-      res += sep;
-    }
-    res += i;
+  std::uint64_t quote      = 0;
+  std::uint64_t backslash  = 0;
+  std::uint64_t op         = 0;
+  std::uint64_t whitespace = 0;
+};
+
+#if defined(QTJSON_HAS_SSE2)
+
+BlockMasks classifyBlock(const char* block)
+{
+  const __m128i quote     = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i lowercase = _mm_set1_epi8(0x20);
+  const __m128i curlyOpen = _mm_set1_epi8('{');
+  const __m128i curlyEnd  = _mm_set1_epi8('}');
+  const __m128i colon     = _mm_set1_epi8(':');
+  const __m128i comma     = _mm_set1_epi8(',');
+  const __m128i space     = _mm_set1_epi8(' ');
+  const __m128i tab       = _mm_set1_epi8('\t');
+  const __m128i lf        = _mm_set1_epi8('\n');
+  const __m128i cr        = _mm_set1_epi8('\r');
+
+  BlockMasks m;
+
+  for (int i = 0; i < 4; ++i) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+
+    const auto bits = [&](__m128i eq) {
+      return static_cast<std::uint64_t>(
+                 static_cast<std::uint32_t>(_mm_movemask_epi8(eq)))
+             << (i * 16);
+    };
+
+    // '[' and ']' only differ from '{' and '}' by the 0x20 bit
+    const __m128i folded = _mm_or_si128(v, lowercase);
+
+    const __m128i op = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(folded, curlyOpen),
+                     _mm_cmpeq_epi8(folded, curlyEnd)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+
+    const __m128i ws =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                     _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+
+    m.quote |= bits(_mm_cmpeq_epi8(v, quote));
+    m.backslash |= bits(_mm_cmpeq_epi8(v, backslash));
+    m.op |= bits(op);
+    m.whitespace |= bits(ws);
   }
-  return res;
+
+  return m;
 }
 
-/**
- * parseValue
- */
-static QVariant parseValue(const QString& json, int& index, bool& success)
-{
-  // Determine what kind of data we should parse by
-  // checking out the upcoming token
-  switch (lookAhead(json, index)) {
-  case JsonTokenString:
-    return parseString(json, index, success);
-  case JsonTokenNumber:
-    return parseNumber(json, index);
-  case JsonTokenCurlyOpen:
-    return parseObject(json, index, success);
-  case JsonTokenSquaredOpen:
-    return parseArray(json, index, success);
-  case JsonTokenTrue:
-    nextToken(json, index);
-    return QVariant(true);
-  case JsonTokenFalse:
-    nextToken(json, index);
-    return QVariant(false);
-  case JsonTokenNull:
-    nextToken(json, index);
-    return QVariant();
-  case JsonTokenNone:
-    break;
+#else
+
+BlockMasks classifyBlock(const char* block)
+{
+  BlockMasks m;
+
+  for (int i = 0; i < 64; ++i) {
+    const std::uint8_t c    = s_CharClasses[static_cast<unsigned char>(block[i])];
+    const std::uint64_t bit = std::uint64_t(1) << i;
+
+    m.quote |= (c & ClassQuote) ? bit : 0;
+    m.backslash |= (c & ClassBackslash) ? bit : 0;
+    m.op |= (c & ClassOp) ? bit : 0;
+    m.whitespace |= (c & ClassSpace) ? bit : 0;
   }
 
-  // If there were no tokens, flag the failure and return an empty QVariant
-  success = false;
-  return QVariant();
+  return m;
 }
 
-/**
- * parseObject
- */
-static QVariant parseObject(const QString& json, int& index, bool& success)
-{
-  QVariantMap map;
-  int token;
-
-  // Get rid of the whitespace and increment index
-  nextToken(json, index);
-
-  // Loop through all of the key/value pairs of the object
-  bool done = false;
-  while (!done) {
-    // Get the upcoming token
-    token = lookAhead(json, index);
-
-    if (token == JsonTokenNone) {
-      success = false;
-      return QVariantMap();
-    } else if (token == JsonTokenComma) {
-      nextToken(json, index);
-    } else if (token == JsonTokenCurlyClose) {
-      nextToken(json, index);
-      return map;
-    } else {
-      // Parse the key/value pair's name
-      QString name = parseString(json, index, success).toString();
+#endif
+
+// returns the characters that are escaped by a backslash, runs of backslashes
+// escape every other character; carry is set when the last character of the
+// block escapes the first one of the next block
+//
+std::uint64_t findEscaped(std::uint64_t backslash, std::uint64_t& carry)
+{
+  constexpr std::uint64_t evenBits = 0x5555555555555555ULL;
+
+  // an escaped backslash cannot start a new escape
+  backslash &= ~carry;
+
+  const std::uint64_t followsEscape     = (backslash << 1) | carry;
+  const std::uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+
+  // adding the starts of sequences that begin on odd bits flips them to even
+  // bits; an overflow means the last sequence runs into the next block
+  const std::uint64_t sequencesOnEvenBits = oddSequenceStarts + backslash;
+  carry = sequencesOnEvenBits < backslash ? 1 : 0;
+
+  const std::uint64_t invertMask = sequencesOnEvenBits << 1;
+  return (evenBits ^ invertMask) & followsEscape;
+}
+
+// every bit is the xor of itself and all lower bits, which turns the quote
+// mask into a mask of everything between an opening and a closing quote
+//
+std::uint64_t prefixXor(std::uint64_t bits)
+{
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// finds the offsets of all brackets, colons and commas outside of strings,
+// both quotes of every string and the first character of every other scalar;
+// the closing quote of a string is therefore always the structural right after
+// its opening quote
+//
+// returns false if the last string is not terminated
+//
+bool findStructurals(const char* data, std::size_t size,
+                     std::vector<std::uint32_t>& out)
+{
+  std::uint64_t prevEscaped  = 0;
+  std::uint64_t prevInString = 0;
+  std::uint64_t prevScalar   = 0;
+
+  out.reserve(size / 6 + 8);
+
+  char padded[64];
+
+  for (std::size_t base = 0; base < size; base += 64) {
+    const char* block = data + base;
+
+    if (size - base < 64) {
+      // the tail is padded with whitespace, which is never structural
+      std::memset(padded, ' ', sizeof(padded));
+      std::memcpy(padded, block, size - base);
+      block = padded;
+    }
+
+    const BlockMasks m = classifyBlock(block);
+
+    const std::uint64_t escaped  = findEscaped(m.backslash, prevEscaped);
+    const std::uint64_t quote    = m.quote & ~escaped;
+    const std::uint64_t inString = prefixXor(quote) ^ prevInString;
+    prevInString =
+        static_cast<std::uint64_t>(static_cast<std::int64_t>(inString) >> 63);
 
-      if (!success) {
-        return QVariantMap();
+    // the first character of everything that is not an operator, whitespace or
+    // a quote starts a scalar
+    const std::uint64_t scalar        = ~(m.op | m.whitespace | quote);
+    const std::uint64_t followsScalar = (scalar << 1) | prevScalar;
+    const std::uint64_t scalarStart   = scalar & ~followsScalar;
+    prevScalar                        = scalar >> 63;
+
+    std::uint64_t structurals = ((m.op | scalarStart) & ~inString) | quote;
+
+    while (structurals != 0) {
+      out.push_back(
+          static_cast<std::uint32_t>(base + std::countr_zero(structurals)));
+      structurals &= structurals - 1;
+    }
+  }
+
+  return prevInString == 0;
+}
+
+// builds the tape from the structural index, the bytes between structurals are
+// only looked at for numbers and literals
+//
+class TapeBuilder
+{
+public:
+  TapeBuilder(const char* data, std::size_t size,
+              const std::vector<std::uint32_t>& structurals, std::vector<Node>& nodes)
+      : m_data(data), m_size(size), m_structurals(structurals), m_nodes(nodes)
+  {}
+
+  bool build() { return parseValue(0); }
+
+private:
+  const char* m_data;
+  std::size_t m_size;
+  const std::vector<std::uint32_t>& m_structurals;
+  std::vector<Node>& m_nodes;
+  std::size_t m_pos = 0;
+
+  bool atEnd() const { return m_pos >= m_structurals.size(); }
+
+  char peek() const { return m_data[m_structurals[m_pos]]; }
+
+  std::uint32_t push(NodeType type, std::uint32_t offset, std::uint32_t length)
+  {
+    const auto index = static_cast<std::uint32_t>(m_nodes.size());
+    m_nodes.push_back({type, offset, length, index + 1});
+    return index;
+  }
+
+  // a scalar must be followed by whitespace, an operator, a string or the end
+  // of the input, anything else is garbage like "truex" or "12abc"
+  bool endsScalar(std::size_t offset) const
+  {
+    return offset >= m_size ||
+           (s_CharClasses[static_cast<unsigned char>(m_data[offset])] &
+            (ClassOp | ClassSpace | ClassQuote)) != 0;
+  }
+
+  bool parseValue(int depth)
+  {
+    if (atEnd() || depth > MaxDepth) {
+      return false;
+    }
+
+    const std::uint32_t at = m_structurals[m_pos++];
+
+    switch (m_data[at]) {
+    case '{':
+      return parseContainer(at, depth, true);
+    case '[':
+      return parseContainer(at, depth, false);
+    case '"':
+      return parseString(at);
+    case 't':
+      return parseLiteral(at, "true", NodeType::True);
+    case 'f':
+      return parseLiteral(at, "false", NodeType::False);
+    case 'n':
+      return parseLiteral(at, "null", NodeType::Null);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      return parseNumber(at);
+    default:
+      return false;
+    }
+  }
+
+  bool parseString(std::uint32_t at)
+  {
+    if (atEnd()) {
+      return false;
+    }
+
+    const std::uint32_t end = m_structurals[m_pos++];
+    if (!validEscapes(at + 1, end)) {
+      return false;
+    }
+
+    push(NodeType::String, at + 1, end - at - 1);
+    return true;
+  }
+
+  // a \u escape needs four characters before the end of the string, the old
+  // parser failed when they were missing
+  bool validEscapes(std::uint32_t begin, std::uint32_t end) const
+  {
+    const char* p       = m_data + begin;
+    const char* const e = m_data + end;
+
+    while (p < e) {
+      const char* bs = static_cast<const char*>(std::memchr(p, '\\', e - p));
+      if (bs == nullptr) {
+        break;
       }
 
-      // Get the next token
-      token = nextToken(json, index);
+      if (bs[1] == 'u' && e - (bs + 2) < 4) {
+        return false;
+      }
 
-      // If the next token is not a colon, flag the failure
-      // return an empty QVariant
-      if (token != JsonTokenColon) {
-        success = false;
-        return QVariant(QVariantMap());
+      p = bs + 2;
+    }
+
+    return true;
+  }
+
+  bool parseLiteral(std::uint32_t at, std::string_view literal, NodeType type)
+  {
+    if (m_size - at < literal.size() ||
+        std::memcmp(m_data + at, literal.data(), literal.size()) != 0 ||
+        !endsScalar(at + literal.size())) {
+      return false;
+    }
+
+    push(type, at, static_cast<std::uint32_t>(literal.size()));
+    return true;
+  }
+
+  bool parseNumber(std::uint32_t at)
+  {
+    // same characters the old parser accepted, the conversion sorts out the
+    // rest
+    std::size_t end = at;
+    while (end < m_size && std::string_view("0123456789+-.eE").find(m_data[end]) !=
+                               std::string_view::npos) {
+      ++end;
+    }
+
+    if (!endsScalar(end)) {
+      return false;
+    }
+
+    push(NodeType::Number, at, static_cast<std::uint32_t>(end - at));
+    return true;
+  }
+
+  bool parseContainer(std::uint32_t at, int depth, bool object)
+  {
+    const std::uint32_t index =
+        push(object ? NodeType::Object : NodeType::Array, at, 0);
+    const char close    = object ? '}' : ']';
+    std::uint32_t count = 0;
+
+    for (;;) {
+      if (atEnd()) {
+        return false;
       }
 
-      // Parse the key/value pair's value
-      QVariant value = parseValue(json, index, success);
+      const char c = peek();
+
+      if (c == close) {
+        ++m_pos;
+        break;
+      }
 
-      if (!success) {
-        return QVariantMap();
+      // stray commas have always been tolerated
+      if (c == ',') {
+        ++m_pos;
+        continue;
       }
 
-      // Assign the value to the key in the map
-      map[name] = value;
+      if (object) {
+        if (c != '"' || !parseString(m_structurals[m_pos++])) {
+          return false;
+        }
+
+        if (atEnd() || peek() != ':') {
+          return false;
+        }
+
+        ++m_pos;
+      }
+
+      if (!parseValue(depth + 1)) {
+        return false;
+      }
+
+      ++count;
     }
+
+    m_nodes[index].length = count;
+    m_nodes[index].next   = static_cast<std::uint32_t>(m_nodes.size());
+
+    return true;
   }
+};
+
+bool buildTape(Tape& tape)
+{
+  const char* data       = tape.data.constData();
+  const std::size_t size = static_cast<std::size_t>(tape.data.size());
 
-  // Return the map successfully
-  return QVariant(map);
+  // offsets are stored as 32 bits
+  if (size == 0 || size >= std::numeric_limits<std::uint32_t>::max() - 64) {
+    return false;
+  }
+
+  std::vector<std::uint32_t> structurals;
+  if (!findStructurals(data, size, structurals)) {
+    return false;
+  }
+
+  tape.nodes.reserve(structurals.size() / 2 + 1);
+
+  if (!TapeBuilder(data, size, structurals, tape.nodes).build()) {
+    tape.nodes.clear();
+    return false;
+  }
+
+  return true;
 }
 
-/**
- * parseArray
- */
-static QVariant parseArray(const QString& json, int& index, bool& success)
+int hexValue(char c)
 {
-  QVariantList list;
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+
+  return -1;
+}
 
-  nextToken(json, index);
+QString decodeString(const Tape& tape, const Node& node)
+{
+  const char* p   = tape.data.constData() + node.offset;
+  const char* end = p + node.length;
 
-  bool done = false;
-  while (!done) {
-    int token = lookAhead(json, index);
+  const char* bs = static_cast<const char*>(std::memchr(p, '\\', node.length));
+  if (bs == nullptr) {
+    return QString::fromUtf8(p, node.length);
+  }
+
+  QString s;
+  s.reserve(node.length);
 
-    if (token == JsonTokenNone) {
-      success = false;
-      return QVariantList();
-    } else if (token == JsonTokenComma) {
-      nextToken(json, index);
-    } else if (token == JsonTokenSquaredClose) {
-      nextToken(json, index);
+  while (bs != nullptr) {
+    s.append(QString::fromUtf8(p, bs - p));
+    p = bs + 2;
+
+    // same set of escapes as the old parser, unknown ones are dropped
+    switch (bs[1]) {
+    case '"':
+      s.append(QChar('"'));
       break;
-    } else {
-      QVariant value = parseValue(json, index, success);
-      if (!success) {
-        return QVariantList();
+    case '\\':
+      s.append(QChar('\\'));
+      break;
+    case '/':
+      s.append(QChar('/'));
+      break;
+    case 'b':
+      s.append(QChar('\b'));
+      break;
+    case 'f':
+      s.append(QChar('\f'));
+      break;
+    case 'n':
+      s.append(QChar('\n'));
+      break;
+    case 'r':
+      s.append(QChar('\r'));
+      break;
+    case 't':
+      s.append(QChar('\t'));
+      break;
+    case 'u': {
+      if (end - p < 4) {
+        return s;
+      }
+
+      // surrogate pairs come as two escapes and end up as two UTF-16 code units
+      // next to each other, which is exactly what QString wants
+      char16_t symbol = 0;
+      for (int i = 0; i < 4; ++i) {
+        const int v = hexValue(p[i]);
+        if (v < 0) {
+          symbol = 0;
+          break;
+        }
+        symbol = static_cast<char16_t>((symbol << 4) | v);
       }
-      list.push_back(value);
+
+      s.append(QChar(symbol));
+      p += 4;
+      break;
+    }
     }
+
+    bs = static_cast<const char*>(std::memchr(p, '\\', end - p));
   }
 
-  return QVariant(list);
+  s.append(QString::fromUtf8(p, end - p));
+  return s;
 }
 
-/**
- * parseString
- */
-static QVariant parseString(const QString& json, int& index, bool& success)
+// same types as the old parser: a double if there is a dot, otherwise the
+// smallest of int/qlonglong for negative and uint/qulonglong for positive
+// numbers, and the raw text if nothing fits
+//
+QVariant decodeNumber(const Tape& tape, const Node& node)
 {
-  QString s;
-  QChar c;
-
-  eatWhitespace(json, index);
+  const char* p = tape.data.constData() + node.offset;
+  const std::string_view text(p, node.length);
 
-  c = json[index++];
+  if (text.find('.') != std::string_view::npos) {
+    double d          = 0.0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), d);
 
-  bool complete = false;
-  while (!complete) {
-    if (index == json.size()) {
-      break;
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+      d = 0.0;
     }
 
-    c = json[index++];
+    return QVariant(d);
+  }
 
-    if (c == '\"') {
-      complete = true;
+  const bool negative           = text.starts_with('-');
+  const std::string_view digits = negative ? text.substr(1) : text;
+
+  std::uint64_t value = 0;
+  bool valid          = !digits.empty();
+
+  for (char c : digits) {
+    if (c < '0' || c > '9' || value > (std::numeric_limits<std::uint64_t>::max() -
+                                       static_cast<std::uint64_t>(c - '0')) /
+                                          10) {
+      valid = false;
       break;
-    } else if (c == '\\') {
-      if (index == json.size()) {
-        break;
-      }
+    }
 
-      c = json[index++];
-
-      if (c == '\"') {
-        s.append('\"');
-      } else if (c == '\\') {
-        s.append('\\');
-      } else if (c == '/') {
-        s.append('/');
-      } else if (c == 'b') {
-        s.append('\b');
-      } else if (c == 'f') {
-        s.append('\f');
-      } else if (c == 'n') {
-        s.append('\n');
-      } else if (c == 'r') {
-        s.append('\r');
-      } else if (c == 't') {
-        s.append('\t');
-      } else if (c == 'u') {
-        qsizetype remainingLength = json.size() - index;
-        if (remainingLength >= 4) {
-          QString unicodeStr = json.mid(index, 4);
-
-          int symbol = unicodeStr.toInt(0, 16);
-
-          s.append(QChar(symbol));
-
-          index += 4;
-        } else {
-          break;
-        }
+    value = value * 10 + static_cast<std::uint64_t>(c - '0');
+  }
+
+  if (valid) {
+    if (negative) {
+      if (value <= std::uint64_t(1) << 31) {
+        return QVariant(static_cast<int>(-static_cast<std::int64_t>(value)));
+      } else if (value <= std::uint64_t(1) << 63) {
+        return QVariant(static_cast<qlonglong>(0 - value));
       }
     } else {
-      s.append(c);
+      if (value <= std::numeric_limits<uint>::max()) {
+        return QVariant(static_cast<uint>(value));
+      }
+      return QVariant(static_cast<qulonglong>(value));
     }
   }
 
-  if (!complete) {
-    success = false;
-    return QVariant();
+  return QVariant(QString::fromUtf8(text.data(), text.size()));
+}
+
+bool keyEquals(const Tape& tape, const Node& node, QAnyStringView key)
+{
+  const char* p = tape.data.constData() + node.offset;
+
+  if (std::memchr(p, '\\', node.length) == nullptr) {
+    return QAnyStringView::equal(QUtf8StringView(p, node.length), key);
   }
 
-  return QVariant(s);
+  return QAnyStringView::equal(decodeString(tape, node), key);
 }
 
-/**
- * parseNumber
- */
-static QVariant parseNumber(const QString& json, int& index)
+QVariant toVariant(const Tape& tape, std::uint32_t index)
 {
-  eatWhitespace(json, index);
+  const Node& node = tape.nodes[index];
+
+  switch (node.type) {
+  case NodeType::Null:
+    return QVariant();
+
+  case NodeType::True:
+    return QVariant(true);
 
-  int lastIndex  = lastIndexOfNumber(json, index);
-  int charLength = (lastIndex - index) + 1;
-  QString numberStr;
+  case NodeType::False:
+    return QVariant(false);
+
+  case NodeType::Number:
+    return decodeNumber(tape, node);
 
-  numberStr = json.mid(index, charLength);
+  case NodeType::String:
+    return QVariant(decodeString(tape, node));
 
-  index = lastIndex + 1;
-  bool ok;
+  case NodeType::Array: {
+    QVariantList list;
+    list.reserve(node.length);
 
-  if (numberStr.contains('.')) {
-    return QVariant(numberStr.toDouble(nullptr));
-  } else if (numberStr.startsWith('-')) {
-    int i = numberStr.toInt(&ok);
-    if (!ok) {
-      qlonglong ll = numberStr.toLongLong(&ok);
-      return ok ? ll : QVariant(numberStr);
+    for (std::uint32_t child = index + 1; child < node.next;
+         child               = tape.nodes[child].next) {
+      list.push_back(toVariant(tape, child));
     }
-    return i;
-  } else {
-    uint u = numberStr.toUInt(&ok);
-    if (!ok) {
-      qulonglong ull = numberStr.toULongLong(&ok);
-      return ok ? ull : QVariant(numberStr);
+
+    return list;
+  }
+
+  case NodeType::Object: {
+    QVariantMap map;
+
+    for (std::uint32_t child = index + 1; child < node.next;) {
+      QString key = decodeString(tape, tape.nodes[child]);
+      ++child;
+
+      map.insert(key, toVariant(tape, child));
+      child = tape.nodes[child].next;
     }
-    return u;
+
+    return map;
+  }
   }
+
+  return QVariant();
 }
 
-/**
- * lastIndexOfNumber
- */
-static int lastIndexOfNumber(const QString& json, int index)
+}  // namespace
+
+Value::Value() : m_node(0) {}
+
+Value::Value(std::shared_ptr<const detail::Tape> tape, std::uint32_t node)
+    : m_tape(std::move(tape)), m_node(node)
+{}
+
+Value::Type Value::type() const
 {
-  int lastIndex;
+  if (!m_tape) {
+    return Type::Invalid;
+  }
 
-  for (lastIndex = index; lastIndex < json.size(); lastIndex++) {
-    if (QString("0123456789+-.eE").indexOf(json[lastIndex]) == -1) {
-      break;
-    }
+  switch (m_tape->nodes[m_node].type) {
+  case NodeType::Null:
+    return Type::Null;
+  case NodeType::True:
+  case NodeType::False:
+    return Type::Bool;
+  case NodeType::Number:
+    return Type::Number;
+  case NodeType::String:
+    return Type::String;
+  case NodeType::Array:
+    return Type::Array;
+  case NodeType::Object:
+    return Type::Object;
   }
 
-  return lastIndex - 1;
+  return Type::Invalid;
 }
 
-/**
- * eatWhitespace
- */
-static void eatWhitespace(const QString& json, int& index)
+bool Value::toBool() const
 {
-  for (; index < json.size(); index++) {
-    if (QString(" \t\n\r").indexOf(json[index]) == -1) {
-      break;
-    }
+  return m_tape && m_tape->nodes[m_node].type == NodeType::True;
+}
+
+double Value::toDouble() const
+{
+  if (!isNumber()) {
+    return 0.0;
   }
+
+  const Node& node = m_tape->nodes[m_node];
+  const char* p    = m_tape->data.constData() + node.offset;
+
+  double d          = 0.0;
+  const auto result = std::from_chars(p, p + node.length, d);
+
+  return result.ec == std::errc() ? d : 0.0;
 }
 
-/**
- * lookAhead
- */
-static int lookAhead(const QString& json, int index)
+QString Value::toString() const
 {
-  int saveIndex = index;
-  return nextToken(json, saveIndex);
+  if (!m_tape) {
+    return {};
+  }
+
+  const Node& node = m_tape->nodes[m_node];
+
+  switch (node.type) {
+  case NodeType::String:
+    return decodeString(*m_tape, node);
+  case NodeType::Number:
+    return QString::fromLatin1(m_tape->data.constData() + node.offset, node.length);
+  default:
+    return {};
+  }
 }
 
-/**
- * nextToken
- */
-static int nextToken(const QString& json, int& index)
-{
-  eatWhitespace(json, index);
-
-  if (index == json.size()) {
-    return JsonTokenNone;
-  }
-
-  QChar c = json[index];
-  index++;
-  switch (c.toLatin1()) {
-  case '{':
-    return JsonTokenCurlyOpen;
-  case '}':
-    return JsonTokenCurlyClose;
-  case '[':
-    return JsonTokenSquaredOpen;
-  case ']':
-    return JsonTokenSquaredClose;
-  case ',':
-    return JsonTokenComma;
-  case '"':
-    return JsonTokenString;
-  case '0':
-  case '1':
-  case '2':
-  case '3':
-  case '4':
-  case '5':
-  case '6':
-  case '7':
-  case '8':
-  case '9':
-  case '-':
-    return JsonTokenNumber;
-  case ':':
-    return JsonTokenColon;
-  }
-  index--;  // ^ WTF?
-
-  qsizetype remainingLength = json.size() - index;
-
-  // True
-  if (remainingLength >= 4) {
-    if (json[index] == 't' && json[index + 1] == 'r' && json[index + 2] == 'u' &&
-        json[index + 3] == 'e') {
-      index += 4;
-      return JsonTokenTrue;
-    }
+qsizetype Value::size() const
+{
+  if (!isArray() && !isObject()) {
+    return 0;
   }
 
-  // False
-  if (remainingLength >= 5) {
-    if (json[index] == 'f' && json[index + 1] == 'a' && json[index + 2] == 'l' &&
-        json[index + 3] == 's' && json[index + 4] == 'e') {
-      index += 5;
-      return JsonTokenFalse;
-    }
+  return m_tape->nodes[m_node].length;
+}
+
+Value Value::at(qsizetype i) const
+{
+  if (i < 0 || i >= size()) {
+    return {};
+  }
+
+  const bool object   = isObject();
+  std::uint32_t child = m_node + 1;
+
+  for (qsizetype k = 0; k < i; ++k) {
+    child = m_tape->nodes[object ? child + 1 : child].next;
+  }
+
+  return Value(m_tape, object ? child + 1 : child);
+}
+
+QString Value::keyAt(qsizetype i) const
+{
+  if (!isObject() || i < 0 || i >= size()) {
+    return {};
+  }
+
+  std::uint32_t child = m_node + 1;
+
+  for (qsizetype k = 0; k < i; ++k) {
+    child = m_tape->nodes[child + 1].next;
+  }
+
+  return decodeString(*m_tape, m_tape->nodes[child]);
+}
+
+QStringList Value::keys() const
+{
+  QStringList list;
+
+  if (!isObject()) {
+    return list;
+  }
+
+  const Node& node = m_tape->nodes[m_node];
+  list.reserve(node.length);
+
+  for (std::uint32_t child = m_node + 1; child < node.next;
+       child               = m_tape->nodes[child + 1].next) {
+    list.push_back(decodeString(*m_tape, m_tape->nodes[child]));
+  }
+
+  return list;
+}
+
+Value Value::value(QAnyStringView key) const
+{
+  if (!isObject()) {
+    return {};
   }
 
-  // Null
-  if (remainingLength >= 4) {
-    if (json[index] == 'n' && json[index + 1] == 'u' && json[index + 2] == 'l' &&
-        json[index + 3] == 'l') {
-      index += 4;
-      return JsonTokenNull;
+  const Node& node = m_tape->nodes[m_node];
+
+  for (std::uint32_t child = m_node + 1; child < node.next;
+       child               = m_tape->nodes[child + 1].next) {
+    if (keyEquals(*m_tape, m_tape->nodes[child], key)) {
+      return Value(m_tape, child + 1);
     }
   }
 
-  return JsonTokenNone;
+  return {};
+}
+
+QVariant Value::toVariant() const
+{
+  if (!m_tape) {
+    return {};
+  }
+
+  return QtJson::toVariant(*m_tape, m_node);
+}
+
+Document::Document() = default;
+
+Document Document::parse(const QByteArray& json)
+{
+  auto tape  = std::make_shared<Tape>();
+  tape->data = json;
+
+  Document doc;
+  if (buildTape(*tape)) {
+    doc.m_tape = std::move(tape);
+  }
+
+  return doc;
+}
+
+bool Document::isValid() const
+{
+  return m_tape != nullptr;
 }
+
+Value Document::root() const
+{
+  if (!m_tape) {
+    return {};
+  }
+
+  return Value(m_tape, 0);
+}
+
 }  // namespace QtJson
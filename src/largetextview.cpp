@@ -0,0 +1,775 @@
+#include "largetextview.h"
+#include "log.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QFile>
+#include <QFontDatabase>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QPromise>
+#include <QScrollBar>
+#include <QTextLayout>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+
+namespace MOBase
+{
+
+namespace
+{
+
+  // lines are indexed in chunks of this many bytes
+  constexpr qint64 IndexChunkSize = 4 * 1024 * 1024;
+
+  // only this many bytes of a line are shown, some crash dumps have lines that are
+  // megabytes long
+  constexpr qint64 MaxLineBytes = 64 * 1024;
+
+  constexpr int LeftMargin = 4;
+
+  // a file that grew is only considered the same file if it starts with the same
+  // bytes
+  constexpr qint64 HeadSize = 256;
+
+  QThreadPool& indexThreadPool()
+  {
+    static QThreadPool pool;
+    return pool;
+  }
+
+}  // namespace
+
+// bytes read from a followed file, what is appended later is written after the bytes
+// that were read as long as there is room, the mappings that share the buffer only
+// read up to their own size
+struct LargeTextView::Buffer
+{
+  std::unique_ptr<char[]> bytes;
+  qint64 capacity = 0;
+};
+
+struct LargeTextView::Mapping
+{
+  QString fileName;
+
+  // either the file is mapped, or it was read in a buffer because it is followed; a
+  // mapped file that is truncated crashes the process and cannot be rotated on
+  // windows
+  QFile file;
+  uchar* mapped = nullptr;
+  std::shared_ptr<Buffer> buffer;
+
+  qint64 size = 0;
+
+  ~Mapping()
+  {
+    if (mapped != nullptr) {
+      file.unmap(mapped);
+    }
+  }
+
+  const char* data() const
+  {
+    return buffer ? buffer->bytes.get() : reinterpret_cast<const char*>(mapped);
+  }
+};
+
+struct LargeTextView::Indexer
+{
+  // keeps the file mapped while the workers run
+  std::shared_ptr<const Mapping> mapping;
+  qint64 begin = 0;
+  qint64 end   = 0;
+
+  // starts of the lines found in each chunk
+  std::vector<std::vector<qint64>> chunks;
+
+  std::atomic<qint64> next    = 0;
+  std::atomic<qint64> done    = 0;
+  std::atomic<bool> cancelled = false;
+  QPromise<void> promise;
+
+  qint64 chunkCount() const
+  {
+    return (end - begin + IndexChunkSize - 1) / IndexChunkSize;
+  }
+
+  // indexes chunks until none are left, the thread that indexes the last one
+  // finishes the promise
+  void work()
+  {
+    const char* data   = mapping->data();
+    const qint64 count = chunkCount();
+
+    for (qint64 chunk = next++; chunk < count; chunk = next++) {
+      if (!cancelled) {
+        const char* p    = data + begin + chunk * IndexChunkSize;
+        const char* last = data + std::min(end, begin + (chunk + 1) * IndexChunkSize);
+        auto& starts     = chunks[static_cast<std::size_t>(chunk)];
+
+        while ((p = static_cast<const char*>(
+                    std::memchr(p, '\n', static_cast<std::size_t>(last - p)))) !=
+               nullptr) {
+          ++p;
+          starts.push_back(p - data);
+        }
+      }
+
+      if (++done == count) {
+        promise.finish();
+      }
+    }
+  }
+};
+
+LargeTextView::LargeTextView(QWidget* parent)
+    : QAbstractScrollArea(parent), m_begin(0), m_longestLine(0),
+      m_search(new TextSearch(this)), m_match{-1, -1}, m_anchorLine(-1),
+      m_cursorLine(-1), m_stickToBottom(false)
+{
+  setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  setFocusPolicy(Qt::StrongFocus);
+  viewport()->setCursor(Qt::IBeamCursor);
+
+  m_textOption.setWrapMode(QTextOption::NoWrap);
+  m_textOption.setTabStopDistance(fontMetrics().horizontalAdvance(QLatin1Char(' ')) *
+                                  8);
+
+  connect(m_search, &TextSearch::matchesChanged, viewport(), [this] {
+    viewport()->update();
+  });
+}
+
+LargeTextView::~LargeTextView()
+{
+  if (m_indexer) {
+    m_indexer->cancelled = true;
+  }
+}
+
+bool LargeTextView::open(const QString& fileName)
+{
+  auto mapping = map(fileName);
+  if (!mapping) {
+    return false;
+  }
+
+  setMapping(std::move(mapping));
+  return true;
+}
+
+bool LargeTextView::refresh()
+{
+  if (!m_mapping) {
+    return false;
+  }
+
+  // the file is only opened while it is read, so it can be rotated
+  QFile file(fileName());
+  if (!file.open(QIODevice::ReadOnly)) {
+    // a rotated file may not have been created again yet
+    return true;
+  }
+
+  // a mapped file is read in memory even if it did not change
+  const qint64 fileSize = file.size();
+  if (fileSize == size() && m_mapping->buffer) {
+    return true;
+  }
+
+  const bool atBottom =
+      verticalScrollBar()->value() == verticalScrollBar()->maximum();
+
+  // the file was truncated, or replaced if the start of the file changed
+  const qint64 head = std::min(size(), HeadSize);
+  if (fileSize < size() ||
+      file.peek(head) != QByteArrayView(data(), static_cast<qsizetype>(head))) {
+    auto mapping = read(file, nullptr);
+    if (!mapping) {
+      return false;
+    }
+
+    setMapping(std::move(mapping));
+    m_stickToBottom = atBottom;
+    return true;
+  }
+
+  auto mapping = read(file, m_mapping);
+  if (!mapping) {
+    return false;
+  }
+
+  m_mapping       = std::move(mapping);
+  m_stickToBottom = atBottom;
+
+  // the last line may have been continued
+  startIndexing(m_lineStarts.back());
+  m_search->extendData(m_mapping, data(), size());
+  viewport()->update();
+
+  return true;
+}
+
+QString LargeTextView::fileName() const
+{
+  return m_mapping ? m_mapping->fileName : QString();
+}
+
+bool LargeTextView::isIndexed() const
+{
+  return m_mapping && !m_indexer;
+}
+
+qint64 LargeTextView::lineCount() const
+{
+  return isIndexed() ? static_cast<qint64>(m_lineStarts.size()) : 0;
+}
+
+QString LargeTextView::lineText(qint64 line) const
+{
+  if (line < 0 || line >= static_cast<qint64>(m_lineStarts.size())) {
+    return {};
+  }
+
+  return decode(lineRange(line));
+}
+
+void LargeTextView::setShowWhitespace(bool show)
+{
+  auto flags = m_textOption.flags();
+
+  if (show) {
+    flags |= QTextOption::ShowTabsAndSpaces;
+  } else {
+    flags &= ~QTextOption::ShowTabsAndSpaces;
+  }
+
+  m_textOption.setFlags(flags);
+  viewport()->update();
+}
+
+void LargeTextView::select(qint64 begin, qint64 end)
+{
+  m_match      = {begin, end};
+  m_anchorLine = -1;
+  m_cursorLine = -1;
+
+  scrollToMatch();
+  viewport()->update();
+}
+
+qint64 LargeTextView::selectionStart() const
+{
+  if (m_match.begin >= 0) {
+    return m_match.begin;
+  } else if (m_anchorLine >= 0) {
+    return lineRange(std::min(m_anchorLine, m_cursorLine)).begin;
+  } else if (m_mapping) {
+    return lineRange(verticalScrollBar()->value()).begin;
+  } else {
+    return 0;
+  }
+}
+
+qint64 LargeTextView::selectionEnd() const
+{
+  return m_match.begin >= 0 ? m_match.end : selectionStart();
+}
+
+void LargeTextView::paintEvent(QPaintEvent*)
+{
+  QPainter painter(viewport());
+
+  const int lineHeight = fontMetrics().lineSpacing();
+  const qreal x        = LeftMargin - horizontalScrollBar()->value();
+  const qint64 first   = verticalScrollBar()->value();
+  const auto lines     = visibleLines();
+
+  const qint64 firstSelected = std::min(m_anchorLine, m_cursorLine);
+  const qint64 lastSelected  = std::max(m_anchorLine, m_cursorLine);
+
+  QTextCharFormat highlighted;
+  highlighted.setBackground(palette().highlight());
+  highlighted.setForeground(palette().highlightedText());
+
+  // the other matches of the find pattern
+  QColor matchColor = palette().highlight().color();
+  matchColor.setAlpha(80);
+
+  QTextCharFormat matched;
+  matched.setBackground(matchColor);
+
+  qint64 match = lines.empty() ? 0 : m_search->indexAt(lines.front().begin);
+
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    const Range range = lines[i];
+    const qint64 line = first + static_cast<qint64>(i);
+    const int y       = static_cast<int>(i) * lineHeight;
+
+    QTextLayout layout(decode(range), font(), viewport());
+    QList<QTextLayout::FormatRange> formats;
+
+    // the given bytes of this line in characters
+    auto format = [&](Range bytes, const QTextCharFormat& style) {
+      const qint64 begin = std::max(bytes.begin, range.begin);
+      const qint64 end   = std::min(bytes.end, range.end);
+
+      if (begin - range.begin >= MaxLineBytes) {
+        return;
+      }
+
+      const auto start  = decode({range.begin, begin}).size();
+      const auto length = decode({begin, end}).size();
+
+      formats.append(QTextLayout::FormatRange{static_cast<int>(start),
+                                              static_cast<int>(length), style});
+    };
+
+    for (; match < m_search->count() && m_search->at(match).begin <= range.end;
+         ++match) {
+      const auto found = m_search->at(match);
+      format({found.begin, found.end}, matched);
+    }
+
+    if (m_anchorLine >= 0 && line >= firstSelected && line <= lastSelected) {
+      painter.fillRect(QRect(0, y, viewport()->width(), lineHeight),
+                       palette().highlight());
+      formats.append(QTextLayout::FormatRange{
+          0, static_cast<int>(layout.text().size()), highlighted});
+    } else if (m_match.begin >= range.begin && m_match.begin <= range.end) {
+      format(m_match, highlighted);
+    }
+
+    layoutLine(layout);
+    layout.draw(&painter, QPointF(x, y), formats);
+  }
+}
+
+void LargeTextView::resizeEvent(QResizeEvent* event)
+{
+  QAbstractScrollArea::resizeEvent(event);
+  updateScrollBars();
+}
+
+void LargeTextView::keyPressEvent(QKeyEvent* event)
+{
+  if (event->matches(QKeySequence::Copy)) {
+    copy();
+  } else if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+    verticalScrollBar()->setValue(0);
+  } else if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+  } else {
+    QAbstractScrollArea::keyPressEvent(event);
+  }
+}
+
+void LargeTextView::mousePressEvent(QMouseEvent* event)
+{
+  if (event->button() != Qt::LeftButton) {
+    QAbstractScrollArea::mousePressEvent(event);
+    return;
+  }
+
+  const qint64 line = lineAtY(event->position().toPoint().y());
+
+  if (m_anchorLine < 0 || !event->modifiers().testFlag(Qt::ShiftModifier)) {
+    m_anchorLine = line;
+  }
+
+  m_cursorLine = line;
+  m_match      = {-1, -1};
+
+  viewport()->update();
+}
+
+void LargeTextView::mouseMoveEvent(QMouseEvent* event)
+{
+  if (!event->buttons().testFlag(Qt::LeftButton) || m_anchorLine < 0) {
+    QAbstractScrollArea::mouseMoveEvent(event);
+    return;
+  }
+
+  const int y = event->position().toPoint().y();
+
+  // scroll while dragging outside the view
+  if (y < 0) {
+    verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+  } else if (y > viewport()->height()) {
+    verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+  }
+
+  m_cursorLine = lineAtY(y);
+  viewport()->update();
+}
+
+void LargeTextView::startIndexing(qint64 from)
+{
+  if (m_indexer) {
+    m_indexer->cancelled = true;
+  }
+
+  auto indexer     = std::make_shared<Indexer>();
+  indexer->mapping = m_mapping;
+  indexer->begin   = from;
+  indexer->end     = size();
+  indexer->chunks.resize(static_cast<std::size_t>(indexer->chunkCount()));
+
+  m_indexer = indexer;
+
+  indexer->promise.start();
+  // the continuation only holds a weak pointer, the indexer owns the promise
+  indexer->promise.future().then(this, [this, weak = std::weak_ptr(indexer)] {
+    if (auto finished = weak.lock()) {
+      onIndexed(std::move(finished));
+    }
+  });
+
+  const qint64 chunks = indexer->chunkCount();
+  if (chunks == 0) {
+    indexer->promise.finish();
+    return;
+  }
+
+  const auto workers = std::min<qint64>(indexThreadPool().maxThreadCount(), chunks);
+
+  for (qint64 i = 0; i < workers; ++i) {
+    indexThreadPool().start([indexer] {
+      indexer->work();
+    });
+  }
+}
+
+void LargeTextView::onIndexed(std::shared_ptr<Indexer> indexer)
+{
+  if (indexer != m_indexer) {
+    // another file was opened since
+    return;
+  }
+
+  m_indexer.reset();
+
+  std::size_t added = 0;
+  for (const auto& starts : indexer->chunks) {
+    added += starts.size();
+  }
+
+  // the last line that was known may have been continued by this chunk
+  const std::size_t from = m_lineStarts.size() - 1;
+
+  // the match may have been past the lines that were known
+  const bool matchWasUnknown = m_match.begin >= m_lineStarts.back();
+
+  m_lineStarts.reserve(m_lineStarts.size() + added);
+  for (const auto& starts : indexer->chunks) {
+    m_lineStarts.insert(m_lineStarts.end(), starts.begin(), starts.end());
+  }
+
+  for (std::size_t i = from; i < m_lineStarts.size(); ++i) {
+    const Range range = lineRange(static_cast<qint64>(i));
+    m_longestLine     = std::max(m_longestLine, range.end - range.begin);
+  }
+
+  updateScrollBars();
+
+  if (m_stickToBottom) {
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    m_stickToBottom = false;
+  } else if (matchWasUnknown) {
+    scrollToMatch();
+  }
+
+  viewport()->update();
+  emit indexed();
+}
+
+void LargeTextView::setMapping(std::shared_ptr<const Mapping> mapping)
+{
+  m_mapping = std::move(mapping);
+
+  const char* bom = "\xef\xbb\xbf";
+  m_begin         = (size() >= 3 && std::memcmp(data(), bom, 3) == 0) ? 3 : 0;
+
+  m_lineStarts  = {m_begin};
+  m_longestLine = 0;
+  m_match       = {-1, -1};
+  m_anchorLine  = -1;
+  m_cursorLine  = -1;
+
+  m_stickToBottom = false;
+
+  verticalScrollBar()->setValue(0);
+  horizontalScrollBar()->setValue(0);
+
+  startIndexing(m_begin);
+  m_search->setData(m_mapping, data(), m_begin, size());
+  updateScrollBars();
+  viewport()->update();
+}
+
+std::shared_ptr<LargeTextView::Mapping> LargeTextView::map(const QString& fileName)
+{
+  auto mapping      = std::make_shared<Mapping>();
+  mapping->fileName = fileName;
+  mapping->file.setFileName(fileName);
+
+  if (!mapping->file.open(QIODevice::ReadOnly)) {
+    log::error("failed to open '{}': {}", fileName, mapping->file.errorString());
+    return nullptr;
+  }
+
+  mapping->size = mapping->file.size();
+
+  if (mapping->size > 0) {
+    mapping->mapped = mapping->file.map(0, mapping->size);
+
+    if (mapping->mapped == nullptr) {
+      log::error("failed to map '{}': {}", fileName, mapping->file.errorString());
+      return nullptr;
+    }
+  }
+
+  return mapping;
+}
+
+std::shared_ptr<LargeTextView::Mapping>
+LargeTextView::read(QFile& file, const std::shared_ptr<const Mapping>& previous)
+{
+  // a mapped file is read again from the start, only a buffer is appended to
+  const bool append = previous && previous->buffer;
+  const qint64 from = append ? previous->size : 0;
+  const qint64 size = std::max(file.size(), from);
+
+  auto mapping      = std::make_shared<Mapping>();
+  mapping->fileName = file.fileName();
+
+  // the bytes that were read before are only copied if the buffer is full
+  if (append && previous->buffer->capacity >= size) {
+    mapping->buffer = previous->buffer;
+  } else {
+    const qint64 capacity = size + size / 2;
+
+    mapping->buffer           = std::make_shared<Buffer>();
+    mapping->buffer->capacity = capacity;
+    mapping->buffer->bytes    = std::make_unique_for_overwrite<char[]>(
+        static_cast<std::size_t>(capacity));
+
+    if (from > 0) {
+      std::memcpy(mapping->buffer->bytes.get(), previous->data(),
+                  static_cast<std::size_t>(from));
+    }
+  }
+
+  if (!file.seek(from)) {
+    log::error("failed to read '{}': {}", file.fileName(), file.errorString());
+    return nullptr;
+  }
+
+  // the file may have been truncated since its size was checked
+  const qint64 read = file.read(mapping->buffer->bytes.get() + from, size - from);
+  if (read < 0) {
+    log::error("failed to read '{}': {}", file.fileName(), file.errorString());
+    return nullptr;
+  }
+
+  mapping->size = from + read;
+  return mapping;
+}
+
+const char* LargeTextView::data() const
+{
+  return m_mapping ? m_mapping->data() : nullptr;
+}
+
+qint64 LargeTextView::size() const
+{
+  return m_mapping ? m_mapping->size : 0;
+}
+
+LargeTextView::Range LargeTextView::lineRange(qint64 line) const
+{
+  const auto index  = static_cast<std::size_t>(line);
+  const qint64 begin = m_lineStarts[index];
+  qint64 end         = size();
+
+  if (index + 1 < m_lineStarts.size()) {
+    end = m_lineStarts[index + 1] - 1;
+  } else if (!isIndexed() && begin < end) {
+    // the line may not end here, the rest of the file has not been indexed yet
+    const void* newline = std::memchr(data() + begin, '\n',
+                                      static_cast<std::size_t>(size() - begin));
+    if (newline != nullptr) {
+      end = static_cast<const char*>(newline) - data();
+    }
+  }
+
+  if (end > begin && data()[end - 1] == '\r') {
+    --end;
+  }
+
+  return {begin, end};
+}
+
+std::vector<LargeTextView::Range> LargeTextView::visibleLines() const
+{
+  std::vector<Range> lines;
+  if (!m_mapping) {
+    return lines;
+  }
+
+  const qint64 first = verticalScrollBar()->value();
+  const qint64 count = viewport()->height() / fontMetrics().lineSpacing() + 1;
+  const auto known   = static_cast<qint64>(m_lineStarts.size());
+
+  for (qint64 line = first; line < first + count; ++line) {
+    if (line < known) {
+      lines.push_back(lineRange(line));
+      continue;
+    }
+
+    // while indexing, the lines after the last known one are found by scanning
+    if (isIndexed() || lines.empty() || lines.back().end >= size()) {
+      break;
+    }
+
+    const qint64 end   = lines.back().end;
+    const qint64 begin = end + (data()[end] == '\r' ? 2 : 1);
+    const void* newline =
+        std::memchr(data() + begin, '\n', static_cast<std::size_t>(size() - begin));
+
+    Range range{begin, newline == nullptr ? size()
+                                          : static_cast<const char*>(newline) - data()};
+
+    if (range.end > range.begin && data()[range.end - 1] == '\r') {
+      --range.end;
+    }
+
+    lines.push_back(range);
+  }
+
+  return lines;
+}
+
+qint64 LargeTextView::lineAt(qint64 offset) const
+{
+  const auto itor = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), offset);
+  const qint64 line = (itor - m_lineStarts.begin()) - 1;
+
+  if (isIndexed() || itor != m_lineStarts.end()) {
+    return line;
+  }
+
+  // past the last known line, count the line breaks in between
+  return line + std::count(data() + m_lineStarts.back(), data() + offset, '\n');
+}
+
+qint64 LargeTextView::lineAtY(int y) const
+{
+  const qint64 line =
+      verticalScrollBar()->value() + std::max(0, y) / fontMetrics().lineSpacing();
+
+  // lines past the index cannot be selected until it is done
+  return std::min(line, static_cast<qint64>(m_lineStarts.size()) - 1);
+}
+
+QString LargeTextView::decode(Range range) const
+{
+  const qint64 length = std::min(range.end - range.begin, MaxLineBytes);
+  return QString::fromUtf8(data() + range.begin, length);
+}
+
+void LargeTextView::layoutLine(QTextLayout& layout) const
+{
+  layout.setTextOption(m_textOption);
+  layout.beginLayout();
+  layout.createLine();
+  layout.endLayout();
+}
+
+void LargeTextView::updateScrollBars()
+{
+  const QFontMetrics metrics = fontMetrics();
+  const int pageLines = std::max(1, viewport()->height() / metrics.lineSpacing());
+  const auto lines    = static_cast<qint64>(m_lineStarts.size());
+
+  verticalScrollBar()->setRange(
+      0, static_cast<int>(std::clamp<qint64>(lines - pageLines, 0, INT_MAX)));
+  verticalScrollBar()->setPageStep(pageLines);
+
+  // an estimate, tabs and multibyte characters are not accounted for
+  const qint64 width = std::min(m_longestLine, MaxLineBytes) *
+                           metrics.averageCharWidth() +
+                       2 * LeftMargin;
+
+  horizontalScrollBar()->setRange(
+      0, static_cast<int>(std::clamp<qint64>(width - viewport()->width(), 0, INT_MAX)));
+  horizontalScrollBar()->setPageStep(viewport()->width());
+  horizontalScrollBar()->setSingleStep(metrics.averageCharWidth());
+}
+
+void LargeTextView::scrollToMatch()
+{
+  const qint64 line   = lineAt(m_match.begin);
+  const int pageLines = verticalScrollBar()->pageStep();
+  const int top       = verticalScrollBar()->value();
+
+  if (line < top || line >= top + pageLines) {
+    verticalScrollBar()->setValue(static_cast<int>(
+        std::clamp<qint64>(line - pageLines / 2, 0, verticalScrollBar()->maximum())));
+  }
+
+  if (line >= static_cast<qint64>(m_lineStarts.size())) {
+    return;
+  }
+
+  const Range range = lineRange(line);
+  if (m_match.begin - range.begin >= MaxLineBytes) {
+    return;
+  }
+
+  QTextLayout layout(decode(range), font(), viewport());
+  layoutLine(layout);
+
+  const QTextLine textLine = layout.lineAt(0);
+
+  const auto start = decode({range.begin, m_match.begin}).size();
+  const auto end   = decode({range.begin, std::min(m_match.end, range.end)}).size();
+
+  const int left  = LeftMargin + static_cast<int>(textLine.cursorToX(int(start)));
+  const int right = LeftMargin + static_cast<int>(textLine.cursorToX(int(end)));
+  const int view  = horizontalScrollBar()->value();
+
+  if (left < view || right > view + viewport()->width()) {
+    horizontalScrollBar()->setValue(left - viewport()->width() / 4);
+  }
+}
+
+void LargeTextView::copy() const
+{
+  QString text;
+
+  if (m_match.begin >= 0) {
+    text = QString::fromUtf8(data() + m_match.begin, m_match.end - m_match.begin);
+  } else if (m_anchorLine >= 0) {
+    const qint64 begin = std::min(m_anchorLine, m_cursorLine);
+    const qint64 end   = std::max(m_anchorLine, m_cursorLine);
+
+    for (qint64 line = begin; line <= end; ++line) {
+      const Range range = lineRange(line);
+      text += QString::fromUtf8(data() + range.begin, range.end - range.begin);
+
+      if (line < end) {
+        text += QLatin1Char('\n');
+      }
+    }
+  }
+
+  if (!text.isEmpty()) {
+    QApplication::clipboard()->setText(text);
+  }
+}
+
+}  // namespace MOBase
@@ -8,13 +8,16 @@
 
 #include "linux/icoutils.h"
 #include "linux/peextractor.h"
+#include "linux/peinfo.h"
 #include <QBuffer>
 #include <QFile>
 #include <QIODevice>
 #include <QImage>
 #include <QImageReader>
 #include <QList>
+#include <QtEndian>
 #include <QtTypes>
+#include <span>
 
 namespace
 {
@@ -40,24 +43,197 @@ qreal distance(int width, int height, int desiredWidth, int desiredHeight, int d
   return targetSamples - effectiveSamples;
 }
 
-}  // namespace
+using IconImage = PeExtractor::IconImage;
 
-bool IcoUtils::loadIcoImageFromExe(QIODevice* inputDevice, QImage& image, int needWidth,
-                                   int needHeight)
+// a width or height of 0 in an icon directory means 256
+int iconDimension(quint8 value)
+{
+  return value == 0 ? 256 : value;
+}
+
+// bit count of an icon directory entry, older files only set the color count
+int iconDepth(const peTypes::RtGroupIconDirectoryEntry& entry)
+{
+  if (entry.bpp != 0) {
+    return std::min<int>(entry.bpp, 32);
+  }
+
+  if (entry.colorCount == 2) {
+    return 1;
+  } else if (entry.colorCount != 0 && entry.colorCount <= 16) {
+    return 4;
+  }
+
+  return 8;
+}
+
+// picks the image closest to the requested size from the directory entries alone,
+// returns -1 if there is none
+template <class Icons>
+qsizetype bestIcon(const Icons& icons, int needWidth, int needHeight)
+{
+  qsizetype index = -1;
+  qreal best      = std::numeric_limits<qreal>::max();
+
+  for (qsizetype i = 0; i < icons.size(); ++i) {
+    const auto& entry = icons[i].entry;
+
+    const qreal dist = distance(iconDimension(entry.width), iconDimension(entry.height),
+                                needWidth, needHeight, iconDepth(entry));
+
+    if (dist < best) {
+      index = i;
+      best  = dist;
+    }
+  }
+
+  return index;
+}
+
+// decodes a single image of an icon group, PNG images are decoded directly and
+// bitmaps are wrapped in a .ico with only that image
+QImage decodeIcon(const peTypes::RtGroupIconDirectoryEntry& entry,
+                  const QByteArray& data)
 {
-  QBuffer iconData;
-  if (!iconData.open(QIODevice::ReadWrite)) {
+  if (data.startsWith("\x89PNG")) {
+    return QImage::fromData(data, "PNG");
+  }
+
+  QByteArray ico;
+  ico.reserve(peTypes::IconDirSize + peTypes::IconDirEntrySize + data.size());
+
+  auto append = [&ico](auto value) {
+    const auto le = qToLittleEndian(value);
+    ico.append(reinterpret_cast<const char*>(&le), sizeof(le));
+  };
+
+  // header, always 1 for ico files
+  append(quint16(0));
+  append(quint16(1));
+  append(quint16(1));
+
+  // entry
+  append(entry.width);
+  append(entry.height);
+  append(entry.colorCount);
+  append(entry.reserved);
+  append(entry.numPlanes);
+  append(entry.bpp);
+  append(quint32(data.size()));
+  append(quint32(peTypes::IconDirSize + peTypes::IconDirEntrySize));
+
+  ico.append(data);
+
+  QBuffer buffer(&ico);
+  buffer.open(QIODevice::ReadOnly);
+
+  QImageReader reader(&buffer, "ico");
+  return reader.read();
+}
+
+QImage decodeIcon(const IconImage& icon)
+{
+  const QByteArray data =
+      QByteArray::fromRawData(reinterpret_cast<const char*>(icon.data.data()),
+                              static_cast<qsizetype>(icon.data.size()));
+
+  return decodeIcon(icon.entry, data);
+}
+
+bool loadBestIcon(const QList<IconImage>& icons, QImage& image, int needWidth,
+                  int needHeight)
+{
+  const qsizetype index = bestIcon(icons, needWidth, needHeight);
+  if (index < 0) {
     return false;
   }
 
-  if (!PeExtractor::loadIconData(inputDevice, &iconData))
+  QImage decoded = decodeIcon(icons[index]);
+  if (decoded.isNull()) {
     return false;
+  }
+
+  image = std::move(decoded);
+  return true;
+}
 
-  if (!iconData.seek(0)) {
+// lets Qt decode every image of the .ico file and picks the best one, for files whose
+// directory doesn't match their contents
+bool loadAllIcons(QByteArray icoData, QImage& image, int needWidth, int needHeight)
+{
+  QBuffer buffer(&icoData);
+  if (!buffer.open(QIODevice::ReadOnly)) {
     return false;
   }
 
-  return IcoUtils::loadIcoImage(&iconData, image, needWidth, needHeight);
+  QImageReader reader(&buffer, "ico");
+  return IcoUtils::loadIcoImage(reader, image, needWidth, needHeight);
+}
+
+// the images of an .ico file, empty if the directory is invalid
+QList<IconImage> icoImages(const QByteArray& icoData)
+{
+  const auto* data  = reinterpret_cast<const uchar*>(icoData.constData());
+  const auto length = static_cast<quint64>(icoData.size());
+
+  if (length < peTypes::IconDirSize) {
+    return {};
+  }
+
+  const auto reserved = qFromLittleEndian<quint16>(data);
+  const auto type     = qFromLittleEndian<quint16>(data + 2);
+  const auto count    = qFromLittleEndian<quint16>(data + 4);
+
+  if (reserved != 0 || type != 1 ||
+      length < peTypes::IconDirSize + quint64(peTypes::IconDirEntrySize) * count) {
+    return {};
+  }
+
+  QList<IconImage> images;
+  images.reserve(count);
+
+  for (quint16 i = 0; i < count; ++i) {
+    const uchar* p = data + peTypes::IconDirSize + peTypes::IconDirEntrySize * i;
+
+    peTypes::RtGroupIconDirectoryEntry entry{};
+    entry.width      = p[0];
+    entry.height     = p[1];
+    entry.colorCount = p[2];
+    entry.reserved   = p[3];
+    entry.numPlanes  = qFromLittleEndian<quint16>(p + 4);
+    entry.bpp        = qFromLittleEndian<quint16>(p + 6);
+    entry.size       = qFromLittleEndian<quint32>(p + 8);
+
+    const quint64 offset = qFromLittleEndian<quint32>(p + 12);
+    if (entry.size == 0 || offset > length || length - offset < entry.size) {
+      continue;
+    }
+
+    images.append({entry, std::span<const uchar>(data + offset, entry.size)});
+  }
+
+  return images;
+}
+
+}  // namespace
+
+bool IcoUtils::loadIcoImageFromExe(QIODevice* inputDevice, QImage& image, int needWidth,
+                                   int needHeight)
+{
+  const PeDeviceData data(inputDevice);
+  const PeExtractor extractor(data.bytes());
+
+  if (!extractor.isValid()) {
+    return false;
+  }
+
+  // the images are slices of the file, only the chosen one is decoded
+  if (loadBestIcon(extractor.primaryIcon(), image, needWidth, needHeight)) {
+    return true;
+  }
+
+  const QByteArray icoData = extractor.primaryIconFile();
+  return !icoData.isEmpty() && loadAllIcons(icoData, image, needWidth, needHeight);
 }
 
 bool IcoUtils::loadIcoImageFromExe(const QString& inputFileName, QImage& image,
@@ -72,6 +248,33 @@ bool IcoUtils::loadIcoImageFromExe(const QString& inputFileName, QImage& image,
   return IcoUtils::loadIcoImageFromExe(&inputFile, image, needWidth, needHeight);
 }
 
+bool IcoUtils::loadIcoImageFromExe(QIODevice* inputDevice, const PeInfo& info,
+                                   QImage& image, int needWidth, int needHeight)
+{
+  if (!info.isValid() || info.icons().isEmpty()) {
+    return false;
+  }
+
+  const qsizetype index = bestIcon(info.icons(), needWidth, needHeight);
+  const auto& icon      = info.icons()[index];
+
+  if (inputDevice->seek(static_cast<qint64>(icon.offset))) {
+    const QByteArray data = inputDevice->read(icon.size);
+
+    if (data.size() == static_cast<qsizetype>(icon.size)) {
+      QImage decoded = decodeIcon(icon.entry, data);
+      if (!decoded.isNull()) {
+        image = std::move(decoded);
+        return true;
+      }
+    }
+  }
+
+  // the directory doesn't match the images, or the file changed since it was read
+  return inputDevice->seek(0) &&
+         loadIcoImageFromExe(inputDevice, image, needWidth, needHeight);
+}
+
 bool IcoUtils::loadIcoImage(QImageReader& reader, QImage& image, int needWidth,
                             int needHeight)
 {
@@ -117,16 +320,30 @@ bool IcoUtils::loadIcoImage(QImageReader& reader, QImage& image, int needWidth,
   return true;
 }
 
+bool IcoUtils::loadIcoImageFromData(const QByteArray& icoData, QImage& image,
+                                    int needWidth, int needHeight)
+{
+  if (loadBestIcon(icoImages(icoData), image, needWidth, needHeight)) {
+    return true;
+  }
+
+  return loadAllIcons(icoData, image, needWidth, needHeight);
+}
+
 bool IcoUtils::loadIcoImage(QIODevice* inputDevice, QImage& image, int needWidth,
                             int needHeight)
 {
-  QImageReader reader(inputDevice, "ico");
-  return IcoUtils::loadIcoImage(reader, image, needWidth, needHeight);
+  return loadIcoImageFromData(inputDevice->readAll(), image, needWidth, needHeight);
 }
 
 bool IcoUtils::loadIcoImage(const QString& inputFileName, QImage& image, int needWidth,
                             int needHeight)
 {
-  QImageReader reader(inputFileName, "ico");
-  return IcoUtils::loadIcoImage(reader, image, needWidth, needHeight);
+  QFile inputFile{inputFileName};
+
+  if (!inputFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  return IcoUtils::loadIcoImage(&inputFile, image, needWidth, needHeight);
 }
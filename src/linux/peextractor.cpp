@@ -1,101 +1,207 @@
 #include "linux/peextractor.h"
 #include "linux/petypes.h"
+#include <QBuffer>
+#include <QDataStream>
 #include <QFile>
 #include <QIODevice>
+#include <QtEndian>
+#include <cstring>
 
 using namespace peTypes;
 
 namespace
 {
-QDataStream& operator>>(QDataStream& s, DosHeader& v)
+
+// reads little-endian values from memory, every read is checked against the end of
+// the data; once a read fails, all following reads return zeros and ok() is false
+class SpanReader
 {
-  s.readRawData(v.signature, sizeof(v.signature));
-  s.device()->skip(58);
-  s >> v.newHeaderOffset;
-  return s;
+public:
+  explicit SpanReader(std::span<const uchar> data) : m_data(data) {}
+
+  bool ok() const { return m_ok; }
+
+  bool seek(quint64 offset)
+  {
+    if (offset > m_data.size()) {
+      m_ok = false;
+      return false;
+    }
+    m_position = offset;
+    return true;
+  }
+
+  void skip(quint64 count) { seek(m_position + count); }
+
+  template <class T>
+  T read()
+  {
+    if (!m_ok || m_data.size() - m_position < sizeof(T)) {
+      m_ok = false;
+      return T{};
+    }
+
+    const T value = qFromLittleEndian<T>(m_data.data() + m_position);
+    m_position += sizeof(T);
+    return value;
+  }
+
+  void readRaw(char* out, size_t count)
+  {
+    if (!m_ok || m_data.size() - m_position < count) {
+      m_ok = false;
+      std::memset(out, 0, count);
+      return;
+    }
+
+    std::memcpy(out, m_data.data() + m_position, count);
+    m_position += count;
+  }
+
+private:
+  std::span<const uchar> m_data;
+  size_t m_position = 0;
+  bool m_ok         = true;
+};
+
+void read(SpanReader& r, DosHeader& v)
+{
+  r.readRaw(v.signature, sizeof(v.signature));
+  r.skip(58);
+  v.newHeaderOffset = r.read<quint32>();
 }
 
-QDataStream& operator>>(QDataStream& s, RtGroupIconDirectory& v)
+void read(SpanReader& r, RtGroupIconDirectory& v)
 {
-  s >> v.reserved >> v.type >> v.count;
-  return s;
+  v.reserved = r.read<quint16>();
+  v.type     = r.read<quint16>();
+  v.count    = r.read<quint16>();
 }
 
-QDataStream& operator>>(QDataStream& s, RtGroupIconDirectoryEntry& v)
+void read(SpanReader& r, RtGroupIconDirectoryEntry& v)
 {
-  s >> v.width >> v.height >> v.colorCount >> v.reserved >> v.numPlanes >> v.bpp >>
-      v.size >> v.resourceId;
-  return s;
+  v.width      = r.read<quint8>();
+  v.height     = r.read<quint8>();
+  v.colorCount = r.read<quint8>();
+  v.reserved   = r.read<quint8>();
+  v.numPlanes  = r.read<quint16>();
+  v.bpp        = r.read<quint16>();
+  v.size       = r.read<quint32>();
+  v.resourceId = r.read<quint16>();
 }
 
-QDataStream& operator<<(QDataStream& s, const IconDir& v)
+void read(SpanReader& r, PeVersionInfo& v)
 {
-  s << v.reserved << v.type << v.count;
-  return s;
+  v.StructLength = r.read<quint16>();
+  v.ValueLength  = r.read<quint16>();
+  v.StructType   = r.read<quint16>();
+  for (auto& c : v.Info) {
+    c = QChar(r.read<quint16>());
+  }
+  for (auto& p : v.Padding) {
+    p = r.read<quint8>();
+  }
+  v.Signature        = r.read<quint32>();
+  v.StructVersion[0] = r.read<quint16>();
+  v.StructVersion[1] = r.read<quint16>();
+
+  // FileVersion and ProductVersion order is [1] [0] [3] [2], not [0] [1] [2] [3]
+  // because they are stored as 32-bit values
+  for (auto* version : {v.FileVersion, v.ProductVersion}) {
+    version[1] = r.read<quint16>();
+    version[0] = r.read<quint16>();
+    version[3] = r.read<quint16>();
+    version[2] = r.read<quint16>();
+  }
+
+  v.FileFlagsMask[0] = r.read<quint32>();
+  v.FileFlagsMask[1] = r.read<quint32>();
+  v.FileFlags        = r.read<quint32>();
+  v.FileOS           = r.read<quint32>();
+  v.FileType         = r.read<quint32>();
+  v.FileSubtype      = r.read<quint32>();
+  v.FileTimestamp    = r.read<quint32>();
 }
 
-QDataStream& operator<<(QDataStream& s, const IconDirEntry& v)
+void read(SpanReader& r, PeFileHeader& v)
 {
-  s << v.width << v.height << v.colorCount << v.reserved << v.numPlanes << v.bpp
-    << v.size << v.imageOffset;
-  return s;
+  v.machine              = r.read<quint16>();
+  v.numSections          = r.read<quint16>();
+  v.timestamp            = r.read<quint32>();
+  v.offsetToSymbolTable  = r.read<quint32>();
+  v.numberOfSymbols      = r.read<quint32>();
+  v.sizeOfOptionalHeader = r.read<quint16>();
+  v.fileCharacteristics  = r.read<quint16>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeVersionInfo& v)
+void read(SpanReader& r, PeDataDirectory& v)
 {
-  // FileVersion and ProductVersion order is [1] [0] [3] [2], not [0] [1] [2] [3]
-  // because they are stored as 32-bit values
-  s >> v.StructLength >> v.ValueLength >> v.StructType >> v.Info[0] >> v.Info[1] >>
-      v.Info[2] >> v.Info[3] >> v.Info[4] >> v.Info[5] >> v.Info[6] >> v.Info[7] >>
-      v.Info[8] >> v.Info[9] >> v.Info[10] >> v.Info[11] >> v.Info[12] >> v.Info[13] >>
-      v.Info[14] >> v.Info[15] >> v.Padding[0] >> v.Padding[1] >> v.Signature >>
-      v.StructVersion[0] >> v.StructVersion[1] >> v.FileVersion[1] >>
-      v.FileVersion[0] >> v.FileVersion[3] >> v.FileVersion[2] >> v.ProductVersion[1] >>
-      v.ProductVersion[0] >> v.ProductVersion[3] >> v.ProductVersion[2] >>
-      v.FileFlagsMask[0] >> v.FileFlagsMask[1] >> v.FileFlags >> v.FileOS >>
-      v.FileType >> v.FileSubtype >> v.FileTimestamp;
-  return s;
+  v.virtualAddress = r.read<quint32>();
+  v.size           = r.read<quint32>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeFileHeader& v)
+void read(SpanReader& r, PeSection& v)
 {
-  s >> v.machine >> v.numSections >> v.timestamp >> v.offsetToSymbolTable >>
-      v.numberOfSymbols >> v.sizeOfOptionalHeader >> v.fileCharacteristics;
-  return s;
+  r.readRaw(v.name, sizeof(v.name));
+  v.virtualSize       = r.read<quint32>();
+  v.virtualAddress    = r.read<quint32>();
+  v.sizeOfRawData     = r.read<quint32>();
+  v.pointerToRawData  = r.read<quint32>();
+  v.pointerToRelocs   = r.read<quint32>();
+  v.pointerToLineNums = r.read<quint32>();
+  v.numRelocs         = r.read<quint16>();
+  v.numLineNums       = r.read<quint16>();
+  v.characteristics   = r.read<quint32>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeDataDirectory& v)
+void read(SpanReader& r, PeResourceDirectoryTable& v)
 {
-  s >> v.virtualAddress >> v.size;
-  return s;
+  v.characteristics = r.read<quint32>();
+  v.timestamp       = r.read<quint32>();
+  v.majorVersion    = r.read<quint16>();
+  v.minorVersion    = r.read<quint16>();
+  v.numNameEntries  = r.read<quint16>();
+  v.numIDEntries    = r.read<quint16>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeSection& v)
+void read(SpanReader& r, PeResourceDirectoryEntry& v)
 {
-  s.readRawData(v.name, sizeof(v.name));
-  s >> v.virtualSize >> v.virtualAddress >> v.sizeOfRawData >> v.pointerToRawData >>
-      v.pointerToRelocs >> v.pointerToLineNums >> v.numRelocs >> v.numLineNums >>
-      v.characteristics;
-  return s;
+  v.resourceId = r.read<quint32>();
+  v.offset     = r.read<quint32>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeResourceDirectoryTable& v)
+void read(SpanReader& r, PeResourceDataEntry& v)
 {
-  s >> v.characteristics >> v.timestamp >> v.majorVersion >> v.minorVersion >>
-      v.numNameEntries >> v.numIDEntries;
-  return s;
+  v.dataAddress = r.read<quint32>();
+  v.size        = r.read<quint32>();
+  v.codepage    = r.read<quint32>();
+  v.reserved    = r.read<quint32>();
 }
 
-QDataStream& operator>>(QDataStream& s, PeResourceDirectoryEntry& v)
+template <class T>
+void append(QByteArray& out, T value)
 {
-  s >> v.resourceId >> v.offset;
-  return s;
+  const T le = qToLittleEndian(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(le));
 }
 
-QDataStream& operator>>(QDataStream& s, PeResourceDataEntry& v)
+void write(QByteArray& out, const IconDir& v)
 {
-  s >> v.dataAddress >> v.size >> v.codepage >> v.reserved;
-  return s;
+  append(out, v.reserved);
+  append(out, v.type);
+  append(out, v.count);
+}
+
+void write(QByteArray& out, const IconDirEntry& v)
+{
+  append(out, v.width);
+  append(out, v.height);
+  append(out, v.colorCount);
+  append(out, v.reserved);
+  append(out, v.numPlanes);
+  append(out, v.bpp);
+  append(out, v.size);
+  append(out, v.imageOffset);
 }
 
 qint64 addressToOffset(const QVector<PeSection>& sections, quint32 rva)
@@ -114,14 +220,14 @@ qint64 addressToOffset(const QVector<PeSection>& sections, quint32 rva)
   return -1;
 }
 
-QVector<PeResourceDirectoryEntry> readResourceDataDirectoryEntry(QDataStream& ds)
+QVector<PeResourceDirectoryEntry> readResourceDataDirectoryEntry(SpanReader& r)
 {
   PeResourceDirectoryTable table{};
-  ds >> table;
+  read(r, table);
   QVector<PeResourceDirectoryEntry> entries;
-  for (int i = 0; i < table.numNameEntries + table.numIDEntries; i++) {
+  for (int i = 0; i < table.numNameEntries + table.numIDEntries && r.ok(); i++) {
     PeResourceDirectoryEntry entry{};
-    ds >> entry;
+    read(r, entry);
     entries.append(entry);
   }
   return entries;
@@ -129,17 +235,50 @@ QVector<PeResourceDirectoryEntry> readResourceDataDirectoryEntry(QDataStream& ds
 
 }  // namespace
 
+PeDeviceData::PeDeviceData(QIODevice* device)
+{
+  if (auto* file = qobject_cast<QFile*>(device); file != nullptr && file->size() > 0) {
+    m_mapped = file->map(0, file->size());
+    if (m_mapped != nullptr) {
+      m_file  = file;
+      m_bytes = {m_mapped, static_cast<size_t>(file->size())};
+      return;
+    }
+  }
+
+  if (auto* buffer = qobject_cast<QBuffer*>(device)) {
+    m_data = buffer->data();
+  } else {
+    device->seek(0);
+    m_data = device->readAll();
+  }
+
+  m_bytes = {reinterpret_cast<const uchar*>(m_data.constData()),
+             static_cast<size_t>(m_data.size())};
+}
+
+PeDeviceData::~PeDeviceData()
+{
+  if (m_mapped != nullptr) {
+    m_file->unmap(m_mapped);
+  }
+}
+
+PeExtractor::PeExtractor(std::span<const uchar> data) : m_data(data)
+{
+  m_valid = readPeData();
+}
+
 bool PeExtractor::readPeData()
 {
-  m_inputDevice->seek(0);
-  m_inputStream.setDevice(m_inputDevice);
-  m_inputStream.setByteOrder(QDataStream::LittleEndian);
+  SpanReader reader(m_data);
 
   // Read DOS header.
-  m_inputStream >> m_dosHeader;
+  DosHeader dosHeader{};
+  read(reader, dosHeader);
 
   // Verify the MZ header.
-  if (m_dosHeader.signature[0] != 'M' || m_dosHeader.signature[1] != 'Z') {
+  if (!reader.ok() || dosHeader.signature[0] != 'M' || dosHeader.signature[1] != 'Z') {
     return false;
   }
 
@@ -147,25 +286,22 @@ bool PeExtractor::readPeData()
   bool isPe32Plus;
 
   // Seek to + verify PE header. We're at the file header after this.
-  if (!m_inputDevice->seek(m_dosHeader.newHeaderOffset)) {
+  if (!reader.seek(dosHeader.newHeaderOffset)) {
     return false;
   }
 
   char signature[4];
-  if (m_inputStream.readRawData(signature, sizeof(signature)) == -1) {
-    return false;
-  }
+  reader.readRaw(signature, sizeof(signature));
 
   if (signature[0] != 'P' || signature[1] != 'E' || signature[2] != 0 ||
       signature[3] != 0) {
     return false;
   }
 
-  m_inputStream >> fileHeader;
+  read(reader, fileHeader);
 
   // Read optional header magic to determine if this is PE32 or PE32+.
-  quint16 optMagic;
-  m_inputStream >> optMagic;
+  const auto optMagic = reader.read<quint16>();
 
   switch (optMagic) {
   case PeOptionalHeaderMagicPe32:
@@ -181,21 +317,25 @@ bool PeExtractor::readPeData()
   }
 
   // Read section table now, so we can interpret RVAs.
-  quint64 sectionTableOffset = m_dosHeader.newHeaderOffset;
+  quint64 sectionTableOffset = dosHeader.newHeaderOffset;
   sectionTableOffset += PeSignatureSize + PeFileHeaderSize;
   sectionTableOffset += fileHeader.sizeOfOptionalHeader;
-  if (!m_inputStream.device()->seek(sectionTableOffset)) {
+  if (!reader.seek(sectionTableOffset)) {
     return false;
   }
 
   for (int i = 0; i < fileHeader.numSections; i++) {
     PeSection section{};
-    m_inputStream >> section;
+    read(reader, section);
     m_sections.append(section);
   }
 
+  if (!reader.ok()) {
+    return false;
+  }
+
   // Find resource directory.
-  qint64 dataDirOffset = m_dosHeader.newHeaderOffset;
+  qint64 dataDirOffset = dosHeader.newHeaderOffset;
   if (isPe32Plus) {
     dataDirOffset += PeOffsetToDataDirectoryPe32Plus;
   } else {
@@ -203,11 +343,11 @@ bool PeExtractor::readPeData()
   }
   dataDirOffset +=
       static_cast<qint64>(PeDataDirectoryIndex::Resource) * PeDataDirectorySize;
-  if (!m_inputStream.device()->seek(dataDirOffset)) {
+  if (!reader.seek(dataDirOffset)) {
     return false;
   }
   PeDataDirectory resourceDirectory{};
-  m_inputStream >> resourceDirectory;
+  read(reader, resourceDirectory);
 
   // Read resource tree.
   auto resourceOffset = addressToOffset(m_sections, resourceDirectory.virtualAddress);
@@ -215,44 +355,45 @@ bool PeExtractor::readPeData()
     return false;
   }
 
-  if (!m_inputStream.device()->seek(resourceOffset)) {
+  if (!reader.seek(resourceOffset)) {
     return false;
   }
 
-  const auto level1 = readResourceDataDirectoryEntry(m_inputStream);
+  const auto level1 = readResourceDataDirectoryEntry(reader);
 
   for (auto entry1 : level1) {
     if ((entry1.offset & PeSubdirBitMask) == 0)
       continue;
-    if (!m_inputStream.device()->seek(resourceOffset +
-                                      (entry1.offset & ~PeSubdirBitMask))) {
+    if (!reader.seek(resourceOffset + (entry1.offset & ~PeSubdirBitMask))) {
       return false;
     }
 
-    const auto level2 = readResourceDataDirectoryEntry(m_inputStream);
+    const auto level2 = readResourceDataDirectoryEntry(reader);
 
     for (auto entry2 : level2) {
       if ((entry2.offset & PeSubdirBitMask) == 0)
         continue;
-      if (!m_inputStream.device()->seek(resourceOffset +
-                                        (entry2.offset & ~PeSubdirBitMask))) {
+      if (!reader.seek(resourceOffset + (entry2.offset & ~PeSubdirBitMask))) {
         return false;
       }
 
       // Read subdirectory.
-      const auto level3 = readResourceDataDirectoryEntry(m_inputStream);
+      const auto level3 = readResourceDataDirectoryEntry(reader);
 
       for (auto entry3 : level3) {
         if ((entry3.offset & PeSubdirBitMask) == PeSubdirBitMask)
           continue;
-        if (!m_inputStream.device()->seek(resourceOffset +
-                                          (entry3.offset & ~PeSubdirBitMask))) {
+        if (!reader.seek(resourceOffset + (entry3.offset & ~PeSubdirBitMask))) {
           return false;
         }
 
         // Read data.
         PeResourceDataEntry dataEntry{};
-        m_inputStream >> dataEntry;
+        read(reader, dataEntry);
+
+        if (!reader.ok()) {
+          return false;
+        }
 
         switch (static_cast<ResourceType>(entry1.resourceId)) {
         case ResourceType::Icon:
@@ -267,115 +408,149 @@ bool PeExtractor::readPeData()
           break;
 
         case ResourceType::Version:
-          m_versionResource = dataEntry;
+          readVersionInfo(dataEntry);
           break;
         }
       }
     }
   }
 
-  return true;
+  return reader.ok();
 }
 
-bool PeExtractor::readIcon()
+std::span<const uchar>
+PeExtractor::resourceData(const PeResourceDataEntry& entry) const
 {
-  if (!m_primaryIconGroupResource.has_value()) {
-    return false;
+  const qint64 offset = addressToOffset(m_sections, entry.dataAddress);
+  if (offset < 0 || static_cast<quint64>(offset) > m_data.size() ||
+      m_data.size() - static_cast<quint64>(offset) < entry.size) {
+    return {};
   }
 
-  QDataStream ds{m_inputDevice};
-  ds.setByteOrder(QDataStream::LittleEndian);
+  return m_data.subspan(static_cast<size_t>(offset), entry.size);
+}
 
-  if (!ds.device()->seek(
-          addressToOffset(m_sections, m_primaryIconGroupResource->dataAddress))) {
-    return false;
+QList<PeExtractor::IconImage> PeExtractor::primaryIcon() const
+{
+  if (!m_primaryIconGroupResource.has_value()) {
+    return {};
   }
 
-  QDataStream out{m_outputDevice};
-  out.setByteOrder(QDataStream::LittleEndian);
+  const auto groupData = resourceData(*m_primaryIconGroupResource);
+  if (groupData.empty()) {
+    return {};
+  }
 
-  RtGroupIconDirectory primaryIconGroup{};
-  ds >> primaryIconGroup;
+  SpanReader reader(groupData);
 
-  IconDir icoFileHeader{0, 1 /*Always 1 for ico files.*/, primaryIconGroup.count};
-  out << icoFileHeader;
+  RtGroupIconDirectory primaryIconGroup{};
+  read(reader, primaryIconGroup);
 
-  quint32 dataOffset = IconDirSize + IconDirEntrySize * primaryIconGroup.count;
-  QVector<QPair<qint64, quint32>> resourceOffsetSizePairs;
+  QList<IconImage> images;
+  images.reserve(primaryIconGroup.count);
 
   for (int i = 0; i < primaryIconGroup.count; i++) {
     RtGroupIconDirectoryEntry entry{};
-    ds >> entry;
+    read(reader, entry);
 
-    IconDirEntry icoFileEntry{entry, dataOffset};
-    out << icoFileEntry;
+    if (!reader.ok()) {
+      return {};
+    }
 
-    if (auto it = m_iconResources.find(entry.resourceId); it != m_iconResources.end()) {
-      PeResourceDataEntry iconResource = *it;
-      resourceOffsetSizePairs.append(
-          {addressToOffset(m_sections, iconResource.dataAddress), iconResource.size});
-      dataOffset += iconResource.size;
-    } else {
-      return false;
+    const auto it = m_iconResources.find(entry.resourceId);
+    if (it == m_iconResources.end()) {
+      return {};
     }
-  }
 
-  for (const auto& offsetSizePair : resourceOffsetSizePairs) {
-    if (!ds.device()->seek(offsetSizePair.first)) {
-      return false;
+    const auto data = resourceData(*it);
+    if (data.size() != it->size) {
+      return {};
     }
-    m_outputDevice->write(ds.device()->read(offsetSizePair.second));
+
+    images.append({entry, data});
   }
 
-  return true;
+  return images;
 }
 
-bool PeExtractor::readVersionInfo() const
+QByteArray PeExtractor::primaryIconFile() const
 {
-  if (!m_versionResource.has_value()) {
-    return false;
+  const auto images = primaryIcon();
+  if (images.isEmpty()) {
+    return {};
   }
 
-  QDataStream ds{m_inputDevice};
-  ds.setByteOrder(QDataStream::LittleEndian);
+  const auto count = static_cast<quint16>(images.size());
 
-  if (!ds.device()->seek(addressToOffset(m_sections, m_versionResource->dataAddress))) {
-    return false;
+  qsizetype total = IconDirSize + IconDirEntrySize * count;
+  for (const auto& image : images) {
+    total += static_cast<qsizetype>(image.data.size());
   }
 
-  PeVersionInfo versionInfo{};
-  ds >> versionInfo;
+  QByteArray out;
+  out.reserve(total);
 
-  QDataStream out{m_outputDevice};
+  write(out, IconDir{0, 1 /*Always 1 for ico files.*/, count});
 
-  out << QStringLiteral("%1.%2.%3.%4")
-             .arg(versionInfo.FileVersion[0])
-             .arg(versionInfo.FileVersion[1])
-             .arg(versionInfo.FileVersion[2])
-             .arg(versionInfo.FileVersion[3]);
+  quint32 dataOffset = IconDirSize + IconDirEntrySize * count;
+  for (const auto& image : images) {
+    write(out, IconDirEntry{image.entry, dataOffset});
+    dataOffset += static_cast<quint32>(image.data.size());
+  }
 
-  out << QStringLiteral("%1.%2.%3.%4")
-             .arg(versionInfo.ProductVersion[0])
-             .arg(versionInfo.ProductVersion[1])
-             .arg(versionInfo.ProductVersion[2])
-             .arg(versionInfo.ProductVersion[3]);
+  for (const auto& image : images) {
+    out.append(reinterpret_cast<const char*>(image.data.data()),
+               static_cast<qsizetype>(image.data.size()));
+  }
 
-  return true;
+  return out;
 }
 
-PeExtractor::PeExtractor(QIODevice* inputDevice, QIODevice* outputDevice)
-    : m_inputDevice(inputDevice), m_outputDevice(outputDevice)
-{}
+void PeExtractor::readVersionInfo(const PeResourceDataEntry& resource)
+{
+  const qint64 offset = addressToOffset(m_sections, resource.dataAddress);
+  if (offset < 0) {
+    return;
+  }
+
+  SpanReader reader(m_data);
+  reader.seek(offset);
+
+  PeVersionInfo versionInfo{};
+  read(reader, versionInfo);
+
+  if (!reader.ok()) {
+    return;
+  }
+
+  m_fileVersion = QStringLiteral("%1.%2.%3.%4")
+                      .arg(versionInfo.FileVersion[0])
+                      .arg(versionInfo.FileVersion[1])
+                      .arg(versionInfo.FileVersion[2])
+                      .arg(versionInfo.FileVersion[3]);
+
+  m_productVersion = QStringLiteral("%1.%2.%3.%4")
+                         .arg(versionInfo.ProductVersion[0])
+                         .arg(versionInfo.ProductVersion[1])
+                         .arg(versionInfo.ProductVersion[2])
+                         .arg(versionInfo.ProductVersion[3]);
+}
 
 bool PeExtractor::loadIconData(QIODevice* inputDevice, QIODevice* outputDevice)
 {
-  PeExtractor extractor(inputDevice, outputDevice);
+  const PeDeviceData data(inputDevice);
+  const PeExtractor extractor(data.bytes());
 
-  if (!extractor.readPeData()) {
+  if (!extractor.isValid()) {
     return false;
   }
 
-  return extractor.readIcon();
+  const QByteArray icon = extractor.primaryIconFile();
+  if (icon.isEmpty()) {
+    return false;
+  }
+
+  return outputDevice->write(icon) == icon.size();
 }
 
 bool PeExtractor::loadIconData(const QString& exeFile, QIODevice* outputDevice)
@@ -389,13 +564,17 @@ bool PeExtractor::loadIconData(const QString& exeFile, QIODevice* outputDevice)
 
 bool PeExtractor::loadVersionData(QIODevice* inputDevice, QIODevice* outputDevice)
 {
-  PeExtractor extractor(inputDevice, outputDevice);
+  const PeDeviceData data(inputDevice);
+  const PeExtractor extractor(data.bytes());
 
-  if (!extractor.readPeData()) {
+  if (!extractor.isValid() || !extractor.m_fileVersion) {
     return false;
   }
 
-  return extractor.readVersionInfo();
+  QDataStream out{outputDevice};
+  out << *extractor.m_fileVersion << *extractor.m_productVersion;
+
+  return true;
 }
 
 bool PeExtractor::loadVersionData(const QString& exeFile, QIODevice* outputDevice)
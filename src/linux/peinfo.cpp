@@ -0,0 +1,157 @@
+#include "linux/peinfo.h"
+#include "linux/peextractor.h"
+#include <QCache>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+struct CacheEntry
+{
+  qint64 size;
+  qint64 modified;
+  PeInfo info;
+};
+
+// every entry costs 1, entries only hold a few short strings and icon directory
+// entries
+constexpr qsizetype CacheMaxCost = 4096;
+
+std::mutex g_cacheMutex;
+QCache<QString, CacheEntry> g_cache(CacheMaxCost);
+
+QThreadPool& peInfoPool()
+{
+  static QThreadPool pool;
+  return pool;
+}
+
+struct Batch
+{
+  explicit Batch(const QStringList& files) : files(files), results(files.size()) {}
+
+  const QStringList files;
+  std::vector<PeInfo> results;
+  std::atomic<qsizetype> next = 0;
+  std::atomic<qsizetype> done = 0;
+
+  // parses files until none are left, called by the pool and the calling thread
+  void work()
+  {
+    for (qsizetype i = next++; i < files.size(); i = next++) {
+      results[static_cast<size_t>(i)] = PeInfo::cached(files[i]);
+
+      if (++done == files.size()) {
+        done.notify_all();
+      }
+    }
+  }
+};
+
+}  // namespace
+
+PeInfo PeInfo::read(const QString& exeFile)
+{
+  QFile file(exeFile);
+  if (!file.open(QIODeviceBase::ReadOnly)) {
+    return {};
+  }
+
+  return read(&file);
+}
+
+PeInfo PeInfo::read(QIODevice* inputDevice)
+{
+  const PeDeviceData data(inputDevice);
+  const PeExtractor extractor(data.bytes());
+
+  PeInfo info;
+
+  if (!extractor.isValid()) {
+    return info;
+  }
+
+  info.m_valid          = true;
+  info.m_fileVersion    = extractor.fileVersion().value_or(QString());
+  info.m_productVersion = extractor.productVersion().value_or(QString());
+
+  for (const auto& image : extractor.primaryIcon()) {
+    const auto offset = static_cast<quint64>(image.data.data() - data.bytes().data());
+    info.m_icons.append({image.entry, offset, static_cast<quint32>(image.data.size())});
+  }
+
+  return info;
+}
+
+PeInfo PeInfo::cached(const QString& exeFile)
+{
+  const QFileInfo fileInfo(exeFile);
+  if (!fileInfo.exists()) {
+    return {};
+  }
+
+  const QString key     = fileInfo.absoluteFilePath();
+  const qint64 size     = fileInfo.size();
+  const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+  {
+    std::scoped_lock lock(g_cacheMutex);
+
+    const auto* entry = g_cache.object(key);
+    if (entry != nullptr && entry->size == size && entry->modified == modified) {
+      return entry->info;
+    }
+  }
+
+  PeInfo info = read(key);
+
+  {
+    std::scoped_lock lock(g_cacheMutex);
+    g_cache.insert(key, new CacheEntry{size, modified, info});
+  }
+
+  return info;
+}
+
+QList<PeInfo> PeInfo::cached(const QStringList& exeFiles)
+{
+  if (exeFiles.size() <= 1) {
+    return exeFiles.isEmpty() ? QList<PeInfo>() : QList<PeInfo>{cached(exeFiles[0])};
+  }
+
+  // the pool may outlive this call if the workers start late, they find nothing to do
+  // but still need the batch
+  const auto batch = std::make_shared<Batch>(exeFiles);
+
+  // the calling thread works too, so this cannot dead lock if the pool is busy
+  const qsizetype workers =
+      std::min<qsizetype>(peInfoPool().maxThreadCount(), exeFiles.size() - 1);
+
+  for (qsizetype i = 0; i < workers; ++i) {
+    peInfoPool().start([batch] {
+      batch->work();
+    });
+  }
+
+  batch->work();
+
+  for (qsizetype done = batch->done; done < exeFiles.size(); done = batch->done) {
+    batch->done.wait(done);
+  }
+
+  return QList<PeInfo>(batch->results.begin(), batch->results.end());
+}
+
+void PeInfo::clearCache()
+{
+  std::scoped_lock lock(g_cacheMutex);
+  g_cache.clear();
+}
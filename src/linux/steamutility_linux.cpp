@@ -1,9 +1,13 @@
 #include "../steamutility.h"
 
 #include "log.h"
+#include "safewritefile.h"
 #include "utility.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
 #include <sys/mman.h>
-#include <vdf_parser.hpp>
+#include <unordered_map>
 
 using namespace Qt::StringLiterals;
 using namespace std;
@@ -30,46 +34,14 @@ QString findSteam()
 
 QString protonNameByAppID(const QString& appID)
 {
-  // proton versions can be parsed from <steamDir>/config/config.vdf
+  // proton versions are set in <steamDir>/config/config.vdf
   // InstallConfigStore -> Software -> Valve -> Steam -> CompatToolMapping
   // default version is stored as appID 0
-  try {
-    QDir steamDir(findSteamCached());
-    if (!steamDir.exists()) {
-      return {};
-    }
-
-    string configPath = steamDir.filesystemAbsolutePath() / "config/config.vdf";
-
-    log::debug("parsing {}", configPath);
-
-    ifstream config(configPath);
-    if (!config.is_open()) {
-      const int error = errno;
-      log::error("could not open steam config file {}: {}", configPath,
-                 strerror(error));
-      return {};
-    }
-    auto root     = tyti::vdf::read(config);
-    auto software = root.childs.at("Software");
-    // according to ProtonUp-Qt source code, the key can either be "Valve" or "valve"
-    auto valve = software->childs["Valve"];
-    if (valve == nullptr) {
-      // "Valve" does not exist, try "valve"
-      valve = software->childs.at("valve");
-    }
-    auto compatToolMapping = valve->childs.at("Steam")->childs.at("CompatToolMapping");
-    auto tmp               = compatToolMapping->childs[appID.toStdString()];
-    if (tmp != nullptr) {
-      return QString::fromStdString(tmp->attribs.at("name"));
-    }
-    // version is not set manually, use the version from appID 0
-    return QString::fromStdString(
-        compatToolMapping->childs.at("0")->attribs.at("name"));
-  } catch (const out_of_range& ex) {
-    log::error("Error getting proton name for appid {}, {}", appID, ex.what());
-    return {};
+  const QString name = SteamInstallationCache::instance().compatTool(appID);
+  if (name.isEmpty()) {
+    log::error("Error getting proton name for appid {}", appID);
   }
+  return name;
 }
 
 QString protonByAppID(const QString& appID)
@@ -171,6 +143,25 @@ namespace
 {
   constexpr size_t stringTableOffsetLocation = 8;
 
+  // identifies files written by AppInfoIndex::setCacheFile()
+  constexpr quint32 indexCacheMagic   = 0x4d4f4149;
+  constexpr quint32 indexCacheVersion = 1;
+
+  // size of the fields between the size of an app entry and its binary vdf document
+  size_t appEntryHeaderSize(uint8_t version)
+  {
+    // 3 * uint32_t
+    size_t offset = 12;
+    // >= 38: uint64_t + SHA-1 -> 28 byte
+    // >= 40: above + SHA-1 -> 48 byte
+    if (version >= 40) {
+      offset += 48;
+    } else if (version >= 38) {
+      offset += 28;
+    }
+    return offset;
+  }
+
   // using memory mapping improves performance significantly when `appconfig.vdf` is ~20
   // MiB
   struct MemoryMappedFile
@@ -185,6 +176,7 @@ namespace
       struct stat st;
       if (fstat(fd, &st) == -1) {
         const int e = errno;
+        close(fd);
         throw runtime_error("fstat failed: "s + strerror(e));
       }
 
@@ -235,27 +227,6 @@ namespace
                // the end of a binary VDF document.
   };
 
-  struct Unused
-  {};
-  struct BinaryVdfValue;
-  struct BinaryVdfDocument
-  {
-    string_view name;
-    unordered_map<string_view, BinaryVdfValue> values;
-  };
-
-  using BinaryVdfData = std::variant<BinaryVdfDocument, string_view, Unused>;
-
-  struct BinaryVdfValue
-  {
-    Type type;
-    string_view name;
-    BinaryVdfData data;
-
-    const BinaryVdfDocument& asDocument() const { return get<BinaryVdfDocument>(data); }
-    const string_view& asString() const { return get<string_view>(data); }
-  };
-
   class Reader
   {
   public:
@@ -264,6 +235,8 @@ namespace
     {}
 
     [[nodiscard]] size_t tell() const { return m_position; }
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] span<const uint8_t> data() const { return m_data; }
 
     void seek(const size_t offset, const int whence)
     {
@@ -322,244 +295,563 @@ namespace
     size_t length      = 0;
     const size_t start = m_position;
 
-    while (m_data[m_position++] != '\0' && m_position <= m_size) {
+    while (m_position < m_size && m_data[m_position] != '\0') {
+      ++m_position;
       ++length;
     }
 
-    if (m_position > m_size) {
+    if (m_position >= m_size) {
       throw runtime_error("Read is out of range");
     }
 
+    // terminator
+    ++m_position;
+
     return {reinterpret_cast<const char*>(m_data.data()) + start, length};
   }
 
-  class BinaryVdf : public Reader
+  Type readType(Reader& reader)
   {
-  public:
-    explicit BinaryVdf(const std::span<const uint8_t> data)
-        : Reader(data), m_strings(nullptr)
-    {}
-    void setStringTable(const std::vector<std::string_view>* stringTable)
-    {
-      m_strings = stringTable;
+    const auto type = reader.read<uint8_t>();
+    if (type > NUMTYPES) {
+      throw runtime_error("Invalid value type " + to_string(type));
     }
-    void parse()
-    {
-      const auto v    = parseValue();
-      m_document      = get<BinaryVdfDocument>(v.data);
-      m_document.name = v.name;
+    return static_cast<Type>(type);
+  }
+
+  string_view readName(Reader& reader, span<const string_view> strings)
+  {
+    if (strings.empty()) {
+      return reader.read<string_view>();
     }
 
-    [[nodiscard]] const BinaryVdfDocument& getDocument() const { return m_document; }
+    const auto index = reader.read<uint32_t>();
+    if (index >= strings.size()) {
+      throw runtime_error("Invalid string index " + to_string(index));
+    }
+    return strings[index];
+  }
 
-  private:
-    BinaryVdfDocument m_document;
-    const std::vector<std::string_view>* m_strings;
+  void skipName(Reader& reader, span<const string_view> strings)
+  {
+    if (strings.empty()) {
+      reader.read<string_view>();
+    } else {
+      reader.seek(sizeof(uint32_t), SEEK_CUR);
+    }
+  }
 
-    BinaryVdfValue parseValue()
-    {
-      BinaryVdfValue value;
+  // skips the data of anything but a nested document
+  void skipValue(Reader& reader, Type type)
+  {
+    switch (type) {
+    case STRING:
+      reader.read<string_view>();
+      break;
+
+    case PTR:
+    case INT:
+    case FLOAT:
+    case COLOR:
+      reader.seek(4, SEEK_CUR);
+      break;
+
+    case WSTRING:
+      reader.seek(reader.read<uint32_t>() * sizeof(char16_t), SEEK_CUR);
+      break;
+
+    case UINT64:
+      reader.seek(sizeof(uint64_t), SEEK_CUR);
+      break;
+
+    [[unlikely]] default:
+      throw runtime_error("Invalid value type " + to_string(type));
+    }
+  }
+
+  // skips the values of a document up to and including its end marker; documents
+  // don't store their size, but names and values can be stepped over without
+  // looking at them
+  void skipDocument(Reader& reader, span<const string_view> strings)
+  {
+    size_t depth = 1;
+
+    while (depth > 0) {
+      const Type type = readType(reader);
+
+      if (type == NUMTYPES) {
+        --depth;
+        continue;
+      }
+
+      skipName(reader, strings);
+
+      if (type == NONE) {
+        ++depth;
+      } else {
+        skipValue(reader, type);
+      }
+    }
+  }
 
-      read(reinterpret_cast<uint8_t&>(value.type));
-      if (value.type == NUMTYPES) {
-        return value;
+  // walks the values of the document at the reader's position and calls emit() for
+  // every value matching the path, returns false if emit() stopped the walk
+  template <class Emit>
+  bool walkDocument(Reader& reader, span<const string_view> strings, string_view path,
+                    bool topLevel, Emit& emit)
+  {
+    const size_t separator = path.find('/');
+    const bool last        = (separator == string_view::npos);
+    const string_view key  = path.substr(0, separator);
+    const string_view rest = last ? string_view() : path.substr(separator + 1);
+
+    while (true) {
+      if (topLevel && reader.tell() == reader.size()) {
+        return true;
       }
 
-      if (value.type > NUMTYPES) {
-        throw runtime_error("Invalid value type " + to_string(value.type));
+      const Type type = readType(reader);
+      if (type == NUMTYPES) {
+        return true;
       }
 
-      if (m_strings == nullptr) {
-        value.name = read<string_view>();
+      const string_view name = readName(reader, strings);
+      const bool matches     = (key == "*" || key == name);
+      const size_t start     = reader.tell();
+
+      if (type == NONE) {
+        if (matches && !last) {
+          if (!walkDocument(reader, strings, rest, false, emit)) {
+            return false;
+          }
+          continue;
+        }
+
+        if (matches && !emit(type, name, reader.data().subspan(start))) {
+          return false;
+        }
+
+        skipDocument(reader, strings);
       } else {
-        value.name = (*m_strings)[read<uint32_t>()];
+        skipValue(reader, type);
+
+        if (matches && last &&
+            !emit(type, name, reader.data().subspan(start, reader.tell() - start))) {
+          return false;
+        }
       }
+    }
+  }
+}  // namespace
 
-      switch (value.type) {
-      case NONE:
-        value.data = parseDocument(value.name);
-        break;
+string_view BinaryVdfView::Value::asString() const
+{
+  if (m_type != Type::String) {
+    return {};
+  }
 
-      case STRING:
-        value.data = read<string_view>();
-        break;
+  // without the terminator
+  return {reinterpret_cast<const char*>(m_data.data()), m_data.size() - 1};
+}
 
-      case PTR:
-      case INT:
-      case FLOAT:
-      case COLOR:
-        value.data = Unused();
-        seek(4, SEEK_CUR);
-        break;
+QString BinaryVdfView::Value::toString() const
+{
+  if (m_type == Type::String) {
+    const auto sv = asString();
+    return QString::fromUtf8(sv.data(), static_cast<qsizetype>(sv.size()));
+  }
 
-      case WSTRING:
-        value.data = Unused();
-        seek(read<uint32_t>() * sizeof(char16_t), SEEK_CUR);
-        break;
+  if (m_type == Type::WideString) {
+    uint32_t length = 0;
+    memcpy(&length, m_data.data(), sizeof(length));
+
+    QString s(static_cast<qsizetype>(length), Qt::Uninitialized);
+    memcpy(s.data(), m_data.data() + sizeof(length), length * sizeof(char16_t));
+
+    return s;
+  }
+
+  return {};
+}
+
+int32_t BinaryVdfView::Value::asInt() const
+{
+  int32_t value = 0;
+
+  if (m_type == Type::Int || m_type == Type::Pointer || m_type == Type::Color) {
+    memcpy(&value, m_data.data(), sizeof(value));
+  }
+
+  return value;
+}
+
+float BinaryVdfView::Value::asFloat() const
+{
+  float value = 0;
+
+  if (m_type == Type::Float) {
+    memcpy(&value, m_data.data(), sizeof(value));
+  }
+
+  return value;
+}
+
+uint64_t BinaryVdfView::Value::asUInt64() const
+{
+  uint64_t value = 0;
+
+  if (m_type == Type::UInt64) {
+    memcpy(&value, m_data.data(), sizeof(value));
+  }
+
+  return value;
+}
+
+BinaryVdfView BinaryVdfView::Value::asDocument() const
+{
+  if (m_type != Type::Document) {
+    return {};
+  }
+
+  return BinaryVdfView(m_data, m_strings);
+}
+
+optional<BinaryVdfView::Value> BinaryVdfView::find(string_view path) const
+{
+  optional<Value> result;
+
+  forEach(path, [&](const Value& value) {
+    result = value;
+    return false;
+  });
+
+  return result;
+}
+
+vector<BinaryVdfView::Value> BinaryVdfView::query(string_view path) const
+{
+  vector<Value> result;
 
-      case UINT64:
-        value.data = Unused();
-        seek(sizeof(uint64_t), SEEK_CUR);
+  forEach(path, [&](const Value& value) {
+    result.push_back(value);
+  });
+
+  return result;
+}
+
+void BinaryVdfView::visit(string_view path, Visitor visitor, void* context) const
+{
+  auto emit = [&](auto type, string_view name, span<const uint8_t> data) {
+    return visitor(context, Value(static_cast<BinaryVdfView::Type>(type), name, data,
+                                  m_strings));
+  };
+
+  Reader reader(m_data);
+  walkDocument(reader, m_strings, path, true, emit);
+}
+
+struct AppInfoIndex::Data
+{
+  struct Location
+  {
+    size_t offset;
+    size_t size;
+  };
+
+  Data(const QString& path, qint64 modified)
+      : file(path.toStdString().c_str()), modified(modified)
+  {}
+
+  MemoryMappedFile file;
+  qint64 modified;
+  uint8_t version           = 0;
+  int64_t stringTableOffset = 0;
+  unordered_map<uint32_t, Location> entries;
+
+  mutable once_flag stringsRead;
+  mutable vector<string_view> strings;
+
+  // reads the header and finds all app entries
+  void scan()
+  {
+    Reader reader({file.addr, file.length});
+    readHeader(reader);
+
+    const size_t headerSize = appEntryHeaderSize(version);
+
+    while (true) {
+      const auto appID = reader.read<uint32_t>();
+      if (appID == 0) {
         break;
+      }
 
-      [[unlikely]] default:
-        throw runtime_error("Invalid value type " + to_string(value.type));
+      const auto size = reader.read<uint32_t>();
+      if (size < headerSize) {
+        throw runtime_error("Invalid size " + to_string(size) + " for app " +
+                            to_string(appID));
       }
 
-      return value;
+      entries.emplace(appID, Location{reader.tell() + headerSize, size - headerSize});
+      reader.seek(size, SEEK_CUR);
     }
 
-    BinaryVdfDocument parseDocument(std::string_view name)
-    {
-      BinaryVdfDocument document;
-      document.name = name;
-      document.values.reserve(10);
-      while (true) {
-        auto result = parseValue();
-        if (result.type == NUMTYPES) {
-          break;
-        }
-        document.values.emplace(result.name, std::move(result));
-      }
-      return document;
-    }
-  };
+    entries.rehash(0);
+  }
 
-  QString getInstalledBranch(const QString& gameLocation, const QString& appID)
+  void readHeader(Reader& reader)
   {
-    // read appmanifest
-    QFile manifest(gameLocation % "/../../appmanifest_"_L1 % appID % ".acf"_L1);
-    if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
-      throw runtime_error("Error opening app manifest, "s +
-                          manifest.errorString().toStdString());
+    version = reader.read<uint8_t>();
+
+    if (version < 36 || version > 41) {
+      throw runtime_error("Invalid or unsupported appinfo version: " +
+                          to_string(version));
     }
 
-    const QByteArray data = manifest.readAll();
+    // magic and universe
+    size_t start = 8;
 
-    /*
-    example data:
-    \t"UserConfig"
-    \t{
-    \t\t"language"\t\t"english"
-    \t\t"BetaKey"\t\t"7.60"
+    if (version >= 41) {
+      // file uses a string table
+      reader.seek(stringTableOffsetLocation, SEEK_SET);
+      stringTableOffset = reader.read<int64_t>();
+      start += 8;
     }
 
-    "BetaKey" corresponds to "branch" in binary vdf
-     */
-    static const QRegularExpression regex(
-        uR"-(\t"UserConfig"\n\t\{\n.*\n\t+"BetaKey"\t+"(.*)"\n\t\})-"_s);
-    const QRegularExpressionMatch result = regex.match(data);
+    reader.seek(start, SEEK_SET);
+  }
 
-    if (!result.hasMatch()) {
-      // no match, therefore, the default branch is installed
+  span<const string_view> stringTable() const
+  {
+    if (stringTableOffset == 0) {
       return {};
     }
-    return result.captured(1);
-  }
-}  // namespace
 
-QString getRequiredLinuxRuntime(const QString& gameLocation,
-                                const QString& appID) noexcept(false)
-{
-  string appInfoPath = findSteamCached().toStdString() + "/appcache/appinfo.vdf";
-  const MemoryMappedFile file(appInfoPath.c_str());
+    call_once(stringsRead, [this] {
+      Reader reader({file.addr, file.length});
+      reader.seek(stringTableOffset, SEEK_SET);
 
-  Reader reader({file.addr, file.length});
+      const auto length = reader.read<uint32_t>();
 
-  // check version
-  const auto version = reader.read<uint8_t>();
+      strings.reserve(length);
+      for (uint32_t i = 0; i < length; ++i) {
+        strings.push_back(reader.read<string_view>());
+      }
+    });
 
-  if (version < 36 || version > 41) {
-    throw runtime_error("Invalid or unsupported appinfo version: " +
-                        to_string(version));
+    return strings;
   }
 
-  const bool hasStringTable = version >= 41;
+  bool load(const QString& cacheFile)
+  {
+    QFile in(cacheFile);
+    if (!in.open(QIODevice::ReadOnly)) {
+      return false;
+    }
 
-  vector<string_view> strings;
-  if (hasStringTable) {
-    // file uses a string table
-    reader.seek(stringTableOffsetLocation, SEEK_SET);
-    const auto offset = reader.read<int64_t>();
+    QDataStream stream(&in);
 
-    reader.seek(offset, SEEK_SET);
+    quint32 magic = 0, format = 0, count = 0;
+    qint64 cachedSize = 0, cachedModified = 0, cachedStringTable = 0;
+    quint8 cachedVersion = 0;
 
-    const auto length = reader.read<uint32_t>();
+    stream >> magic >> format >> cachedSize >> cachedModified >> cachedVersion >>
+        cachedStringTable >> count;
 
-    strings.reserve(length);
-    for (uint32_t i = 0; i < length; ++i) {
-      strings.push_back(reader.read<string_view>());
+    if (stream.status() != QDataStream::Ok || magic != indexCacheMagic ||
+        format != indexCacheVersion || cachedSize != qint64(file.length) ||
+        cachedModified != modified) {
+      return false;
     }
-    reader.seek(stringTableOffsetLocation + 8, SEEK_SET);
-  }
 
-  const uint32_t appIDint = appID.toInt();
-  while (true) {
-    const auto entryAppID = reader.read<uint32_t>();
-    if (entryAppID == 0) {
-      break;
+    Reader reader({file.addr, file.length});
+    readHeader(reader);
+
+    if (cachedVersion != version || cachedStringTable != stringTableOffset) {
+      return false;
     }
 
-    const auto size = reader.read<uint32_t>();
-    if (appIDint != entryAppID) {
-      // seek to next entry
-      reader.seek(size, SEEK_CUR);
-    } else {
-      // 3 * uint32_t
-      size_t offset = 12;
-      // calculate offset of binary vdf section based on version
-      // >= 38: uint64_t + SHA-1 -> 28 byte
-      // >= 40: above + SHA-1 -> 48 byte
-      if (version >= 40) {
-        offset += 48;
-      } else if (version >= 38) {
-        offset += 28;
+    entries.reserve(count);
+
+    for (quint32 i = 0; i < count; ++i) {
+      quint32 appID = 0;
+      quint64 offset = 0, size = 0;
+      stream >> appID >> offset >> size;
+
+      if (offset > file.length || size > file.length - offset) {
+        entries.clear();
+        return false;
       }
 
-      reader.seek(offset, SEEK_CUR);
-      BinaryVdf vdf({file.addr + reader.tell(), size});
-      if (hasStringTable) {
-        vdf.setStringTable(&strings);
+      entries.emplace(appID, Location{offset, size});
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+      entries.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  void save(const QString& cacheFile) const
+  {
+    try {
+      SafeWriteFile out(cacheFile);
+      QDataStream stream(out.operator->());
+
+      stream << indexCacheMagic << indexCacheVersion << qint64(file.length)
+             << modified << quint8(version) << qint64(stringTableOffset)
+             << quint32(entries.size());
+
+      for (const auto& [appID, location] : entries) {
+        stream << quint32(appID) << quint64(location.offset)
+               << quint64(location.size);
       }
-      vdf.parse();
 
-      const auto& document = vdf.getDocument();
-      if (!document.values.contains("config")) {
-        throw runtime_error("VDF does not contain a config segment");
+      if (stream.status() != QDataStream::Ok || !out->commit()) {
+        log::warn("failed to write appinfo index to {}", cacheFile);
       }
-      const auto& config = document.values.at("config").asDocument();
-      try {
-        auto& mappings      = config.values.at("app_mappings").asDocument();
-        const string branch = getInstalledBranch(gameLocation, appID).toStdString();
-        for (const auto& value : mappings.values | views::values) {
-          auto& mapping = value.asDocument();
-          // skip entry if platform != linux
-          if (mapping.values.at("platform").asString() != "linux") {
-            continue;
-          }
+    } catch (const Exception& e) {
+      log::warn("failed to write appinfo index: {}", e.what());
+    }
+  }
+};
 
-          if (branch.empty() && !mapping.values.contains("branch")) {
-            const auto sv = mapping.values.at("tool").asString();
-            return QString::fromUtf8(sv.data(), static_cast<qsizetype>(sv.length()));
-          }
+AppInfoIndex::Entry::Entry() : m_appID(0) {}
 
-          if (!branch.empty() && mapping.values.contains("branch")) {
-            if (mapping.values.at("branch").asString() == branch) {
-              const auto sv = mapping.values.at("tool").asString();
-              return QString::fromUtf8(sv.data(), static_cast<qsizetype>(sv.length()));
-            }
-          }
-        }
+span<const string_view> AppInfoIndex::Entry::strings() const
+{
+  if (!m_data) {
+    return {};
+  }
 
-        return {};
-      } catch (const out_of_range&) {
-        // no app_mappings, so no runtime should be used
-        return {};
-      }
+  return m_data->stringTable();
+}
+
+BinaryVdfView AppInfoIndex::Entry::vdf() const
+{
+  const auto root = BinaryVdfView(m_document, strings()).find("*");
+  if (!root || root->type() != BinaryVdfView::Type::Document) {
+    throw runtime_error("Invalid appinfo document for app " + to_string(m_appID));
+  }
+
+  return root->asDocument();
+}
+
+AppInfoIndex::AppInfoIndex(QString path) : m_path(std::move(path)) {}
+
+AppInfoIndex::~AppInfoIndex() = default;
+
+AppInfoIndex& AppInfoIndex::instance()
+{
+  static AppInfoIndex index(findSteamCached() % "/appcache/appinfo.vdf"_L1);
+  return index;
+}
+
+void AppInfoIndex::setCacheFile(const QString& path)
+{
+  scoped_lock lock(m_mutex);
+  m_cacheFile = path;
+}
+
+AppInfoIndex::Entry AppInfoIndex::find(uint32_t appID) noexcept(false)
+{
+  const auto data = current();
+
+  const auto itor = data->entries.find(appID);
+  if (itor == data->entries.end()) {
+    return {};
+  }
+
+  Entry entry;
+  entry.m_data     = data;
+  entry.m_appID    = appID;
+  entry.m_document = {data->file.addr + itor->second.offset, itor->second.size};
+
+  return entry;
+}
+
+shared_ptr<const AppInfoIndex::Data> AppInfoIndex::current()
+{
+  scoped_lock lock(m_mutex);
+
+  const QFileInfo info(m_path);
+  const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+  if (m_data && qint64(m_data->file.length) == info.size() &&
+      m_data->modified == modified) {
+    return m_data;
+  }
+
+  auto data = make_shared<Data>(m_path, modified);
+
+  if (!m_cacheFile.isEmpty() && data->load(m_cacheFile)) {
+    log::debug("loaded appinfo index for {} apps from {}", data->entries.size(),
+               m_cacheFile);
+  } else {
+    data->scan();
+    log::debug("indexed {} apps in {}", data->entries.size(), m_path);
+
+    if (!m_cacheFile.isEmpty()) {
+      data->save(m_cacheFile);
     }
   }
 
-  throw runtime_error("Error determining runtime");
+  m_data = std::move(data);
+  return m_data;
+}
+
+QString getRequiredLinuxRuntime(const QString& gameLocation,
+                                const QString& appID) noexcept(false)
+{
+  const auto entry = AppInfoIndex::instance().find(appID.toUInt());
+  if (!entry) {
+    throw runtime_error("Error determining runtime");
+  }
+
+  const auto config = entry.vdf().find("config");
+  if (!config) {
+    throw runtime_error("VDF does not contain a config segment");
+  }
+
+  const auto mappings = config->asDocument().find("app_mappings");
+  if (!mappings) {
+    // no app_mappings, so no runtime should be used
+    return {};
+  }
+
+  // "BetaKey" in the app manifest corresponds to "branch" in binary vdf
+  const auto app = SteamInstallationCache::appManifest(gameLocation, appID);
+  if (!app) {
+    throw runtime_error("Error reading app manifest for " + appID.toStdString() +
+                        " in " + gameLocation.toStdString());
+  }
+  const string branch = app->branch.toStdString();
+
+  QString tool;
+  mappings->asDocument().forEach("*", [&](const BinaryVdfView::Value& value) {
+    const BinaryVdfView mapping = value.asDocument();
+
+    // skip entry if platform != linux
+    const auto platform = mapping.find("platform");
+    if (!platform || platform->asString() != "linux") {
+      return true;
+    }
+
+    // the default branch has no branch entry
+    const auto mappingBranch = mapping.find("branch");
+    if (branch.empty() ? mappingBranch.has_value()
+                       : (!mappingBranch || mappingBranch->asString() != branch)) {
+      return true;
+    }
+
+    if (const auto t = mapping.find("tool")) {
+      tool = t->toString();
+    }
+    return false;
+  });
+
+  return tool;
 }
 
 }  // namespace MOBase
@@ -3,11 +3,28 @@
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QGuiApplication>
+#include <chrono>
 
 using namespace Qt::StringLiterals;
 
 namespace MOBase
 {
+
+namespace
+{
+  // times per second the progress is sent at most
+  constexpr int PublishRate = 10;
+
+  // tasks that do not report progress for this long are dropped, in milliseconds
+  constexpr qint64 StaleProgress = 15000;
+
+  qint64 steadyMilliseconds()
+  {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+}  // namespace
+
 TaskProgressManager& TaskProgressManager::instance()
 {
   static TaskProgressManager s_Instance;
@@ -16,37 +33,88 @@ TaskProgressManager& TaskProgressManager::instance()
 
 void TaskProgressManager::forgetMe(quint32 id)
 {
-  if (!m_successful) {
+  QMutexLocker lock(&m_Mutex);
+  if (!m_successful || id == 0) {
     return;
   }
-  auto iter = m_Percentages.find(id);
-  if (iter != m_Percentages.end()) {
-    m_Percentages.erase(iter);
+
+  if (Slot* slot = findSlot(id)) {
+    quint32 expected = id;
+    if (slot->id.compare_exchange_strong(expected, 0)) {
+      schedulePublish();
+    }
   }
-  showProgress();
 }
 
 void TaskProgressManager::updateProgress(quint32 id, qint64 value, qint64 max)
 {
-  QMutexLocker lock(&m_Mutex);
-  if (!m_successful) {
+  // called for every block read or written by a task, so this only updates the
+  // task's slot, the progress is published by the timer
+  if (!m_successful || id == 0) {
     return;
   }
-  if (value == max) {
-    auto iter = m_Percentages.find(id);
-    if (iter != m_Percentages.end()) {
-      m_Percentages.erase(iter);
+
+  Slot* slot = findSlot(id);
+
+  if (max <= 0 || value >= max) {
+    quint32 expected = id;
+    if (slot != nullptr && slot->id.compare_exchange_strong(expected, 0)) {
+      schedulePublish();
+    }
+    return;
+  }
+
+  const qint64 now   = steadyMilliseconds();
+  const bool claimed = (slot == nullptr);
+
+  if (claimed) {
+    slot = claimSlot(id);
+    if (slot == nullptr) {
+      return;
     }
-  } else {
-    m_Percentages[id] = std::make_pair(QTime::currentTime(), (value * 100) / max);
   }
 
-  showProgress();
+  const int percent = static_cast<int>((value * 100) / max);
+  slot->updated.store(now);
+
+  if (slot->percent.exchange(percent) != percent || claimed) {
+    schedulePublish();
+  }
+}
+
+TaskProgressManager::Slot* TaskProgressManager::findSlot(quint32 id)
+{
+  for (auto& slot : m_Slots) {
+    if (slot.id.load() == id) {
+      return &slot;
+    }
+  }
+
+  return nullptr;
+}
+
+TaskProgressManager::Slot* TaskProgressManager::claimSlot(quint32 id)
+{
+  // stale slots are freed by showProgress(), so only free slots are taken here
+  for (auto& slot : m_Slots) {
+    quint32 expected = 0;
+    if (slot.id.load() == 0 && slot.id.compare_exchange_strong(expected, id)) {
+      return &slot;
+    }
+  }
+
+  return nullptr;
 }
 
 quint32 TaskProgressManager::getId()
 {
   QMutexLocker lock(&m_Mutex);
+
+  // 0 marks free slots
+  if (m_NextId == 0) {
+    ++m_NextId;
+  }
+
   return m_NextId++;
 }
 
@@ -65,36 +133,71 @@ bool TaskProgressManager::tryCreateTaskbar()
   return QDBusConnection::sessionBus().send(message);
 }
 
+void TaskProgressManager::schedulePublish()
+{
+  // only the first update since the last publish starts the timer
+  if (!m_Dirty.exchange(true)) {
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+          if (!m_PublishTimer.isActive()) {
+            m_PublishTimer.start();
+          }
+        },
+        Qt::QueuedConnection);
+  }
+}
+
 void TaskProgressManager::showProgress()
 {
+  QMutexLocker lock(&m_Mutex);
+  m_Dirty = false;
+
+  const qint64 now         = steadyMilliseconds();
+  unsigned long long total = 0;
+  unsigned long long count = 0;
+
+  for (auto& slot : m_Slots) {
+    quint32 id = slot.id.load();
+    if (id == 0) {
+      continue;
+    }
+
+    const qint64 idle = now - slot.updated.load();
+    if (idle >= StaleProgress) {
+      // if there was no progress in 15 seconds remove this progress
+      log::debug("no progress in 15 seconds ({})", idle / 1000);
+      slot.id.compare_exchange_strong(id, 0);
+      continue;
+    }
+
+    total += static_cast<unsigned long long>(slot.percent.load());
+    ++count;
+  }
+
+  if (count > 0) {
+    // keep checking for tasks that stop reporting
+    m_PublishTimer.start();
+  }
+
+  const Published published{count > 0, count,
+                            count > 0 ? static_cast<int>(total / count) : 0};
+  if (published == m_Published) {
+    return;
+  }
+
   auto message = QDBusMessage::createSignal(
       QStringLiteral("/org/ModOrganizer2/ModOrganizer"),
       QStringLiteral("com.canonical.Unity.LauncherEntry"), QStringLiteral("Update"));
 
   QVariantMap properties;
-  if (!m_Percentages.empty()) {
+  if (published.visible) {
     properties.insert(QStringLiteral("progress-visible"), true);  // enable the progress
     properties.insert(QStringLiteral("count-visible"), true);
 
-    QTime now                = QTime::currentTime();
-    unsigned long long total = 0;
-    unsigned long long count = 0;
-
-    for (auto iter = m_Percentages.begin(); iter != m_Percentages.end();) {
-      if (iter->second.first.secsTo(now) < 15) {
-        total += static_cast<unsigned long long>(iter->second.second);
-        ++iter;
-        ++count;
-      } else {
-        // if there was no progress in 15 seconds remove this progress
-        log::debug("no progress in 15 seconds ({})", iter->second.first.secsTo(now));
-        iter = m_Percentages.erase(iter);
-      }
-    }
-    properties.insert(QStringLiteral("progress"),
-                      total /
-                          (count * 100.0));  // set the progress value (from 0.0 to 1.0)
-    properties.insert(QStringLiteral("count"), count);
+    // set the progress value (from 0.0 to 1.0)
+    properties.insert(QStringLiteral("progress"), published.percent / 100.0);
+    properties.insert(QStringLiteral("count"), published.count);
   } else {
     properties.insert(QStringLiteral("progress-visible"), false);
     properties.insert(QStringLiteral("count-visible"), false);
@@ -106,11 +209,24 @@ void TaskProgressManager::showProgress()
   bool result = QDBusConnection::sessionBus().send(message);
   if (!result) {
     log::warn("failed to set progress");
+    return;
   }
+
+  m_Published = published;
 }
 
-TaskProgressManager::TaskProgressManager() : m_NextId(1)
+TaskProgressManager::TaskProgressManager()
+    : m_Dirty(false), m_PublishTimer(this), m_Published{false, 0, 0}, m_NextId(1)
 {
+  // the instance may be created by a worker thread, the timer needs an event loop
+  if (auto* app = QCoreApplication::instance()) {
+    moveToThread(app->thread());
+  }
+
+  m_PublishTimer.setSingleShot(true);
+  m_PublishTimer.setInterval(1000 / PublishRate);
+  connect(&m_PublishTimer, &QTimer::timeout, this, &TaskProgressManager::showProgress);
+
   if (QGuiApplication::desktopFileName().isEmpty()) {
     log::warn("MO2 has no desktop file name, task bar progress not available");
     m_successful = false;
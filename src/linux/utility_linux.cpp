@@ -1,13 +1,15 @@
 #include "utility.h"
 
 #include "linux/icoutils.h"
-#include "linux/peextractor.h"
+#include "linux/peinfo.h"
 #include "log.h"
 #include <QBuffer>
 #include <QByteArray>
+#include <QCache>
+#include <QCryptographicHash>
 #include <QDBusInterface>
 #include <QDBusMessage>
-#include <QDataStream>
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QFile>
 #include <QIODevice>
@@ -15,8 +17,10 @@
 #include <QMessageBox>
 #include <QPixmap>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QString>
 #include <QWidget>
+#include <mutex>
 
 using namespace std;
 using namespace Qt::Literals::StringLiterals;
@@ -25,39 +29,98 @@ namespace fs = std::filesystem;
 namespace
 {
 
-enum version_t : uint8_t
+// decoded icons of executables, keyed by path, size and modification time
+struct ExecutableIconCache
 {
-  fileVersion,
-  productVersion
+  // the cost is the size of the image, a 256x256 icon is 256 KB
+  static constexpr qsizetype MaxCost = 16 * 1024 * 1024;
+
+  std::mutex mutex;
+  QCache<QString, QImage> images{MaxCost};
+  QString directory;
 };
 
-QString getFileVersionInfo(QString const& filepath, version_t type)
+ExecutableIconCache& executableIconCache()
 {
-  QFile exeFile(filepath);
-  QBuffer buffer;
+  static ExecutableIconCache cache;
+  return cache;
+}
 
-  if (!exeFile.open(QIODeviceBase::ReadOnly) ||
-      !buffer.open(QIODeviceBase::ReadWrite)) {
-    return {};
+QString executableIconKey(const QFileInfo& info)
+{
+  return info.absoluteFilePath() % u'|' % QString::number(info.size()) % u'|' %
+         QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+QString executableIconFile(const QString& directory, const QString& key)
+{
+  const QByteArray hash =
+      QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return directory % u'/' % QString::fromLatin1(hash) % ".png"_L1;
+}
+
+QImage decodeExecutableIcon(const QString& filepath)
+{
+  // the icon directory is read together with the versions, only the chosen image is
+  // read here
+  const PeInfo info = PeInfo::cached(filepath);
+
+  QFile file(filepath);
+  QImage image;
+
+  if (info.isValid() && file.open(QIODevice::ReadOnly)) {
+    IcoUtils::loadIcoImageFromExe(&file, info, image);
   }
 
-  if (!PeExtractor::loadVersionData(&exeFile, &buffer)) {
+  return image;
+}
+
+// the icon from the memory cache, the disk cache or the executable, in that order
+QImage executableIcon(const QString& filepath)
+{
+  const QFileInfo fileInfo(filepath);
+  if (!fileInfo.exists()) {
     return {};
   }
 
-  QString fileVersionStr, productVersionStr;
+  auto& cache       = executableIconCache();
+  const QString key = executableIconKey(fileInfo);
+  QString directory;
 
-  buffer.seek(0);
-  QDataStream stream(&buffer);
-  stream >> fileVersionStr >> productVersionStr;
+  {
+    std::scoped_lock lock(cache.mutex);
+    if (const QImage* image = cache.images.object(key)) {
+      return *image;
+    }
+    directory = cache.directory;
+  }
 
-  switch (type) {
-  case fileVersion:
-    return fileVersionStr;
-  case productVersion:
-    return productVersionStr;
+  QImage image;
+  const QString cacheFile =
+      directory.isEmpty() ? QString() : executableIconFile(directory, key);
+
+  if (!cacheFile.isEmpty()) {
+    image.load(cacheFile, "PNG");
   }
-  return {};
+
+  if (image.isNull()) {
+    image = decodeExecutableIcon(filepath);
+
+    if (!image.isNull() && !cacheFile.isEmpty()) {
+      QSaveFile out(cacheFile);
+      if (!out.open(QIODevice::WriteOnly) || !image.save(&out, "PNG") ||
+          !out.commit()) {
+        MOBase::log::debug("failed to cache icon of '{}' in '{}'", filepath, cacheFile);
+      }
+    }
+  }
+
+  if (!image.isNull()) {
+    std::scoped_lock lock(cache.mutex);
+    cache.images.insert(key, new QImage(image), image.sizeInBytes());
+  }
+
+  return image;
 }
 
 }  // namespace
@@ -523,21 +586,44 @@ QIcon iconForExecutable(const QString& filepath)
                             QIcon(QStringLiteral(":/MO/gui/executable")));
   }
 
-  QImage img;
-  if (IcoUtils::loadIcoImageFromExe(filepath, img)) {
+  const QImage img = iconImageForExecutable(filepath);
+  if (!img.isNull()) {
     return {QPixmap::fromImage(img)};
   }
+
   return QIcon(QStringLiteral(":/MO/gui/executable"));
 }
 
+QImage iconImageForExecutable(const QString& filePath)
+{
+  if (filePath.endsWith(".desktop"_L1)) {
+    // theme icons are not images
+    return {};
+  }
+
+  return executableIcon(filePath);
+}
+
+void setExecutableIconCacheDirectory(const QString& path)
+{
+  if (!path.isEmpty() && !QDir().mkpath(path)) {
+    log::warn("cannot create icon cache directory '{}'", path);
+    return;
+  }
+
+  auto& cache = executableIconCache();
+  std::scoped_lock lock(cache.mutex);
+  cache.directory = path;
+}
+
 QString getFileVersion(QString const& filepath)
 {
-  return getFileVersionInfo(filepath, fileVersion);
+  return PeInfo::cached(filepath).fileVersion();
 }
 
 QString getProductVersion(QString const& filepath)
 {
-  return getFileVersionInfo(filepath, productVersion);
+  return PeInfo::cached(filepath).productVersion();
 }
 
 std::string formatSystemMessage(int id)
@@ -19,10 +19,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "questionboxmemory.h"
+#include "delayedfilewriter.h"
 #include "log.h"
 #include "ui_questionboxmemory.h"
 
 #include <QApplication>
+#include <QHash>
 #include <QIcon>
 #include <QMutex>
 #include <QMutexLocker>
@@ -30,14 +32,146 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <QSettings>
 #include <QStyle>
 
+#include <memory>
+
 namespace MOBase
 {
 
+using Button = QuestionBoxMemory::Button;
+
+// window name and file name, the file name is empty for choices of a window
+using MemoryKey = std::pair<QString, QString>;
+
+struct PendingChoice
+{
+  QString windowName;
+  QString fileName;
+  Button button;
+};
+
+// held by queries while their dialog is shown
 static QMutex g_mutex;
+
+// guards everything below, never held while a dialog is shown
+static QMutex g_memoryMutex;
 static QuestionBoxMemory::GetButton g_get;
 static QuestionBoxMemory::SetWindowButton g_setWindow;
 static QuestionBoxMemory::SetFileButton g_setFile;
 
+// choices of the storage file, if any
+static QString g_storageFile;
+static QHash<MemoryKey, Button> g_choices;
+
+// whether g_choices changed since the storage file was written
+static bool g_unwritten = false;
+
+// choices that haven't been given to the set callbacks yet
+static std::vector<PendingChoice> g_pending;
+
+// g_memoryMutex must be held
+static void writeMemoryLocked()
+{
+  if (!g_storageFile.isEmpty()) {
+    if (!g_unwritten) {
+      return;
+    }
+
+    g_unwritten = false;
+    QSettings settings(g_storageFile, QSettings::IniFormat);
+
+    settings.remove("choices");
+    settings.beginWriteArray("choices", static_cast<int>(g_choices.size()));
+
+    int i = 0;
+    for (auto itor = g_choices.cbegin(); itor != g_choices.cend(); ++itor) {
+      settings.setArrayIndex(i++);
+      settings.setValue("window", itor.key().first);
+      settings.setValue("file", itor.key().second);
+      settings.setValue("button", static_cast<int>(itor.value()));
+    }
+
+    settings.endArray();
+    settings.sync();
+
+    if (settings.status() != QSettings::NoError) {
+      log::error("failed to write dialog choices to '{}'", g_storageFile);
+    }
+
+    return;
+  }
+
+  for (const auto& choice : g_pending) {
+    if (choice.fileName.isEmpty()) {
+      if (g_setWindow) {
+        g_setWindow(choice.windowName, choice.button);
+      }
+    } else if (g_setFile) {
+      g_setFile(choice.windowName, choice.fileName, choice.button);
+    }
+  }
+
+  g_pending.clear();
+}
+
+static void writeMemory()
+{
+  QMutexLocker locker(&g_memoryMutex);
+  writeMemoryLocked();
+}
+
+// choices can be remembered from any thread, but the timer of the writer can only
+// be started and stopped on the thread it lives on; it is moved to the thread of the
+// application and the calls are queued to it
+//
+static DelayedFileWriter& memoryWriter()
+{
+  static const auto writer = [] {
+    auto w = std::make_unique<DelayedFileWriter>(&writeMemory);
+
+    if (auto* app = QCoreApplication::instance()) {
+      w->moveToThread(app->thread());
+
+      QObject::connect(app, &QCoreApplication::aboutToQuit, w.get(), [] {
+        memoryWriter().writeImmediately(true);
+      });
+    }
+
+    return w;
+  }();
+
+  return *writer;
+}
+
+// writes the choices now instead of waiting for the writer, g_memoryMutex must be
+// held
+static void flushMemoryLocked()
+{
+  QMetaObject::invokeMethod(&memoryWriter(), &DelayedFileWriterBase::cancel,
+                            Qt::QueuedConnection);
+
+  writeMemoryLocked();
+}
+
+static void remember(const QString& windowName, const QString& fileName, Button b)
+{
+  QMutexLocker locker(&g_memoryMutex);
+
+  if (!g_storageFile.isEmpty()) {
+    if (b == QuestionBoxMemory::NoButton) {
+      g_choices.remove({windowName, fileName});
+    } else {
+      g_choices.insert({windowName, fileName}, b);
+    }
+
+    g_unwritten = true;
+  } else {
+    g_pending.push_back({windowName, fileName, b});
+  }
+
+  QMetaObject::invokeMethod(&memoryWriter(), &DelayedFileWriterBase::write,
+                            Qt::QueuedConnection);
+}
+
 QuestionBoxMemory::QuestionBoxMemory(QWidget* parent, const QString& title,
                                      const QString& text, QString const* filename,
                                      const QDialogButtonBox::StandardButtons buttons,
@@ -77,13 +211,51 @@ QuestionBoxMemory::~QuestionBoxMemory() = default;
 void QuestionBoxMemory::setCallbacks(GetButton get, SetWindowButton setWindow,
                                      SetFileButton setFile)
 {
-  QMutexLocker locker(&g_mutex);
+  QMutexLocker locker(&g_memoryMutex);
+
+  // the pending choices are for the previous callbacks
+  flushMemoryLocked();
 
   g_get       = get;
   g_setWindow = setWindow;
   g_setFile   = setFile;
 }
 
+void QuestionBoxMemory::setStorageFile(const QString& fileName)
+{
+  QMutexLocker locker(&g_memoryMutex);
+  flushMemoryLocked();
+
+  g_storageFile = fileName;
+  g_choices.clear();
+
+  if (fileName.isEmpty()) {
+    return;
+  }
+
+  QSettings settings(fileName, QSettings::IniFormat);
+  const int count = settings.beginReadArray("choices");
+
+  for (int i = 0; i < count; ++i) {
+    settings.setArrayIndex(i);
+
+    const auto windowName = settings.value("window").toString();
+    const auto b = static_cast<Button>(settings.value("button").toInt());
+
+    if (!windowName.isEmpty() && b != NoButton) {
+      g_choices.insert({windowName, settings.value("file").toString()}, b);
+    }
+  }
+
+  settings.endArray();
+}
+
+void QuestionBoxMemory::flushMemory()
+{
+  QMutexLocker locker(&g_memoryMutex);
+  flushMemoryLocked();
+}
+
 void QuestionBoxMemory::buttonClicked(QAbstractButton* button)
 {
   m_Button = ui->buttonBox->standardButton(button);
@@ -136,6 +308,10 @@ QuestionBoxMemory::queryImpl(QWidget* parent, const QString& windowName,
     if (fileName != nullptr && dialog.ui->rememberForCheckBox->isChecked()) {
       setFileMemory(windowName, *fileName, dialog.m_Button);
     }
+
+    // choices made in a dialog are rare, they're written right away so they
+    // survive a crash
+    flushMemory();
   }
 
   return dialog.m_Button;
@@ -145,7 +321,7 @@ void QuestionBoxMemory::setWindowMemory(const QString& windowName, Button b)
 {
   log::debug("remembering choice {} for window {}", buttonToString(b), windowName);
 
-  g_setWindow(windowName, b);
+  remember(windowName, QString(), b);
 }
 
 void QuestionBoxMemory::setFileMemory(const QString& windowName,
@@ -154,12 +330,36 @@ void QuestionBoxMemory::setFileMemory(const QString& windowName,
   log::debug("remembering choice {} for file {}", buttonToString(b),
              windowName + "/" + filename);
 
-  g_setFile(windowName, filename, b);
+  remember(windowName, filename, b);
 }
 
 QuestionBoxMemory::Button QuestionBoxMemory::getMemory(const QString& windowName,
                                                        const QString& filename)
 {
+  QMutexLocker locker(&g_memoryMutex);
+
+  if (!g_storageFile.isEmpty()) {
+    // the choice for the file takes precedence over the one for the window
+    if (!filename.isEmpty()) {
+      const auto itor = g_choices.constFind({windowName, filename});
+      if (itor != g_choices.cend()) {
+        return *itor;
+      }
+    }
+
+    return g_choices.value({windowName, QString()}, NoButton);
+  }
+
+  if (!g_get) {
+    return NoButton;
+  }
+
+  // the callback doesn't know about the choices that haven't been written yet,
+  // its answers are not cached because the settings behind it can change
+  if (!g_pending.empty()) {
+    flushMemoryLocked();
+  }
+
   return g_get(windowName, filename);
 }
 
@@ -19,8 +19,10 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "log.h"
 #include "qinipp.h"
 #include "report.h"
+#include "safewritefile.h"
 #include <QApplication>
 #include <QFile>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QString>
 #include <fstream>
@@ -34,40 +36,55 @@ namespace
 // helper function that mirrors the behaviour of WritePrivateProfileString as described
 // in
 // https://learn.microsoft.com/en-us/windows/win32/api/winbase/nf-winbase-writeprivateprofilestringw
+//
+// only the affected lines are changed, comments and formatting are kept
 bool SetValue(const QString& appName, const QString& keyName, const QString& value,
               const QString& fileName)
 {
-  qinipp::Ini ini;
+  QByteArray data;
 
   // read ini file if it exists
   if (QFile::exists(fileName)) {
     QFile in(fileName);
-    if (!in.open(QIODeviceBase::ReadOnly | QIODeviceBase::Text)) {
+    if (!in.open(QIODeviceBase::ReadOnly)) {
       return false;
     }
-    QTextStream inStream(&in);
-    ini.parse(inStream);
+    data = in.readAll();
     in.close();
   }
 
+  qinipp::Editor ini(data);
+
   if (keyName.isNull()) {
     // remove section if key is null
-    ini.sections.erase(appName);
+    ini.remove_section(appName.toUtf8());
   } else if (value.isNull()) {
     // remove key if value is null
-    ini.sections[appName].erase(keyName);
+    ini.remove(appName.toUtf8(), keyName.toUtf8());
   } else {
-    ini.sections[appName][keyName] = value;
+    ini.set(appName.toUtf8(), keyName.toUtf8(), value.toUtf8());
+  }
+
+  // QSaveFile refuses to replace a read-only file, report it the same way a failed
+  // open would; this is checked first because SafeWriteFile logs an error for
+  // something the caller expects and handles
+  const QFileInfo info(fileName);
+  if (info.exists() && !info.isWritable()) {
+    SetLastError(ERROR_ACCESS_DENIED);
+    return false;
   }
 
   // write the modified ini file
-  QFile out(fileName);
-  if (!out.open(QIODeviceBase::WriteOnly | QIODeviceBase::Text)) {
+  try {
+    MOBase::SafeWriteFile out(fileName);
+    if (!ini.write(out.operator->()) || !out->commit()) {
+      return false;
+    }
+  } catch (const MOBase::Exception&) {
     return false;
   }
-  QTextStream outStream(&out);
-  ini.generate(outStream);
-  return ini.errors.empty();
+
+  return ini.table().errors().empty();
 }
 
 }  // namespace
@@ -134,17 +151,16 @@ bool WriteRegistryValue(const QString& appName, const QString& keyName,
 QString ReadRegistryValue(const QString& appName, const QString& keyName,
                           const QString& defaultValue, const QString& fileName)
 {
-  // read ini file
-  qinipp::Ini ini;
+  // read ini file, lookups are case-insensitive like GetPrivateProfileString
+  qinipp::Table ini;
   {
     // read ini file
     if (QFile::exists(fileName)) {
       QFile in(fileName);
-      if (!in.open(QIODeviceBase::ReadOnly | QIODeviceBase::Text)) {
+      if (!in.open(QIODeviceBase::ReadOnly)) {
         return defaultValue;
       }
-      QTextStream inStream(&in);
-      ini.parse(inStream);
+      ini.parse(in.readAll());
       in.close();
     }
   }
@@ -152,8 +168,8 @@ QString ReadRegistryValue(const QString& appName, const QString& keyName,
   if (appName.isNull()) {
     // return all section names in the file
     QString result;
-    for (const auto& sectionName : ini.sections | std::views::keys) {
-      result.append(sectionName);
+    for (const auto& section : ini.sections()) {
+      result.append(QString::fromUtf8(section.name));
       result += '\n';
     }
     result.chop(1);
@@ -162,22 +178,24 @@ QString ReadRegistryValue(const QString& appName, const QString& keyName,
   if (keyName.isNull()) {
     // return all key names in the section specified by the appName parameter
     QString result;
-    if (!ini.sections.contains(appName)) {
+    const auto* section = ini.find_section(appName.toUtf8());
+    if (section == nullptr) {
       return result;
     }
-    for (const auto& key : ini.sections[appName] | std::views::keys) {
-      result.append(key);
+    for (const auto& entry : ini.entries(*section)) {
+      result.append(QString::fromUtf8(entry.key));
       result += '\n';
     }
     result.chop(1);
     return result;
   }
 
-  try {
-    return ini.sections.at(appName).at(keyName);
-  } catch (...) {
+  const auto* entry = ini.find(appName.toUtf8(), keyName.toUtf8());
+  if (entry == nullptr) {
     return defaultValue;
   }
+
+  return QString::fromUtf8(entry->value);
 }
 
 }  // namespace MOBase
@@ -235,6 +235,8 @@ void TaskDialog::rememberChoice()
       QuestionBoxMemory::setFileMemory(m_rememberAction, m_rememberFile, b);
     }
   }
+
+  QuestionBoxMemory::flushMemory();
 }
 
 void TaskDialog::setButtons()
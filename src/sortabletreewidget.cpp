@@ -20,10 +20,51 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "sortabletreewidget.h"
 #include <QDropEvent>
+#include <QScrollBar>
+#include <algorithm>
+#include <map>
+#include <optional>
 
 namespace MOBase
 {
 
+namespace
+{
+  // rows from the top level down to the given index
+  std::vector<int> rowPath(QModelIndex index)
+  {
+    std::vector<int> path;
+    for (; index.isValid(); index = index.parent()) {
+      path.push_back(index.row());
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+  // a branch is taken whole when at least this many of its rows are selected and
+  // they are at least one in this many of its rows, otherwise only the selected
+  // rows are taken
+  constexpr std::size_t MinRebuildCount = 16;
+  constexpr std::size_t RebuildShare    = 2;
+
+  void collectExpanded(QTreeWidgetItem* item, std::vector<QTreeWidgetItem*>& expanded)
+  {
+    for (int i = 0; i < item->childCount(); ++i) {
+      QTreeWidgetItem* child = item->child(i);
+      if (child->childCount() == 0) {
+        continue;
+      }
+
+      if (child->isExpanded()) {
+        expanded.push_back(child);
+      }
+
+      collectExpanded(child, expanded);
+    }
+  }
+}  // namespace
+
 SortableTreeWidget::SortableTreeWidget(QWidget* parent)
     : QTreeWidget(parent), m_LocalMoveOnly(false)
 {}
@@ -57,17 +98,25 @@ bool SortableTreeWidget::dropMimeData(QTreeWidgetItem* parent, int index,
 bool SortableTreeWidget::moveSelection(QTreeWidgetItem* parent, int idx)
 {
   QModelIndex parentIndex = indexFromItem(parent);
-  std::vector<QPersistentModelIndex> persistentIndices;
-  Q_FOREACH (const QModelIndex& index, selectedIndexes()) {
+
+  // one index per selected row, in the order they are shown
+  std::vector<std::pair<std::vector<int>, QModelIndex>> rows;
+  for (const QModelIndex& index : selectionModel()->selectedRows(0)) {
     if (index == parentIndex)
       return false;
     if (m_LocalMoveOnly && (parentIndex != index.parent()))
       return false;
-    if (index.column() != 0)
-      continue;
-    persistentIndices.push_back(index);
+    rows.emplace_back(rowPath(index), index);
   }
 
+  if (rows.empty()) {
+    return false;
+  }
+
+  std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+
   int targetRow = -1;
   if (itemsExpandable() || !parentIndex.isValid()) {
     targetRow = model()->index(idx, 0, parentIndex).row();
@@ -81,34 +130,107 @@ bool SortableTreeWidget::moveSelection(QTreeWidgetItem* parent, int idx)
     parentIndex = QModelIndex();
   }
 
-  // remove items from the list, store in temporary location
-  QList<QTreeWidgetItem*> temp;
-  for (auto iter = persistentIndices.rbegin(); iter != persistentIndices.rend();
-       ++iter) {
-    QTreeWidgetItem* item = itemFromIndex(*iter);
-    if (item == nullptr)
+  QTreeWidgetItem* target =
+      parentIndex.isValid() ? itemFromIndex(parentIndex) : invisibleRootItem();
+
+  // every item is taken and inserted on its own by the model, which emits signals
+  // and updates the persistent indexes each time; when most of a branch is
+  // selected, its children are instead taken at once and the ones that stay are put
+  // back at once, which recreates the widgets and persistent indexes of the branch
+  std::map<QTreeWidgetItem*, std::vector<int>> sources;
+  QList<QTreeWidgetItem*> moved;
+
+  for (const auto& row : rows) {
+    QTreeWidgetItem* item = itemFromIndex(row.second);
+    if (item == nullptr) {
       continue;
-    if ((item == nullptr) || (item->parent() == nullptr)) {
-      temp.append(takeTopLevelItem(iter->row()));
-    } else {
-      temp.append(item->parent()->takeChild(iter->row()));
     }
+
+    QTreeWidgetItem* source = item->parent() ? item->parent() : invisibleRootItem();
+    sources[source].push_back(row.second.row());
+    moved.append(item);
   }
 
-  if (idx == -1) {
-    // append
-    if (parentIndex.isValid()) {
-      parent->addChildren(temp);
-    } else {
-      addTopLevelItems(temp);
+  if (moved.isEmpty()) {
+    return false;
+  }
+
+  // taking the items loses their state in the view
+  std::vector<QTreeWidgetItem*> expanded;
+  for (const auto& source : sources) {
+    collectExpanded(source.first, expanded);
+  }
+
+  QTreeWidgetItem* current = currentItem();
+  const int scroll         = verticalScrollBar()->value();
+
+  // children of the target that stay, if its children are all taken
+  std::optional<QList<QTreeWidgetItem*>> targetKept;
+
+  for (const auto& [source, selected] : sources) {
+    const auto size = static_cast<std::size_t>(source->childCount());
+
+    if (selected.size() < MinRebuildCount || selected.size() * RebuildShare < size) {
+      // the selected rows are sorted, they are taken from the end so the rows
+      // before them stay valid
+      for (auto row = selected.rbegin(); row != selected.rend(); ++row) {
+        source->takeChild(*row);
+      }
+
+      continue;
     }
-  } else {
-    if (parentIndex.isValid()) {
-      parent->insertChildren(std::min<int>(targetRow, parent->childCount()), temp);
-    } else {
-      insertTopLevelItems(std::min<int>(targetRow, topLevelItemCount()), temp);
+
+    const QList<QTreeWidgetItem*> children = source->takeChildren();
+    QList<QTreeWidgetItem*> kept;
+    kept.reserve(children.size() - static_cast<qsizetype>(selected.size()));
+
+    auto next = selected.begin();
+    for (int i = 0; i < children.size(); ++i) {
+      if (next != selected.end() && *next == i) {
+        ++next;
+      } else {
+        kept.append(children[i]);
+      }
+    }
+
+    if (source == target) {
+      targetKept = std::move(kept);
+    } else if (!kept.isEmpty()) {
+      source->addChildren(kept);
     }
   }
+
+  int insertRow =
+      targetKept ? static_cast<int>(targetKept->size()) : target->childCount();
+  if (idx != -1) {
+    insertRow = std::min<int>(targetRow, insertRow);
+  }
+
+  if (targetKept) {
+    target->addChildren(targetKept->mid(0, insertRow) + moved +
+                        targetKept->mid(insertRow));
+  } else {
+    target->insertChildren(insertRow, moved);
+  }
+
+  for (QTreeWidgetItem* item : expanded) {
+    item->setExpanded(true);
+  }
+
+  // the moved items are contiguous now
+  const QModelIndex first = indexFromItem(moved.front(), 0);
+  const QModelIndex last  = indexFromItem(moved.back(), columnCount() - 1);
+
+  if (current != nullptr) {
+    setCurrentItem(current, 0, QItemSelectionModel::NoUpdate);
+  }
+
+  selectionModel()->select(QItemSelection(first, last),
+                           QItemSelectionModel::ClearAndSelect);
+
+  executeDelayedItemsLayout();
+  verticalScrollBar()->setValue(scroll);
+
   emit itemsMoved();
   return true;
 }
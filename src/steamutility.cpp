@@ -23,14 +23,20 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "log.h"
 #include "utility.h"
 
+#include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
 #include <QList>
-#include <QRegularExpression>
+#include <QSet>
 #include <QString>
 #include <QTextStream>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <limits>
 #include <ranges>
+#include <shared_mutex>
 #include <vdf_parser.hpp>
 
 using namespace Qt::StringLiterals;
@@ -38,10 +44,413 @@ using namespace Qt::StringLiterals;
 namespace MOBase
 {
 
-// Lines that contains libraries are in the format:
-//    "1" "Path\to\library"
-static const QRegularExpression
-    kSteamLibraryFilter("^\\s*\"(?<idx>[0-9]+)\"\\s*\"(?<path>.*)\"");
+namespace
+{
+
+  // how often files are checked for changes
+  constexpr std::chrono::seconds kSteamRefreshInterval(1);
+
+  constexpr Qt::CaseSensitivity kPathCaseSensitivity =
+#ifdef _WIN32
+      Qt::CaseInsensitive;
+#else
+      Qt::CaseSensitive;
+#endif
+
+  // modification time of the given file, or the lowest value if it does not exist
+  qint64 modificationTime(const QFileInfo& info)
+  {
+    if (!info.exists()) {
+      return std::numeric_limits<qint64>::min();
+    }
+
+    return info.lastModified().toMSecsSinceEpoch();
+  }
+
+  // canonical path if the directory exists, cleaned up path otherwise
+  QString normalizedPath(const QString& path)
+  {
+    const QString canonical = QFileInfo(path).canonicalFilePath();
+    if (!canonical.isEmpty()) {
+      return canonical;
+    }
+
+    return QDir::cleanPath(QDir::fromNativeSeparators(path));
+  }
+
+  std::optional<tyti::vdf::object> readVdf(const QFileInfo& info)
+  {
+    std::ifstream file(info.filesystemAbsoluteFilePath());
+    if (!file.is_open()) {
+      const int e = errno;
+      log::warn("Error opening {}, {}", info.absoluteFilePath(), strerror(e));
+      return {};
+    }
+
+    try {
+      return tyti::vdf::read(file);
+    } catch (const std::exception& e) {
+      log::warn("Error parsing {}, {}", info.absoluteFilePath(), e.what());
+      return {};
+    }
+  }
+
+  QString attribute(const tyti::vdf::object& object, const char* name)
+  {
+    const auto itor = object.attribs.find(name);
+    if (itor == object.attribs.end()) {
+      return {};
+    }
+
+    return QString::fromStdString(itor->second);
+  }
+
+  // the Steam installation and the libraries in steamapps/libraryfolders.vdf
+  QStringList readLibraries(const QString& steamPath, const QFileInfo& libraryFolders)
+  {
+    QStringList libraries = {normalizedPath(steamPath)};
+
+    auto add = [&](const std::string& path) {
+      const QString library = normalizedPath(QString::fromStdString(path));
+      if (!library.isEmpty() && !libraries.contains(library, kPathCaseSensitivity)) {
+        libraries.append(library);
+      }
+    };
+
+    if (!libraryFolders.exists()) {
+      return libraries;
+    }
+
+    const auto root = readVdf(libraryFolders);
+    if (!root) {
+      return libraries;
+    }
+
+    // current format:
+    //   "0" { "path" "Path\\to\\library" ... }
+    for (const auto& child : root->childs | std::views::values) {
+      const auto path = child->attribs.find("path");
+      if (path != child->attribs.end()) {
+        add(path->second);
+      }
+    }
+
+    // old format:
+    //   "1" "Path\\to\\library"
+    for (const auto& [key, value] : root->attribs) {
+      if (!key.empty() && std::ranges::all_of(key, [](char c) {
+            return c >= '0' && c <= '9';
+          })) {
+        add(value);
+      }
+    }
+
+    return libraries;
+  }
+
+  std::optional<SteamInstallationCache::App> readManifest(const QFileInfo& manifest,
+                                                          const QString& steamApps)
+  {
+    const auto root = readVdf(manifest);
+    if (!root) {
+      return {};
+    }
+
+    SteamInstallationCache::App app;
+    app.appID      = attribute(*root, "appid");
+    app.name       = attribute(*root, "name");
+    app.installDir = attribute(*root, "installdir");
+    app.steamApps  = steamApps;
+
+    if (app.appID.isEmpty() || app.installDir.isEmpty()) {
+      log::warn("Error parsing {}: appid or installdir not found",
+                manifest.absoluteFilePath());
+      return {};
+    }
+
+    // "BetaKey" in "UserConfig" is the installed branch, missing for the default one
+    const auto userConfig = root->childs.find("UserConfig");
+    if (userConfig != root->childs.end()) {
+      app.branch = attribute(*userConfig->second, "BetaKey");
+    }
+
+    return app;
+  }
+
+  // InstallConfigStore -> Software -> Valve -> Steam -> CompatToolMapping, the default
+  // tool is stored as appID 0
+  QHash<QString, QString> readCompatTools(const QFileInfo& config)
+  {
+    QHash<QString, QString> tools;
+
+    if (!config.exists()) {
+      return tools;
+    }
+
+    const auto root = readVdf(config);
+    if (!root) {
+      return tools;
+    }
+
+    try {
+      const auto& software = root->childs.at("Software");
+
+      // according to ProtonUp-Qt source code, the key can either be "Valve" or "valve"
+      auto valve = software->childs.find("Valve");
+      if (valve == software->childs.end()) {
+        valve = software->childs.find("valve");
+      }
+
+      if (valve == software->childs.end()) {
+        return tools;
+      }
+
+      const auto& mappings =
+          valve->second->childs.at("Steam")->childs.at("CompatToolMapping");
+
+      for (const auto& [appID, mapping] : mappings->childs) {
+        tools.insert(QString::fromStdString(appID), attribute(*mapping, "name"));
+      }
+    } catch (const std::out_of_range&) {
+      // no mappings
+    }
+
+    return tools;
+  }
+
+}  // namespace
+
+struct SteamInstallationCache::Data
+{
+  struct Manifest
+  {
+    qint64 modified;
+    std::optional<App> app;
+  };
+
+  // manifests of a library by file name
+  using Library = QHash<QString, Manifest>;
+
+  explicit Data(const QString& path) : steamPath(path) {}
+
+  const QString steamPath;
+
+  mutable std::shared_mutex mutex;
+  std::chrono::steady_clock::time_point checked;
+  bool valid = false;
+
+  qint64 librariesModified = std::numeric_limits<qint64>::min();
+  QStringList libraries;
+  QHash<QString, Library> manifests;
+
+  qint64 configModified = std::numeric_limits<qint64>::min();
+  QHash<QString, QString> compatTools;
+
+  QList<App> apps;
+  QHash<QString, qsizetype> appsByID;
+
+  bool isFresh() const
+  {
+    return valid && std::chrono::steady_clock::now() - checked < kSteamRefreshInterval;
+  }
+
+  // checks every file for changes and reads the ones that have changed, must be
+  // called with the mutex locked exclusively
+  void refresh()
+  {
+    const QDir steamDir(steamPath);
+
+    if (steamPath.isEmpty() || !steamDir.exists()) {
+      libraries.clear();
+      manifests.clear();
+      compatTools.clear();
+      apps.clear();
+      appsByID.clear();
+
+      valid   = true;
+      checked = std::chrono::steady_clock::now();
+      return;
+    }
+
+    bool changed = !valid;
+
+    const QFileInfo libraryFolders(
+        steamDir.absoluteFilePath("steamapps/libraryfolders.vdf"));
+    const qint64 librariesStamp = modificationTime(libraryFolders);
+    if (!valid || librariesStamp != librariesModified) {
+      librariesModified = librariesStamp;
+      libraries         = readLibraries(steamPath, libraryFolders);
+      changed           = true;
+    }
+
+    // libraries that have been removed
+    for (auto itor = manifests.begin(); itor != manifests.end();) {
+      if (libraries.contains(itor.key())) {
+        ++itor;
+      } else {
+        itor    = manifests.erase(itor);
+        changed = true;
+      }
+    }
+
+    for (const auto& library : libraries) {
+      changed |= refreshLibrary(library, manifests[library]);
+    }
+
+    const QFileInfo config(steamDir.absoluteFilePath("config/config.vdf"));
+    const qint64 configStamp = modificationTime(config);
+    if (!valid || configStamp != configModified) {
+      configModified = configStamp;
+      compatTools    = readCompatTools(config);
+    }
+
+    if (changed) {
+      rebuildApps();
+    }
+
+    valid   = true;
+    checked = std::chrono::steady_clock::now();
+  }
+
+  // one directory listing, only manifests that are new or changed are read
+  static bool refreshLibrary(const QString& path, Library& library)
+  {
+    const QDir steamApps(path + "/steamapps");
+    const QFileInfoList files =
+        steamApps.entryInfoList({u"appmanifest_*.acf"_s}, QDir::Files);
+
+    bool changed = false;
+    QSet<QString> seen;
+
+    for (const QFileInfo& file : files) {
+      const QString name    = file.fileName();
+      const qint64 modified = modificationTime(file);
+
+      seen.insert(name);
+
+      const auto itor = library.constFind(name);
+      if (itor != library.constEnd() && itor->modified == modified) {
+        continue;
+      }
+
+      library.insert(name, Manifest{modified, readManifest(file, steamApps.path())});
+      changed = true;
+    }
+
+    for (auto itor = library.begin(); itor != library.end();) {
+      if (seen.contains(itor.key())) {
+        ++itor;
+      } else {
+        itor    = library.erase(itor);
+        changed = true;
+      }
+    }
+
+    return changed;
+  }
+
+  void rebuildApps()
+  {
+    apps.clear();
+    appsByID.clear();
+
+    for (const auto& library : libraries) {
+      for (const auto& manifest : manifests[library]) {
+        if (!manifest.app || appsByID.contains(manifest.app->appID)) {
+          continue;
+        }
+
+        appsByID.insert(manifest.app->appID, apps.size());
+        apps.append(*manifest.app);
+      }
+    }
+  }
+};
+
+SteamInstallationCache::SteamInstallationCache(const QString& steamPath)
+    : m_data(std::make_unique<Data>(steamPath))
+{}
+
+SteamInstallationCache::~SteamInstallationCache() = default;
+
+SteamInstallationCache& SteamInstallationCache::instance()
+{
+  static SteamInstallationCache cache(findSteamCached());
+  return cache;
+}
+
+SteamInstallationCache::Data& SteamInstallationCache::fresh() const
+{
+  {
+    std::shared_lock lock(m_data->mutex);
+    if (m_data->isFresh()) {
+      return *m_data;
+    }
+  }
+
+  std::unique_lock lock(m_data->mutex);
+  if (!m_data->isFresh()) {
+    m_data->refresh();
+  }
+
+  return *m_data;
+}
+
+QStringList SteamInstallationCache::libraries() const
+{
+  const auto& data = fresh();
+  std::shared_lock lock(data.mutex);
+  return data.libraries;
+}
+
+QList<SteamInstallationCache::App> SteamInstallationCache::apps() const
+{
+  const auto& data = fresh();
+  std::shared_lock lock(data.mutex);
+  return data.apps;
+}
+
+std::optional<SteamInstallationCache::App>
+SteamInstallationCache::app(const QString& appID) const
+{
+  const auto& data = fresh();
+  std::shared_lock lock(data.mutex);
+
+  const auto itor = data.appsByID.constFind(appID);
+  if (itor == data.appsByID.constEnd()) {
+    return {};
+  }
+
+  return data.apps[*itor];
+}
+
+std::optional<SteamInstallationCache::App>
+SteamInstallationCache::appManifest(const QString& gameLocation, const QString& appID)
+{
+  const QString steamApps = normalizedPath(gameLocation % "/../.."_L1);
+  return readManifest(QFileInfo(steamApps % "/appmanifest_"_L1 % appID % ".acf"_L1),
+                      steamApps);
+}
+
+QString SteamInstallationCache::compatTool(const QString& appID) const
+{
+  const auto& data = fresh();
+  std::shared_lock lock(data.mutex);
+
+  auto itor = data.compatTools.constFind(appID);
+  if (itor == data.compatTools.constEnd()) {
+    // not set for this app, use the default
+    itor = data.compatTools.constFind(u"0"_s);
+  }
+
+  return itor == data.compatTools.constEnd() ? QString() : *itor;
+}
+
+void SteamInstallationCache::invalidate()
+{
+  std::unique_lock lock(m_data->mutex);
+  m_data->valid = false;
+}
 
 QString findSteamCached()
 {
@@ -51,33 +460,23 @@ QString findSteamCached()
 
 QString findSteamGame(const QString& appName, const QString& validFile)
 {
-  QStringList libraryFolders;  // list of Steam libraries to search
-  QDir steamDir(findSteam());  // Steam installation directory
-
-  // Can do nothing if Steam doesn't exist
-  if (!steamDir.exists())
-    return "";
-
-  // The Steam install is always a valid library
-  libraryFolders << steamDir.absolutePath();
-
-  // Search libraryfolders.vdf for additional libraries
-  QFile libraryFoldersFile(steamDir.absoluteFilePath("steamapps/libraryfolders.vdf"));
-  if (libraryFoldersFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    QTextStream in(&libraryFoldersFile);
-    while (!in.atEnd()) {
-      QString line                  = in.readLine();
-      QRegularExpressionMatch match = kSteamLibraryFilter.match(line);
-      if (match.hasMatch()) {
-        QString folder = match.captured("path");
-        folder.replace("/", "\\").replace("\\\\", "\\");
-        libraryFolders << folder;
-      }
+  const auto& cache = SteamInstallationCache::instance();
+
+  // games installed by Steam have a manifest
+  for (const auto& app : cache.apps()) {
+    if (app.installDir.compare(appName, Qt::CaseInsensitive) != 0) {
+      continue;
+    }
+
+    const QDir gameDir(app.path());
+    if (gameDir.exists() && (validFile.isEmpty() || gameDir.exists(validFile))) {
+      return gameDir.absolutePath();
     }
   }
 
-  // Search the Steam libraries for the game directory
-  for (auto library : libraryFolders) {
+  // Search the Steam libraries for the game directory, for games that were copied
+  // into a library
+  for (const auto& library : cache.libraries()) {
     QDir libraryDir(library);
     if (!libraryDir.cd("steamapps/common/" + appName))
       continue;
@@ -124,32 +523,35 @@ QString appIdByGamePath(const QString& gameLocation)
     installPath.truncate(pos);
   }
 
-  // iterate over app manifests
-  QDirIterator it(steamAppsPath, QStringList(u"appmanifest_*.acf"_s), QDir::Files);
-  while (it.hasNext()) {
-    QString item = it.next();
+  steamAppsPath = normalizedPath(steamAppsPath);
 
-    // open a manifest file
-    std::ifstream file(item.toStdString());
-    if (!file.is_open()) {
-      const int e = errno;
-      log::warn("Error opening manifest file {}, {}", item.toStdString(), strerror(e));
-      return {};
+  // libraries are stored with their canonical path
+  for (const auto& app : SteamInstallationCache::instance().apps()) {
+    // compare installation paths
+    if (app.installDir == installPath &&
+        app.steamApps.compare(steamAppsPath, kPathCaseSensitivity) == 0) {
+      log::debug("Found appID {}", app.appID);
+      return app.appID;
     }
+  }
 
-    // read the manifest file
-    auto root              = tyti::vdf::read(file);
-    std::string installdir = root.attribs["installdir"];
-    if (installdir.empty()) {
-      log::error("Error parsing appmanifest: installdir not found");
-      return {};
-    }
+  // the library may not be known to the cache, e.g. it belongs to another Steam
+  // installation, so the manifests next to the game are read directly
+  const QString prefix   = u"appmanifest_"_s;
+  const QString suffix   = u".acf"_s;
+  const QString gamePath = steamAppsPath % "/common/"_L1 % installPath;
 
-    // compare installation paths
-    if (installPath.toStdString() == installdir) {
-      QString appID = QString::fromStdString(root.attribs["appid"]);
-      log::debug("Found appID {}", appID);
-      return appID;
+  const auto manifests =
+      QDir(steamAppsPath).entryList({prefix % "*"_L1 % suffix}, QDir::Files);
+
+  for (const auto& manifest : manifests) {
+    const QString appID =
+        manifest.mid(prefix.size(), manifest.size() - prefix.size() - suffix.size());
+
+    const auto app = SteamInstallationCache::appManifest(gamePath, appID);
+    if (app && app->installDir == installPath) {
+      log::debug("Found appID {} in {}", app->appID, manifest);
+      return app->appID;
     }
   }
 
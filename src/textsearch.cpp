@@ -0,0 +1,653 @@
+#include "textsearch.h"
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace MOBase
+{
+
+namespace
+{
+
+  // the text is searched in chunks of about this many bytes or characters, cut at
+  // line breaks
+  constexpr qint64 SearchChunkSize = 1024 * 1024;
+
+  // the search stops after this many matches, they take 16 bytes each
+  constexpr qint64 MaxMatches = 1000000;
+
+  // finished chunks are merged at most this often, in milliseconds
+  constexpr int MergeInterval = 50;
+
+  QThreadPool& searchThreadPool()
+  {
+    static QThreadPool pool;
+    return pool;
+  }
+
+  char asciiLower(char c)
+  {
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+  }
+
+  struct AsciiFoldHash
+  {
+    std::size_t operator()(char c) const { return std::hash<char>()(asciiLower(c)); }
+  };
+
+  struct AsciiFoldEqual
+  {
+    bool operator()(char a, char b) const { return asciiLower(a) == asciiLower(b); }
+  };
+
+  bool asciiStartsWith(const QByteArray& s, const QByteArray& prefix)
+  {
+    return s.size() >= prefix.size() &&
+           std::equal(prefix.begin(), prefix.end(), s.begin(), AsciiFoldEqual());
+  }
+
+  // start of the first line that starts at or after the offset
+  template <class Char>
+  qint64 lineStartFrom(const Char* data, qint64 begin, qint64 end, qint64 offset)
+  {
+    if (offset <= begin) {
+      return begin;
+    } else if (offset >= end) {
+      return end;
+    }
+
+    const Char* newline = std::find(data + offset - 1, data + end, Char(u'\n'));
+    return newline == data + end ? end : (newline - data) + 1;
+  }
+
+  // start of the line that contains the offset
+  template <class Char>
+  qint64 lineStartBefore(const Char* data, qint64 begin, qint64 offset)
+  {
+    const auto first   = std::make_reverse_iterator(data + offset);
+    const auto last    = std::make_reverse_iterator(data + begin);
+    const auto newline = std::find(first, last, Char(u'\n'));
+
+    return newline == last ? begin : newline.base() - data;
+  }
+
+  bool startsBefore(const TextSearch::Match& match, qint64 offset)
+  {
+    return match.begin < offset;
+  }
+
+  // decodes utf-8 like QString::fromUtf8(), but every byte that is not part of a
+  // valid sequence becomes one U+FFFD; `offsets` gets the offset of the byte that
+  // starts the sequence of each utf-16 code unit, followed by the size, so that
+  // positions in the text can be converted back to bytes even if the data is invalid
+  void decodeUtf8(const char* data, qint64 size, QString& text,
+                  std::vector<qint64>& offsets)
+  {
+    text.resize(size);
+    offsets.resize(static_cast<std::size_t>(size) + 1);
+
+    QChar* out        = text.data();
+    qint64* outOffset = offsets.data();
+
+    for (qint64 i = 0; i < size;) {
+      const auto lead = static_cast<uchar>(data[i]);
+
+      if (lead < 0x80) {
+        *out++       = QChar(static_cast<char16_t>(lead));
+        *outOffset++ = i++;
+        continue;
+      }
+
+      // number of continuation bytes and the range of the first one, which excludes
+      // overlong sequences, surrogates and code points past U+10FFFF
+      int count  = 0;
+      char32_t c = 0;
+      uchar low  = 0x80;
+      uchar high = 0xbf;
+
+      if (lead >= 0xc2 && lead <= 0xdf) {
+        count = 1;
+        c     = lead & 0x1f;
+      } else if (lead >= 0xe0 && lead <= 0xef) {
+        count = 2;
+        c     = lead & 0x0f;
+        low   = (lead == 0xe0 ? 0xa0 : 0x80);
+        high  = (lead == 0xed ? 0x9f : 0xbf);
+      } else if (lead >= 0xf0 && lead <= 0xf4) {
+        count = 3;
+        c     = lead & 0x07;
+        low   = (lead == 0xf0 ? 0x90 : 0x80);
+        high  = (lead == 0xf4 ? 0x8f : 0xbf);
+      }
+
+      int length = 1;
+      for (; count > 0 && length <= count && i + length < size; ++length) {
+        const auto b = static_cast<uchar>(data[i + length]);
+        if (b < low || b > high) {
+          break;
+        }
+
+        c    = (c << 6) | (b & 0x3f);
+        low  = 0x80;
+        high = 0xbf;
+      }
+
+      if (count == 0 || length <= count) {
+        *out++       = QChar::ReplacementCharacter;
+        *outOffset++ = i++;
+      } else if (QChar::requiresSurrogates(c)) {
+        *out++       = QChar(QChar::highSurrogate(c));
+        *out++       = QChar(QChar::lowSurrogate(c));
+        *outOffset++ = i;
+        *outOffset++ = i;
+        i += length;
+      } else {
+        *out++       = QChar(static_cast<char16_t>(c));
+        *outOffset++ = i;
+        i += length;
+      }
+    }
+
+    const qint64 decoded = out - text.data();
+    *outOffset           = size;
+
+    text.resize(decoded);
+    offsets.resize(static_cast<std::size_t>(decoded) + 1);
+  }
+
+}  // namespace
+
+// text given to appendText(), what is appended later is written after it as long as
+// there is room, the jobs only read up to their own end
+struct TextSearch::TextBuffer
+{
+  std::unique_ptr<QChar[]> chars;
+  qint64 capacity = 0;
+};
+
+struct TextSearch::Job
+{
+  // one of these is searched, the owner keeps it alive
+  std::shared_ptr<const void> owner;
+  const QChar* text = nullptr;
+  const char* data  = nullptr;
+
+  qint64 begin = 0;
+  qint64 end   = 0;
+
+  QString pattern;
+  QByteArray needle;
+  QRegularExpression regex;
+  bool isRegex = false;
+
+  // the matches of the previous pattern if this one extends it, only those are
+  // checked
+  std::shared_ptr<const Job> previous;
+
+  // matches found in each chunk, moved to `matches` once merged
+  std::vector<std::vector<Match>> results;
+  std::unique_ptr<std::atomic<bool>[]> finished;
+
+  std::atomic<qint64> next    = 0;
+  std::atomic<bool> cancelled = false;
+
+  // only used on the gui thread, never modified once the job is complete
+  std::vector<Match> matches;
+  qint64 merged  = 0;
+  bool truncated = false;
+
+  qint64 chunkCount() const
+  {
+    return (end - begin + SearchChunkSize - 1) / SearchChunkSize;
+  }
+
+  bool isComplete() const { return truncated || merged == chunkCount(); }
+
+  qint64 chunkStart(qint64 chunk) const
+  {
+    const qint64 offset = begin + chunk * SearchChunkSize;
+
+    if (text) {
+      return lineStartFrom(text, begin, end, offset);
+    } else {
+      return lineStartFrom(data, begin, end, offset);
+    }
+  }
+
+  // searches chunks until none are left
+  void work()
+  {
+    const qint64 count = chunkCount();
+
+    for (qint64 chunk = next++; chunk < count; chunk = next++) {
+      if (!cancelled) {
+        const qint64 from = chunkStart(chunk);
+        const qint64 to   = chunkStart(chunk + 1);
+        auto& out         = results[static_cast<std::size_t>(chunk)];
+
+        if (previous) {
+          refine(from, to, out);
+        } else if (isRegex) {
+          searchRegex(from, to, out);
+        } else {
+          searchLiteral(from, to, out);
+        }
+      }
+
+      finished[chunk].store(true, std::memory_order_release);
+    }
+  }
+
+  void searchLiteral(qint64 from, qint64 to, std::vector<Match>& out) const
+  {
+    if (text) {
+      const QStringView chunk(text + from, to - from);
+
+      for (qsizetype i = chunk.indexOf(pattern, 0, Qt::CaseInsensitive);
+           i >= 0 && !cancelled;
+           i = chunk.indexOf(pattern, i + 1, Qt::CaseInsensitive)) {
+        out.push_back({from + i, from + i + pattern.size()});
+      }
+
+      return;
+    }
+
+    const std::boyer_moore_horspool_searcher searcher(
+        needle.begin(), needle.end(), AsciiFoldHash(), AsciiFoldEqual());
+
+    for (const char* p = std::search(data + from, data + to, searcher);
+         p != data + to && !cancelled; p = std::search(p + 1, data + to, searcher)) {
+      out.push_back({p - data, p - data + needle.size()});
+    }
+  }
+
+  void searchRegex(qint64 from, qint64 to, std::vector<Match>& out) const
+  {
+    if (text) {
+      // the rest of the text is not part of this chunk
+      auto itor = regex.globalMatch(QStringView(text, to), from);
+
+      while (itor.hasNext() && !cancelled) {
+        const auto match = itor.next();
+
+        if (match.capturedLength() > 0) {
+          out.push_back({match.capturedStart(), match.capturedEnd()});
+        }
+      }
+
+      return;
+    }
+
+    QString chunk;
+    std::vector<qint64> offsets;
+    decodeUtf8(data + from, to - from, chunk, offsets);
+
+    // offsets in the decoded chunk back to bytes
+    const auto offset = [&](qsizetype position) {
+      return std::clamp(from + offsets[static_cast<std::size_t>(position)], from, to);
+    };
+
+    auto itor = regex.globalMatch(chunk);
+
+    while (itor.hasNext() && !cancelled) {
+      const auto match = itor.next();
+      if (match.capturedLength() == 0) {
+        continue;
+      }
+
+      out.push_back({offset(match.capturedStart()), offset(match.capturedEnd())});
+    }
+  }
+
+  // a match of this pattern always starts where the previous pattern matched
+  void refine(qint64 from, qint64 to, std::vector<Match>& out) const
+  {
+    const auto& candidates = previous->matches;
+    auto itor =
+        std::lower_bound(candidates.begin(), candidates.end(), from, startsBefore);
+
+    for (; itor != candidates.end() && itor->begin < to && !cancelled; ++itor) {
+      const qint64 p = itor->begin;
+
+      if (text) {
+        const qint64 length = std::min<qint64>(pattern.size(), end - p);
+        const QStringView candidate(text + p, length);
+
+        if (candidate.compare(pattern, Qt::CaseInsensitive) == 0) {
+          out.push_back({p, p + pattern.size()});
+        }
+      } else if (p + needle.size() <= end &&
+                 std::equal(needle.begin(), needle.end(), data + p, AsciiFoldEqual())) {
+        out.push_back({p, p + needle.size()});
+      }
+    }
+  }
+};
+
+TextSearch::TextSearch(QObject* parent)
+    : QObject(parent), m_regex(false), m_text(nullptr), m_data(nullptr), m_begin(0),
+      m_end(0), m_current(-1)
+{
+  m_timer.setInterval(MergeInterval);
+  connect(&m_timer, &QTimer::timeout, this, [this] {
+    merge();
+  });
+}
+
+TextSearch::~TextSearch()
+{
+  if (m_job) {
+    m_job->cancelled = true;
+  }
+}
+
+void TextSearch::setText(QString text)
+{
+  auto owner = std::make_shared<const QString>(std::move(text));
+
+  m_text   = owner->constData();
+  m_data   = nullptr;
+  m_buffer = nullptr;
+  m_begin  = 0;
+  m_end    = owner->size();
+  m_owner  = std::move(owner);
+
+  restart(false);
+}
+
+void TextSearch::appendText(QStringView text)
+{
+  if (m_text == nullptr) {
+    setText(text.toString());
+    return;
+  }
+
+  const qint64 oldEnd = m_end;
+  const qint64 end    = oldEnd + text.size();
+
+  // the text is only copied if the buffer is full, the jobs keep the previous one
+  if (!m_buffer || m_buffer->capacity < end) {
+    const qint64 capacity = end + end / 2;
+
+    auto buffer      = std::make_shared<TextBuffer>();
+    buffer->capacity = capacity;
+    buffer->chars    = std::make_unique<QChar[]>(static_cast<std::size_t>(capacity));
+
+    std::copy(m_text + m_begin, m_text + oldEnd, buffer->chars.get() + m_begin);
+
+    m_text   = buffer->chars.get();
+    m_owner  = buffer;
+    m_buffer = std::move(buffer);
+  }
+
+  std::copy(text.begin(), text.end(), m_buffer->chars.get() + oldEnd);
+  m_end = end;
+
+  extend(oldEnd);
+}
+
+void TextSearch::setData(std::shared_ptr<const void> owner, const char* data,
+                         qint64 begin, qint64 end)
+{
+  m_text   = nullptr;
+  m_buffer = nullptr;
+  m_owner  = std::move(owner);
+  m_data   = data;
+  m_begin  = begin;
+  m_end    = end;
+
+  restart(false);
+}
+
+void TextSearch::extendData(std::shared_ptr<const void> owner, const char* data,
+                            qint64 end)
+{
+  if (m_text != nullptr) {
+    setData(std::move(owner), data, m_begin, end);
+    return;
+  }
+
+  const qint64 oldEnd = m_end;
+
+  m_owner = std::move(owner);
+  m_data  = data;
+  m_end   = end;
+
+  extend(oldEnd);
+}
+
+void TextSearch::extend(qint64 oldEnd)
+{
+  if (!m_job || !m_job->isComplete() || m_job->truncated || m_end < oldEnd) {
+    restart(false);
+    return;
+  }
+
+  // the last line may have been continued, it is searched again
+  const qint64 from   = m_text ? lineStartBefore(m_text, m_begin, oldEnd)
+                               : lineStartBefore(m_data, m_begin, oldEnd);
+  const auto& matches = m_job->matches;
+
+  auto job = makeJob(from);
+  job->matches.assign(matches.begin(), std::lower_bound(matches.begin(), matches.end(),
+                                                        from, startsBefore));
+
+  if (m_current >= static_cast<qint64>(job->matches.size())) {
+    m_current = -1;
+  }
+
+  start(std::move(job));
+}
+
+void TextSearch::setPattern(const QString& pattern, bool regex)
+{
+  if (pattern == m_pattern && regex == m_regex) {
+    return;
+  }
+
+  bool refine = false;
+
+  // the matches of a literal pattern are all at the start of a match of its
+  // prefixes, but only a complete list of them can be refined
+  if (!regex && !m_regex && m_job && m_job->isComplete() && !m_job->truncated &&
+      !m_pattern.isEmpty()) {
+    if (m_text) {
+      refine = pattern.startsWith(m_pattern, Qt::CaseInsensitive);
+    } else {
+      refine = asciiStartsWith(pattern.toUtf8(), m_job->needle);
+    }
+  }
+
+  m_pattern = pattern;
+  m_regex   = regex;
+
+  restart(refine);
+}
+
+bool TextSearch::isValid() const
+{
+  return !m_job || !m_job->isRegex || m_job->regex.isValid();
+}
+
+bool TextSearch::isComplete() const
+{
+  return !m_job || m_job->isComplete();
+}
+
+qint64 TextSearch::count() const
+{
+  return m_job ? static_cast<qint64>(m_job->matches.size()) : 0;
+}
+
+TextSearch::Match TextSearch::at(qint64 index) const
+{
+  return m_job->matches[static_cast<std::size_t>(index)];
+}
+
+qint64 TextSearch::indexAt(qint64 offset) const
+{
+  if (!m_job) {
+    return 0;
+  }
+
+  const auto& matches = m_job->matches;
+  const auto itor =
+      std::lower_bound(matches.begin(), matches.end(), offset, startsBefore);
+
+  return itor - matches.begin();
+}
+
+void TextSearch::setCurrent(qint64 index)
+{
+  m_current = index;
+}
+
+qint64 TextSearch::nextIndex(qint64 offset) const
+{
+  const qint64 count = this->count();
+  const qint64 index = m_current >= 0 ? m_current + 1 : indexAt(offset);
+
+  if (index < count) {
+    return index;
+  }
+
+  // the next match may not have been found yet
+  return (isComplete() && count > 0) ? 0 : -1;
+}
+
+qint64 TextSearch::previousIndex(qint64 offset) const
+{
+  const qint64 count = this->count();
+  const qint64 found = m_current >= 0 ? m_current : indexAt(offset);
+
+  if (found == count && !isComplete()) {
+    // there may be matches before the offset that have not been found yet
+    return -1;
+  }
+
+  if (found > 0) {
+    return found - 1;
+  }
+
+  // the last match is only known once everything was searched
+  return (isComplete() && count > 0) ? count - 1 : -1;
+}
+
+void TextSearch::restart(bool refine)
+{
+  const std::shared_ptr<const Job> previous = refine ? m_job : nullptr;
+
+  if (m_job) {
+    m_job->cancelled = true;
+    m_job.reset();
+  }
+
+  m_current = -1;
+
+  if (m_pattern.isEmpty() || (!m_text && !m_data)) {
+    m_timer.stop();
+    emit matchesChanged();
+    return;
+  }
+
+  auto job      = makeJob(m_begin);
+  job->previous = previous;
+
+  start(std::move(job));
+}
+
+std::shared_ptr<TextSearch::Job> TextSearch::makeJob(qint64 from) const
+{
+  auto job     = std::make_shared<Job>();
+  job->text    = m_text;
+  job->owner   = m_owner;
+  job->data    = m_data;
+  job->begin   = from;
+  job->end     = m_end;
+  job->pattern = m_pattern;
+  job->needle  = m_pattern.toUtf8();
+  job->isRegex = m_regex;
+
+  if (m_regex) {
+    job->regex = QRegularExpression(m_pattern,
+                                    QRegularExpression::CaseInsensitiveOption |
+                                        QRegularExpression::MultilineOption);
+
+    if (!job->regex.isValid()) {
+      // nothing to search, isValid() reports it
+      job->end = job->begin;
+    }
+  }
+
+  return job;
+}
+
+void TextSearch::start(std::shared_ptr<Job> job)
+{
+  const qint64 chunks = job->chunkCount();
+  job->results.resize(static_cast<std::size_t>(chunks));
+  job->finished =
+      std::make_unique<std::atomic<bool>[]>(static_cast<std::size_t>(chunks));
+
+  m_job = job;
+
+  if (chunks == 0) {
+    m_timer.stop();
+    emit matchesChanged();
+    return;
+  }
+
+  const auto workers = std::min<qint64>(searchThreadPool().maxThreadCount(), chunks);
+
+  for (qint64 i = 0; i < workers; ++i) {
+    searchThreadPool().start([job] {
+      job->work();
+    });
+  }
+
+  m_timer.start();
+
+  // the previous matches are gone
+  emit matchesChanged();
+}
+
+void TextSearch::merge()
+{
+  if (!m_job) {
+    m_timer.stop();
+    return;
+  }
+
+  Job& job            = *m_job;
+  const qint64 chunks = job.chunkCount();
+  bool changed        = false;
+
+  while (!job.truncated && job.merged < chunks &&
+         job.finished[job.merged].load(std::memory_order_acquire)) {
+    auto& results = job.results[static_cast<std::size_t>(job.merged)];
+    job.matches.insert(job.matches.end(), results.begin(), results.end());
+    std::vector<Match>().swap(results);
+
+    ++job.merged;
+    changed = true;
+
+    if (static_cast<qint64>(job.matches.size()) >= MaxMatches) {
+      job.matches.resize(static_cast<std::size_t>(MaxMatches));
+      job.truncated = true;
+      job.cancelled = true;
+    }
+  }
+
+  if (job.isComplete()) {
+    m_timer.stop();
+  }
+
+  if (changed) {
+    emit matchesChanged();
+  }
+}
+
+}  // namespace MOBase
@@ -20,30 +20,126 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "textviewer.h"
 #include "finddialog.h"
+#include "largetextview.h"
 #include "log.h"
 #include "report.h"
+#include "textsearch.h"
 #include "ui_textviewer.h"
 #include "utility.h"
 #include <QAction>
 #include <QFile>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QScrollBar>
 #include <QShortcutEvent>
+#include <QStringDecoder>
 #include <QTextEdit>
+#include <QTimer>
 #include <QVBoxLayout>
 
 namespace MOBase
 {
 
+namespace
+{
+
+  // read-only files at least this large are shown in a LargeTextView instead of
+  // being loaded in a document
+  constexpr qint64 LargeFileSize = 16 * 1024 * 1024;
+
+  // followed files are refreshed at most this often, in milliseconds
+  constexpr int FollowInterval = 250;
+
+  // files are also checked every this many refreshes, file system notifications are
+  // not reliable on network drives and stop when a file is renamed
+  constexpr int FollowPollTicks = 4;
+
+  // at most this much of a file is appended to a document per refresh
+  constexpr qint64 MaxFollowBytes = 1024 * 1024;
+
+  // a file that grew is only considered the same file if it starts with the same
+  // bytes
+  constexpr qsizetype FollowHeadSize = 256;
+
+  // the selected text of a document as toPlainText() would return it, with the
+  // paragraph separators as line breaks
+  QString plainText(QString text)
+  {
+    for (QChar& c : text) {
+      switch (c.unicode()) {
+      case QChar::ParagraphSeparator:
+      case QChar::LineSeparator:
+      case 0xfdd0:  // beginning of frame
+      case 0xfdd1:  // end of frame
+        c = u'\n';
+        break;
+
+      case QChar::Nbsp:
+        c = u' ';
+        break;
+      }
+    }
+
+    return text;
+  }
+
+  // set text highlighting color in inactive window equal to text hightlighting color
+  // in active window
+  void keepHighlightWhenInactive(QWidget* w)
+  {
+    QPalette palette = w->palette();
+    palette.setColor(QPalette::Inactive, QPalette::Highlight,
+                     palette.color(QPalette::Active, QPalette::Highlight));
+    palette.setColor(QPalette::Inactive, QPalette::HighlightedText,
+                     palette.color(QPalette::Active, QPalette::HighlightedText));
+    w->setPalette(palette);
+  }
+
+}  // namespace
+
+struct TextViewer::Follow
+{
+  QString fileName;
+  QStringDecoder decoder;
+
+  // number of bytes that were read
+  qint64 offset;
+
+  // the first bytes of the file
+  QByteArray head;
+};
+
 TextViewer::TextViewer(const QString& title, QWidget* parent)
-    : QDialog(parent), ui(new Ui::TextViewer), m_FindDialog(nullptr)
+    : QDialog(parent), ui(new Ui::TextViewer), m_FindDialog(nullptr),
+      m_FindRegex(false), m_PendingFind(PendingFind::None),
+      m_Watcher(new QFileSystemWatcher(this)), m_FollowTimer(new QTimer(this)),
+      m_FollowTicks(0)
 {
   ui->setupUi(this);
   setWindowTitle(title);
   m_EditorTabs = findChild<QTabWidget*>("editorTabs");
   connect(ui->showWhitespace, SIGNAL(stateChanged(int)), this,
           SLOT(showWhitespaceChanged(int)));
+  connect(ui->followFile, SIGNAL(stateChanged(int)), this, SLOT(followChanged(int)));
+
+  m_FollowTimer->setInterval(FollowInterval);
+  connect(m_FollowTimer, SIGNAL(timeout()), this, SLOT(followFiles()));
+  connect(m_Watcher, &QFileSystemWatcher::fileChanged, this,
+          [this](const QString& path) {
+            m_ChangedFiles.insert(path);
+          });
+
+  connect(m_EditorTabs, &QTabWidget::currentChanged, this, [this] {
+    m_PendingFind = PendingFind::None;
+
+    if (m_FindDialog && m_FindDialog->isVisible()) {
+      findSearch(true);
+    }
+
+    updateFindStatus();
+  });
 }
 
 TextViewer::~TextViewer()
@@ -75,8 +171,10 @@ void TextViewer::find()
   if (!m_FindDialog) {
     m_FindDialog = new FindDialog(this);
     connect(m_FindDialog, SIGNAL(findNext()), this, SLOT(findNext()));
+    connect(m_FindDialog, SIGNAL(findPrevious()), this, SLOT(findPrevious()));
     connect(m_FindDialog, SIGNAL(patternChanged(QString)), this,
             SLOT(patternChanged(QString)));
+    connect(m_FindDialog, SIGNAL(regexChanged(bool)), this, SLOT(regexChanged(bool)));
   }
 
   m_FindDialog->show();
@@ -87,38 +185,169 @@ void TextViewer::find()
 void TextViewer::patternChanged(QString newPattern)
 {
   m_FindPattern = newPattern;
+  m_PendingFind = PendingFind::None;
+
+  // starts searching in the background while the pattern is typed
+  findSearch(true);
+  updateFindStatus();
+}
+
+void TextViewer::regexChanged(bool regex)
+{
+  m_FindRegex   = regex;
+  m_PendingFind = PendingFind::None;
+
+  findSearch(true);
+  updateFindStatus();
 }
 
 void TextViewer::findNext()
 {
-  if (m_FindPattern.length() == 0) {
+  findMatch(true);
+}
+
+void TextViewer::findPrevious()
+{
+  findMatch(false);
+}
+
+void TextViewer::matchesChanged()
+{
+  if (sender() != findSearch(false)) {
+    // not the current tab
+    return;
+  }
+
+  if (m_PendingFind != PendingFind::None) {
+    // the match to jump to may have been found
+    findMatch(m_PendingFind == PendingFind::Next);
+  } else {
+    updateFindStatus();
+  }
+}
+
+TextSearch* TextViewer::findSearch(bool create)
+{
+  QWidget* currentPage = m_EditorTabs->currentWidget();
+  if (currentPage == nullptr) {
+    return nullptr;
+  }
+
+  TextSearch* search = nullptr;
+
+  if (auto* view = currentPage->findChild<LargeTextView*>("largeView")) {
+    search = &view->search();
+  } else {
+    search = currentPage->findChild<TextSearch*>("editorSearch");
+
+    if (search == nullptr) {
+      if (!create) {
+        return nullptr;
+      }
+
+      QTextEdit* editor = currentPage->findChild<QTextEdit*>("editorView");
+
+      search = new TextSearch(currentPage);
+      search->setObjectName("editorSearch");
+      search->setText(editor->toPlainText());
+
+      // what a followed file appends is searched on its own, any other change
+      // searches the whole document again
+      connect(editor->document(), &QTextDocument::contentsChange, search,
+              [search, editor](int position, int removed, int added) {
+                const QTextDocument* document = editor->document();
+
+                if (removed == 0 && position == search->end() &&
+                    position + added < document->characterCount()) {
+                  QTextCursor cursor(editor->document());
+                  cursor.setPosition(position);
+                  cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+                  search->appendText(plainText(cursor.selectedText()));
+                } else {
+                  search->setText(editor->toPlainText());
+                }
+              });
+    }
+  }
+
+  if (create) {
+    connect(search, &TextSearch::matchesChanged, this, &TextViewer::matchesChanged,
+            Qt::UniqueConnection);
+    search->setPattern(m_FindPattern, m_FindRegex);
+  }
+
+  return search;
+}
+
+void TextViewer::findMatch(bool forward)
+{
+  m_PendingFind = PendingFind::None;
+
+  TextSearch* search = findSearch(true);
+  if (search == nullptr || m_FindPattern.isEmpty()) {
     return;
   }
 
   QWidget* currentPage = m_EditorTabs->currentWidget();
+  auto* view           = currentPage->findChild<LargeTextView*>("largeView");
   QTextEdit* editor    = currentPage->findChild<QTextEdit*>("editorView");
 
-  if (editor->find(m_FindPattern)) {
-    // found text
+  const qint64 selectionStart =
+      view ? view->selectionStart() : editor->textCursor().selectionStart();
+  const qint64 selectionEnd =
+      view ? view->selectionEnd() : editor->textCursor().selectionEnd();
+
+  // the user may have moved the cursor since the last jump, searching continues
+  // from there
+  if (search->current() >= 0) {
+    const auto match = search->at(search->current());
+    if (match.begin != selectionStart || match.end != selectionEnd) {
+      search->setCurrent(-1);
+    }
+  }
+
+  const qint64 index = forward ? search->nextIndex(selectionEnd)
+                               : search->previousIndex(selectionStart);
+
+  if (index < 0) {
+    if (!search->isComplete()) {
+      m_PendingFind = forward ? PendingFind::Next : PendingFind::Previous;
+    }
+
+    updateFindStatus();
     return;
+  }
+
+  const auto match = search->at(index);
+  search->setCurrent(index);
+
+  if (view) {
+    view->select(match.begin, match.end);
   } else {
-    // reached the bottom and no text found,
-    // we wrap around once.
+    QTextCursor cursor(editor->document());
+    cursor.setPosition(static_cast<int>(match.begin));
+    cursor.setPosition(static_cast<int>(match.end), QTextCursor::KeepAnchor);
+    editor->setTextCursor(cursor);
+  }
 
-    // save current cursor
-    auto oldCursor = editor->textCursor();
+  updateFindStatus();
+}
+
+void TextViewer::updateFindStatus()
+{
+  if (!m_FindDialog) {
+    return;
+  }
 
-    editor->moveCursor(QTextCursor::Start);
+  const TextSearch* search = findSearch(false);
 
-    // search again from the top
-    if (editor->find(m_FindPattern)) {
-      // found something, keep new cursor position.
-      return;
-    } else {
-      // there are no matches in the document,
-      // restore previous cursor.
-      editor->setTextCursor(oldCursor);
-    }
+  if (search == nullptr) {
+    m_FindDialog->setMatches(-1, 0, true);
+  } else if (!search->isValid()) {
+    m_FindDialog->setError(tr("Invalid regular expression"));
+  } else {
+    m_FindDialog->setMatches(search->current(), search->count(),
+                             search->isComplete());
   }
 }
 
@@ -137,10 +366,125 @@ void TextViewer::showWhitespaceChanged(int state)
       textOption.setFlags(flags);
       document->setDefaultTextOption(textOption);
       editor->setDocument(document);
+    } else if (auto* view = m_EditorTabs->widget(i)->findChild<LargeTextView*>()) {
+      view->setShowWhitespace(state != Qt::Unchecked);
+    }
+  }
+}
+
+void TextViewer::setFollowing(bool follow)
+{
+  ui->followFile->setChecked(follow);
+}
+
+bool TextViewer::isFollowing() const
+{
+  return ui->followFile->isChecked();
+}
+
+void TextViewer::followChanged(int state)
+{
+  if (state == Qt::Unchecked) {
+    m_FollowTimer->stop();
+    m_ChangedFiles.clear();
+
+    if (!m_Watcher->files().isEmpty()) {
+      m_Watcher->removePaths(m_Watcher->files());
+    }
+
+    return;
+  }
+
+  // catches up with what was written while not following, this also starts
+  // watching the files
+  m_FollowTicks = FollowPollTicks - 1;
+  followFiles();
+  m_FollowTimer->start();
+}
+
+void TextViewer::followFiles()
+{
+  const bool poll             = ++m_FollowTicks % FollowPollTicks == 0;
+  const QStringList watched   = m_Watcher->files();
+  const QSet<QString> changed = std::exchange(m_ChangedFiles, {});
+
+  for (int i = 0; i < m_EditorTabs->count(); ++i) {
+    QWidget* page = m_EditorTabs->widget(i);
+    QString fileName;
+
+    if (auto* view = page->findChild<LargeTextView*>("largeView")) {
+      fileName = view->fileName();
+
+      if (poll || changed.contains(fileName)) {
+        view->refresh();
+      }
+    } else if (auto* editor = page->findChild<QTextEdit*>("editorView")) {
+      auto itor = m_Follow.find(editor);
+      if (itor == m_Follow.end()) {
+        // writable
+        continue;
+      }
+
+      fileName = itor->second->fileName;
+
+      if ((poll || changed.contains(fileName)) &&
+          followDocument(editor, *itor->second)) {
+        // the rest is appended on the next refresh
+        m_ChangedFiles.insert(fileName);
+      }
+    }
+
+    // the watcher forgets files that are renamed or deleted
+    if (!fileName.isEmpty() && !watched.contains(fileName) &&
+        QFileInfo::exists(fileName)) {
+      m_Watcher->addPath(fileName);
     }
   }
 }
 
+bool TextViewer::followDocument(QTextEdit* editor, Follow& follow)
+{
+  QFile file(follow.fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // a rotated file may not have been created again yet
+    return false;
+  }
+
+  const qint64 size     = file.size();
+  const QByteArray head = file.peek(FollowHeadSize);
+
+  if (size < follow.offset || !head.startsWith(follow.head)) {
+    // truncated, or replaced by another file
+    follow.offset = 0;
+    follow.head.clear();
+    follow.decoder.resetState();
+    editor->clear();
+  }
+
+  if (size == follow.offset) {
+    return false;
+  }
+
+  file.seek(follow.offset);
+  const QByteArray bytes = file.read(std::min(size - follow.offset, MaxFollowBytes));
+
+  follow.offset += bytes.size();
+  follow.head = head.left(std::min<qint64>(FollowHeadSize, follow.offset));
+
+  QScrollBar* scrollBar = editor->verticalScrollBar();
+  const bool atBottom   = scrollBar->value() == scrollBar->maximum();
+
+  QTextCursor cursor(editor->document());
+  cursor.movePosition(QTextCursor::End);
+  cursor.insertText(follow.decoder.decode(bytes));
+
+  if (atBottom) {
+    scrollBar->setValue(scrollBar->maximum());
+  }
+
+  return follow.offset < size;
+}
+
 bool TextViewer::eventFilter(QObject* object, QEvent* event)
 {
   if (event->type() == QEvent::ShortcutOverride) {
@@ -149,6 +493,8 @@ bool TextViewer::eventFilter(QObject* object, QEvent* event)
       find();
     } else if (keyEvent->matches(QKeySequence::FindNext)) {
       findNext();
+    } else if (keyEvent->matches(QKeySequence::FindPrevious)) {
+      findPrevious();
     }
   }
   return QDialog::eventFilter(object, event);
@@ -228,7 +574,23 @@ void TextViewer::addFile(const QString& fileName, bool writable)
   if (!file.open(QIODevice::ReadOnly)) {
     throw Exception(tr("file not found: %1").arg(fileName));
   }
-  QByteArray temp = file.readAll();
+
+  if (!writable && file.size() >= LargeFileSize) {
+    // the view only handles utf-8, files with another bom are still loaded below
+    const auto encoding = QStringConverter::encodingForData(file.peek(4));
+
+    if (!encoding || *encoding == QStringConverter::Utf8) {
+      if (addLargeFile(fileName)) {
+        return;
+      }
+
+      log::warn("failed to map '{}', loading it in memory instead", fileName);
+    }
+  }
+
+  const QByteArray temp = file.readAll();
+  QStringDecoder decoder(
+      QStringConverter::encodingForData(temp).value_or(QStringConverter::Utf8));
 
   QWidget* page           = new QWidget();
   QVBoxLayout* layout     = new QVBoxLayout(page);
@@ -241,21 +603,14 @@ void TextViewer::addFile(const QString& fileName, bool writable)
   }
   editor->setDocument(document);
   editor->setAcceptRichText(false);
-  editor->setPlainText(QString(temp));
+  editor->setPlainText(decoder.decode(temp));
   editor->setLineWrapMode(QTextEdit::NoWrap);
   editor->setObjectName("editorView");
   editor->setDocumentTitle(fileName);
   editor->installEventFilter(this);
   editor->setReadOnly(!writable);
 
-  // set text highlighting color in inactive window equal to text hightlighting color in
-  // active window
-  QPalette palette = editor->palette();
-  palette.setColor(QPalette::Inactive, QPalette::Highlight,
-                   palette.color(QPalette::Active, QPalette::Highlight));
-  palette.setColor(QPalette::Inactive, QPalette::HighlightedText,
-                   palette.color(QPalette::Active, QPalette::HighlightedText));
-  editor->setPalette(palette);
+  keepHighlightWhenInactive(editor);
 
   // add hotkeys for searching through the document
   QAction* findAction = new QAction(QString("&Find"), editor);
@@ -274,5 +629,33 @@ void TextViewer::addFile(const QString& fileName, bool writable)
   }
   page->setLayout(layout);
   m_EditorTabs->addTab(page, QFileInfo(fileName).fileName());
+
+  if (!writable) {
+    m_Follow[editor] = std::make_unique<Follow>(
+        Follow{fileName, std::move(decoder), temp.size(), temp.left(FollowHeadSize)});
+  }
+}
+
+bool TextViewer::addLargeFile(const QString& fileName)
+{
+  QWidget* page       = new QWidget();
+  QVBoxLayout* layout = new QVBoxLayout(page);
+  LargeTextView* view = new LargeTextView(page);
+
+  if (!view->open(fileName)) {
+    delete page;
+    return false;
+  }
+
+  view->setObjectName("largeView");
+  view->setShowWhitespace(ui->showWhitespace->isChecked());
+  view->installEventFilter(this);
+  keepHighlightWhenInactive(view);
+
+  layout->addWidget(view);
+  page->setLayout(layout);
+  m_EditorTabs->addTab(page, QFileInfo(fileName).fileName());
+
+  return true;
 }
 }  // namespace MOBase
@@ -25,14 +25,23 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <QBuffer>
 #include <QCollator>
 #include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
 #include <QImage>
 #include <QLayout>
+#include <QPixmap>
+#include <QPointer>
+#include <QPromise>
 #include <QScreen>
 #include <QStringEncoder>
+#include <QThread>
+#include <QThreadPool>
 #include <QUuid>
 #include <QtDebug>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 #ifdef __cpp_lib_debugging
@@ -329,31 +338,32 @@ QDateTime fileTimeToQDateTime(const FILETIME& time, const QTimeZone& timeZone)
   return QDateTime::fromSecsSinceEpoch(unixTime, timeZone);
 }
 
-static int naturalCompareI(const QString& a, const QString& b)
+static const QCollator& naturalCollator(Qt::CaseSensitivity cs)
 {
-  static QCollator c = [] {
+  static const QCollator insensitive = [] {
     QCollator temp;
     temp.setNumericMode(true);
     temp.setCaseSensitivity(Qt::CaseInsensitive);
     return temp;
   }();
 
-  return c.compare(a, b);
-}
-
-int naturalCompare(const QString& a, const QString& b, Qt::CaseSensitivity cs)
-{
-  if (cs == Qt::CaseInsensitive) {
-    return naturalCompareI(a, b);
-  }
-
-  static QCollator c = [] {
+  static const QCollator sensitive = [] {
     QCollator temp;
     temp.setNumericMode(true);
     return temp;
   }();
 
-  return c.compare(a, b);
+  return cs == Qt::CaseInsensitive ? insensitive : sensitive;
+}
+
+int naturalCompare(const QString& a, const QString& b, Qt::CaseSensitivity cs)
+{
+  return naturalCollator(cs).compare(a, b);
+}
+
+QCollatorSortKey naturalSortKey(const QString& s, Qt::CaseSensitivity cs)
+{
+  return naturalCollator(cs).sortKey(s);
 }
 
 QString getOptionalKnownFolder(QStandardPaths::StandardLocation location)
@@ -479,6 +489,153 @@ void removeOldFiles(const QString& path, const QString& pattern, int numToKeep,
   }
 }
 
+namespace
+{
+
+  // reading executables can be slow on network drives and in wine prefixes, this
+  // keeps it off the global pool
+  QThreadPool& ioThreadPool()
+  {
+    static QThreadPool pool;
+    return pool;
+  }
+
+  // loads that are in progress by file, a request for a file that is already being
+  // loaded waits for the same load
+  //
+  // a future only keeps its last continuation, so the callbacks are kept here and a
+  // single continuation calls all of them
+  template <class T>
+  class PendingLoads
+  {
+  public:
+    using Callback = std::function<void(const T&)>;
+
+    // calls the callback on the thread of the context once the file is loaded,
+    // unless the context has been destroyed by then
+    template <class F>
+    void run(const QString& key, QObject* context, Callback callback, F load)
+    {
+      std::scoped_lock lock(m_mutex);
+
+      auto& waiters    = m_waiters[key];
+      const bool first = waiters.empty();
+      waiters.push_back({context, std::move(callback)});
+
+      if (!first) {
+        return;
+      }
+
+      auto promise = std::make_shared<QPromise<T>>();
+      promise->start();
+
+      QFuture<T> future = promise->future();
+      future.then(QCoreApplication::instance(), [this, key](const T& result) {
+        notify(key, result);
+      });
+
+      ioThreadPool().start([promise, load = std::move(load)] {
+        promise->addResult(load());
+        promise->finish();
+      });
+    }
+
+  private:
+    struct Waiter
+    {
+      QPointer<QObject> context;
+      Callback callback;
+    };
+
+    std::mutex m_mutex;
+    QHash<QString, std::vector<Waiter>> m_waiters;
+
+    // called on the application thread
+    void notify(const QString& key, const T& result)
+    {
+      std::vector<Waiter> waiters;
+
+      {
+        std::scoped_lock lock(m_mutex);
+        waiters = m_waiters.take(key);
+      }
+
+      for (auto& waiter : waiters) {
+        if (!waiter.context) {
+          continue;
+        }
+
+        if (waiter.context->thread() == QThread::currentThread()) {
+          waiter.callback(result);
+        } else {
+          QMetaObject::invokeMethod(
+              waiter.context,
+              [callback = std::move(waiter.callback), result] {
+                callback(result);
+              },
+              Qt::QueuedConnection);
+        }
+      }
+    }
+  };
+
+  PendingLoads<QImage>& pendingIcons()
+  {
+    static PendingLoads<QImage> loads;
+    return loads;
+  }
+
+  PendingLoads<QString>& pendingFileVersions()
+  {
+    static PendingLoads<QString> loads;
+    return loads;
+  }
+
+}  // namespace
+
+QIcon iconForExecutableAsync(const QString& filePath, QObject* context,
+                             std::function<void(const QIcon&)> callback)
+{
+  const QIcon placeholder(QStringLiteral(":/MO/gui/executable"));
+
+#ifdef __unix__
+  // desktop entries refer to theme icons, there is nothing to load
+  if (filePath.endsWith(QStringLiteral(".desktop"))) {
+    const QIcon icon = iconForExecutable(filePath);
+    QMetaObject::invokeMethod(
+        context,
+        [callback = std::move(callback), icon] {
+          callback(icon);
+        },
+        Qt::QueuedConnection);
+    return icon;
+  }
+#endif
+
+  const QString key = QFileInfo(filePath).absoluteFilePath();
+
+  // pixmaps can only be created on the gui thread, the pool only decodes the image
+  auto onLoaded = [callback = std::move(callback), placeholder](const QImage& image) {
+    callback(image.isNull() ? placeholder : QIcon(QPixmap::fromImage(image)));
+  };
+
+  pendingIcons().run(key, context, std::move(onLoaded), [key] {
+    return iconImageForExecutable(key);
+  });
+
+  return placeholder;
+}
+
+void fileVersionAsync(const QString& filepath, QObject* context,
+                      std::function<void(const QString&)> callback)
+{
+  const QString key = QFileInfo(filepath).absoluteFilePath();
+
+  pendingFileVersions().run(key, context, std::move(callback), [key] {
+    return getFileVersion(key);
+  });
+}
+
 void deleteChildWidgets(QWidget* w)
 {
   auto* ly = w->layout();
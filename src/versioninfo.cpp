@@ -21,13 +21,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "versioninfo.h"
 #include <QDateTime>
 #include <QLocale>
-#include <QRegularExpression>
 #include <QVersionNumber>
-
-namespace
-{
-const QRegularExpression VERSION_REGEX("^(\\d+)(\\.(\\d+))?(\\.(\\d+))?(\\.(\\d+))?");
-}
+#include <array>
 
 namespace MOBase
 {
@@ -199,45 +194,43 @@ QVersionNumber VersionInfo::asQVersionNumber() const
   return QVersionNumber::fromString(displayString()).normalized();
 }
 
-QString VersionInfo::parseReleaseType(QString versionString)
+QString VersionInfo::parseReleaseType(QStringView versionString)
 {
   // release types are often followed by a number (i.e. "beta4"). This needs to be
   // extracted now, otherwise the outer parser will think it's the subminor version and
   // then 1.0.0rc1 would be interpreted as newer than 1.0.0
+  //
+  // the types are looked for in this order and the first one found wins
 
-  static std::map<QString, ReleaseType> typeStrings = {{"prealpha", RELEASE_PREALPHA},
-                                                       {"alpha", RELEASE_ALPHA},
-                                                       {"beta", RELEASE_BETA},
-                                                       {"rc", RELEASE_CANDIDATE}};
+  static constexpr std::pair<QLatin1StringView, ReleaseType> typeStrings[] = {
+      {QLatin1StringView("alpha"), RELEASE_ALPHA},
+      {QLatin1StringView("beta"), RELEASE_BETA},
+      {QLatin1StringView("prealpha"), RELEASE_PREALPHA},
+      {QLatin1StringView("rc"), RELEASE_CANDIDATE}};
 
   m_ReleaseType = RELEASE_FINAL;
 
-  auto typeIter = typeStrings.begin();
-  int offset    = -1;
+  qsizetype offset = -1;
+  qsizetype length = 0;
 
-  for (; (typeIter != typeStrings.end()) && (offset == -1); ++typeIter) {
-    offset = (int)versionString.indexOf(typeIter->first, Qt::CaseInsensitive);
+  for (const auto& [type, releaseType] : typeStrings) {
+    offset = versionString.indexOf(type, 0, Qt::CaseInsensitive);
     if (offset != -1) {
-      m_ReleaseType = typeIter->second;
+      m_ReleaseType = releaseType;
+      length        = type.size();
       break;
     }
   }
 
-  int length = 0;
-
-  if (typeIter != typeStrings.end()) {
-    length = (int)typeIter->first.length();
-  }
-
   if (m_Scheme == SCHEME_REGULAR) {
     // also interpret the a/b letters, but only if they follow immediately on the
     // version number, otherwise the margin for error is too big
     if ((offset == -1) && (versionString.length() > 0)) {
-      if (versionString.at(0) == 'a') {
+      if (versionString.at(0) == u'a') {
         m_ReleaseType = RELEASE_ALPHA;
         offset        = 0;
         length        = 1;
-      } else if (versionString.at(0) == 'b') {
+      } else if (versionString.at(0) == u'b') {
         m_ReleaseType = RELEASE_BETA;
         offset        = 0;
         length        = 1;
@@ -245,10 +238,13 @@ QString VersionInfo::parseReleaseType(QString versionString)
     }
   }
 
-  if (offset != -1) {
-    versionString.remove(offset, length);
+  if (offset == -1) {
+    return versionString.trimmed().toString();
   }
-  return versionString.trimmed();
+
+  QString result = versionString.first(offset).toString();
+  result.append(versionString.sliced(offset + length));
+  return result.trimmed();
 }
 
 void VersionInfo::parse(const QString& versionString, VersionScheme scheme,
@@ -271,19 +267,19 @@ void VersionInfo::parse(const QString& versionString, VersionScheme scheme,
     return;
   }
 
-  QString temp = versionString;
+  QStringView temp = versionString;
   // first, determine the versioning scheme if there is a hint
   VersionScheme newScheme = m_Scheme;
   if (!manualInput) {
-    if (temp.startsWith('f')) {
+    if (temp.startsWith(u'f')) {
       newScheme = SCHEME_DECIMALMARK;
-      temp.remove(0, 1);
-    } else if (temp.startsWith('n')) {
+      temp      = temp.sliced(1);
+    } else if (temp.startsWith(u'n')) {
       newScheme = SCHEME_NUMBERSANDLETTERS;
-      temp.remove(0, 1);
-    } else if (temp.startsWith('d')) {
+      temp      = temp.sliced(1);
+    } else if (temp.startsWith(u'd')) {
       newScheme = SCHEME_DATE;
-      temp.remove(0, 1);
+      temp      = temp.sliced(1);
     }
   }
 
@@ -291,44 +287,71 @@ void VersionInfo::parse(const QString& versionString, VersionScheme scheme,
     m_Scheme = newScheme;
   }
 
-  if (temp.startsWith('v', Qt::CaseInsensitive)) {
+  if (temp.startsWith(u'v', Qt::CaseInsensitive)) {
     // v is often prepended to versions
-    temp.remove(0, 1);
+    temp = temp.sliced(1);
   }
 
-  auto match = VERSION_REGEX.match(temp);
-  if (match.hasMatch()) {
-    m_Major             = match.captured(1).toInt();
-    m_Minor             = match.captured(3).toInt();
-    QString subMinor    = match.captured(5);
-    QString subSubMinor = match.captured(7);
+  // same as ^(\d+)(\.(\d+))?(\.(\d+))?(\.(\d+))?, the segments that are not there
+  // stay empty
+  std::array<QStringView, 4> segments;
+  const auto digits = [&temp](qsizetype from) {
+    qsizetype end = from;
+    while (end < temp.size() && temp[end] >= u'0' && temp[end] <= u'9') {
+      ++end;
+    }
+    return end - from;
+  };
+
+  qsizetype length = digits(0);
+  if (length > 0) {
+    segments[0] = temp.first(length);
+
+    for (std::size_t i = 1; i < segments.size(); ++i) {
+      if (length >= temp.size() || temp[length] != u'.') {
+        break;
+      }
+
+      const qsizetype segmentLength = digits(length + 1);
+      if (segmentLength == 0) {
+        break;
+      }
+
+      segments[i] = temp.sliced(length + 1, segmentLength);
+      length += segmentLength + 1;
+    }
+
+    const QStringView minor = segments[1], subMinor = segments[2];
+
+    m_Major = segments[0].toInt();
+    m_Minor = minor.toInt();
     if (!subMinor.isEmpty() && (m_Scheme == SCHEME_DECIMALMARK)) {
       // nooooope, if there are two dots it can't be a decimal mark
       m_Scheme = SCHEME_REGULAR;
     }
     if (m_Scheme != SCHEME_DECIMALMARK) {
       m_SubMinor    = subMinor.toInt();
-      m_SubSubMinor = subSubMinor.toInt();
+      m_SubSubMinor = segments[3].toInt();
     }
-    if (subMinor.isEmpty() && (match.captured(3).size() > 1) &&
-        match.captured(3).startsWith('0')) {
+    if (subMinor.isEmpty() && (minor.size() > 1) && minor.startsWith(u'0')) {
       // this indicates a decimal scheme
       m_Scheme           = SCHEME_DECIMALMARK;
-      m_DecimalPositions = (int)match.captured(3).size();
+      m_DecimalPositions = (int)minor.size();
     }
-    temp.remove(VERSION_REGEX);
+    temp = temp.sliced(length);
   } else {
     m_Scheme = SCHEME_LITERAL;
   }
 
   if (m_Scheme == SCHEME_REGULAR) {
-    temp = parseReleaseType(temp);
+    m_Rest = parseReleaseType(temp);
+  } else {
+    m_Rest = temp.trimmed().toString();
   }
 
   if ((m_Scheme == SCHEME_DATE) && (m_Major < 1900)) {
     m_Scheme = SCHEME_REGULAR;
   }
-  m_Rest  = temp.trimmed();
   m_Valid = true;
 }
 
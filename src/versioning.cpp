@@ -1,111 +1,276 @@
 #include "versioning.h"
 
-#include <QRegularExpression>
+#include <algorithm>
 #include <format>
-#include <unordered_map>
+#include <optional>
 
 #include "formatters.h"
 
-// official semver regex
-static const QRegularExpression s_SemVerStrictRegEx{
-    R"(^(?P<major>0|[1-9]\d*)\.(?P<minor>0|[1-9]\d*)\.(?P<patch>0|[1-9]\d*)(?:-(?P<prerelease>(?:0|[1-9]\d*|\d*[a-zA-Z-][0-9a-zA-Z-]*)(?:\.(?:0|[1-9]\d*|\d*[a-zA-Z-][0-9a-zA-Z-]*))*))?(?:\+(?P<buildmetadata>[0-9a-zA-Z-]+(?:\.[0-9a-zA-Z-]+)*))?$)"};
-
-// for MO2, to match stuff like 1.2.3rc1 or v1.2.3a1+XXX
-static const QRegularExpression s_SemVerMO2RegEx{
-    R"(^v?(?P<major>0|[1-9]\d*)\.(?P<minor>0|[1-9]\d*)\.(?P<patch>0|[1-9]\d*)(?:\.(?P<subpatch>0|[1-9]\d*))?(?:(?P<type>dev|a|alpha|b|beta|rc)(?P<prerelease>0|[1-9](?:[.0-9])*))?(?:\+(?P<buildmetadata>[0-9a-zA-Z-]+(?:\.[0-9a-zA-Z-]+)*))?$)"};
-
-// match from value to release type
-static const std::unordered_map<QString, MOBase::Version::ReleaseType>
-    s_StringToRelease{{"dev", MOBase::Version::Development},
-                      {"alpha", MOBase::Version::Alpha},
-                      {"a", MOBase::Version::Alpha},
-                      {"beta", MOBase::Version::Beta},
-                      {"b", MOBase::Version::Beta},
-                      {"rc", MOBase::Version::ReleaseCandidate}};
-
 namespace MOBase
 {
 
 namespace
 {
 
-  Version parseVersionSemVer(QString const& value)
+  // the functions below implement the grammar of the official semver regular
+  // expression, and of its MO2 extension, in a single pass over the string, without
+  // capturing anything
+  //
+
+  // release types, alpha must come before a and beta before b since a and b are
+  // prefixes of them
+  constexpr std::pair<QLatin1StringView, Version::ReleaseType> s_ReleaseTypes[]{
+      {QLatin1StringView("dev"), Version::Development},
+      {QLatin1StringView("alpha"), Version::Alpha},
+      {QLatin1StringView("a"), Version::Alpha},
+      {QLatin1StringView("beta"), Version::Beta},
+      {QLatin1StringView("b"), Version::Beta},
+      {QLatin1StringView("rc"), Version::ReleaseCandidate}};
+
+  bool isDigit(QChar c)
+  {
+    return c >= u'0' && c <= u'9';
+  }
+
+  // [0-9a-zA-Z-]
+  bool isIdentifierChar(QChar c)
   {
-    const auto match = s_SemVerStrictRegEx.match(value);
+    return isDigit(c) || (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') ||
+           c == u'-';
+  }
+
+  InvalidVersionException invalidVersion(QStringView value)
+  {
+    return InvalidVersionException(QString::fromStdString(
+        std::format("invalid version string: '{}'", value.toString())));
+  }
 
-    if (!match.hasMatch()) {
-      throw InvalidVersionException(
-          QString::fromStdString(std::format("invalid version string: '{}'", value)));
+  // like '$' in the regular expressions, a single trailing newline is accepted
+  QStringView withoutFinalNewline(QStringView value)
+  {
+    return value.endsWith(u'\n') ? value.chopped(1) : value;
+  }
+
+  bool take(QStringView& value, QChar c)
+  {
+    if (value.startsWith(c)) {
+      value = value.sliced(1);
+      return true;
     }
+    return false;
+  }
 
-    const auto major = match.captured("major").toInt();
-    const auto minor = match.captured("minor").toInt();
-    const auto patch = match.captured("patch").toInt();
+  // takes 0|[1-9]\d* from the front of the given value, this overflows to 0 like
+  // QString::toInt()
+  std::optional<int> takeNumber(QStringView& value)
+  {
+    if (value.isEmpty() || !isDigit(value.front())) {
+      return {};
+    }
 
-    std::vector<std::variant<int, Version::ReleaseType>> prereleases;
-    for (auto& part : match.captured("prerelease")
-                          .split(".", Qt::SplitBehaviorFlags::SkipEmptyParts)) {
-      // try to extract an int
-      bool ok             = true;
-      const auto intValue = part.toInt(&ok);
-      if (ok) {
-        prereleases.push_back(intValue);
-        continue;
+    qsizetype length = 1;
+    if (value.front() != u'0') {
+      while (length < value.size() && isDigit(value[length])) {
+        ++length;
       }
+    }
+
+    const int number = value.first(length).toInt();
+    value            = value.sliced(length);
+    return number;
+  }
 
-      // check if we have a valid prerelease type
-      const auto it = s_StringToRelease.find(part.toLower());
-      if (it == s_StringToRelease.end()) {
-        throw InvalidVersionException(
-            QString::fromStdString(std::format("invalid prerelease type: '{}'", part)));
+  // takes major.minor.patch from the front of the given value
+  bool takeVersion(QStringView& value, int& major, int& minor, int& patch)
+  {
+    const auto ma = takeNumber(value);
+    if (!ma || !take(value, u'.')) {
+      return false;
+    }
+
+    const auto mi = takeNumber(value);
+    if (!mi || !take(value, u'.')) {
+      return false;
+    }
+
+    const auto pa = takeNumber(value);
+    if (!pa) {
+      return false;
+    }
+
+    major = *ma;
+    minor = *mi;
+    patch = *pa;
+    return true;
+  }
+
+  // checks that the value is a list of '.' separated identifiers, each matching
+  // [0-9a-zA-Z-]+
+  bool isIdentifierList(QStringView value)
+  {
+    bool empty = true;
+
+    for (const QChar c : value) {
+      if (c == u'.') {
+        if (empty) {
+          return false;
+        }
+        empty = true;
+      } else if (isIdentifierChar(c)) {
+        empty = false;
+      } else {
+        return false;
       }
+    }
 
-      prereleases.push_back(it->second);
+    return !empty;
+  }
+
+  // takes the build metadata from the end of the value, returns false if it is not
+  // valid
+  bool takeBuildMetadata(QStringView& value, QString& metadata)
+  {
+    const auto plus = value.indexOf(u'+');
+    if (plus < 0) {
+      return true;
+    }
+
+    const auto text = value.sliced(plus + 1);
+    if (!isIdentifierList(text)) {
+      return false;
+    }
+
+    metadata = text.toString();
+    value    = value.first(plus);
+    return true;
+  }
+
+  Version parseVersionSemVer(QStringView value)
+  {
+    QStringView rest = withoutFinalNewline(value);
+
+    QString buildMetadata;
+    if (!takeBuildMetadata(rest, buildMetadata)) {
+      throw invalidVersion(value);
     }
 
-    const auto buildMetadata = match.captured("buildmetadata").trimmed();
+    int major, minor, patch;
+    if (!takeVersion(rest, major, minor, patch)) {
+      throw invalidVersion(value);
+    }
+
+    std::vector<std::variant<int, Version::ReleaseType>> prereleases;
+    std::optional<QStringView> invalidType;
+
+    if (take(rest, u'-')) {
+      // each identifier is either 0|[1-9]\d* or \d*[a-zA-Z-][0-9a-zA-Z-]*, so numbers
+      // cannot have leading zeros
+      for (const QStringView part : rest.tokenize(u'.')) {
+        if (part.isEmpty() || !std::ranges::all_of(part, isIdentifierChar) ||
+            (part.size() > 1 && part.front() == u'0' &&
+             std::ranges::all_of(part, isDigit))) {
+          throw invalidVersion(value);
+        }
+
+        // try to extract an int
+        bool ok             = true;
+        const auto intValue = part.toInt(&ok);
+        if (ok) {
+          prereleases.push_back(intValue);
+          continue;
+        }
+
+        // check if we have a valid prerelease type, this is only reported once the
+        // whole string is known to be valid
+        const auto it = std::ranges::find_if(s_ReleaseTypes, [&](auto&& type) {
+          return part.compare(type.first, Qt::CaseInsensitive) == 0;
+        });
+
+        if (it == std::end(s_ReleaseTypes)) {
+          invalidType = invalidType.value_or(part);
+          continue;
+        }
+
+        prereleases.push_back(it->second);
+      }
+    } else if (!rest.isEmpty()) {
+      throw invalidVersion(value);
+    }
+
+    if (invalidType) {
+      throw InvalidVersionException(QString::fromStdString(
+          std::format("invalid prerelease type: '{}'", invalidType->toString())));
+    }
 
     return Version(major, minor, patch, 0, prereleases, buildMetadata);
   }
 
-  Version parseVersionMO2(QString const& value)
+  Version parseVersionMO2(QStringView value)
   {
-    const auto match = s_SemVerMO2RegEx.match(value);
+    QStringView rest = withoutFinalNewline(value);
 
-    if (!match.hasMatch()) {
-      throw InvalidVersionException(
-          QString::fromStdString(std::format("invalid version string: '{}'", value)));
+    QString buildMetadata;
+    if (!takeBuildMetadata(rest, buildMetadata)) {
+      throw invalidVersion(value);
     }
 
-    const auto major = match.captured("major").toInt();
-    const auto minor = match.captured("minor").toInt();
-    const auto patch = match.captured("patch").toInt();
+    take(rest, u'v');
 
-    const auto subpatch = match.captured("subpatch").toInt();
+    int major, minor, patch, subpatch = 0;
+    if (!takeVersion(rest, major, minor, patch)) {
+      throw invalidVersion(value);
+    }
+
+    if (take(rest, u'.')) {
+      const auto number = takeNumber(rest);
+      if (!number) {
+        throw invalidVersion(value);
+      }
+      subpatch = *number;
+    }
 
-    // unlike semver, the regex will only match valid values
     std::vector<std::variant<int, Version::ReleaseType>> prereleases;
-    if (match.hasCaptured("type")) {
-      prereleases.push_back(s_StringToRelease.at(match.captured("type")));
+    if (!rest.isEmpty()) {
+      const auto it = std::ranges::find_if(s_ReleaseTypes, [&](auto&& type) {
+        return rest.startsWith(type.first);
+      });
+
+      if (it == std::end(s_ReleaseTypes)) {
+        throw invalidVersion(value);
+      }
+
+      // the pre-release is 0|[1-9][.0-9]*
+      rest = rest.sliced(it->first.size());
+      if (rest.isEmpty() || !isDigit(rest.front()) ||
+          (rest.front() == u'0' && rest.size() > 1) ||
+          !std::ranges::all_of(rest, [](QChar c) {
+            return c == u'.' || isDigit(c);
+          })) {
+        throw invalidVersion(value);
+      }
+
+      prereleases.push_back(it->second);
 
       // for version with decimal point, e.g., 2.4.1rc1.1, we split the components into
       // pre-release components to get {rc, 1, 1} - this works fine since {rc, 1} < {rc,
       // 1, 1}
       //
-      for (const auto& preVersion :
-           match.captured("prerelease").split(".", Qt::SkipEmptyParts)) {
+      for (const QStringView preVersion : rest.tokenize(u'.', Qt::SkipEmptyParts)) {
         prereleases.push_back(preVersion.toInt());
       }
     }
 
-    const auto buildMetadata = match.captured("buildmetadata").trimmed();
-
     return Version(major, minor, patch, subpatch, prereleases, buildMetadata);
   }
 
 }  // namespace
 
 Version Version::parse(QString const& value, ParseMode mode)
+{
+  return parse(QStringView(value), mode);
+}
+
+Version Version::parse(QStringView value, ParseMode mode)
 {
   return mode == ParseMode::SemVer ? parseVersionSemVer(value) : parseVersionMO2(value);
 }
@@ -118,7 +283,9 @@ Version::Version(int major, int minor, int patch, QString metadata)
 Version::Version(int major, int minor, int patch, int subpatch, QString metadata)
     : m_Major{major}, m_Minor{minor}, m_Patch{patch}, m_SubPatch{subpatch},
       m_PreReleases{}, m_BuildMetadata{std::move(metadata)}
-{}
+{
+  m_SortKey = makeSortKey();
+}
 
 Version::Version(int major, int minor, int patch, ReleaseType type, QString metadata)
     : Version(major, minor, patch, 0, type, std::move(metadata))
@@ -127,7 +294,9 @@ Version::Version(int major, int minor, int patch, int subpatch, ReleaseType type
                  QString metadata)
     : m_Major{major}, m_Minor{minor}, m_Patch{patch}, m_SubPatch{subpatch},
       m_PreReleases{type}, m_BuildMetadata{std::move(metadata)}
-{}
+{
+  m_SortKey = makeSortKey();
+}
 
 Version::Version(int major, int minor, int patch, ReleaseType type, int prerelease,
                  QString metadata)
@@ -143,7 +312,9 @@ Version::Version(int major, int minor, int patch, int subpatch,
                  QString metadata)
     : m_Major{major}, m_Minor{minor}, m_Patch{patch}, m_SubPatch{subpatch},
       m_PreReleases{std::move(prereleases)}, m_BuildMetadata{std::move(metadata)}
-{}
+{
+  m_SortKey = makeSortKey();
+}
 
 // string
 
@@ -194,6 +365,76 @@ QString Version::string(const FormatModes& modes) const
   return QString::fromStdString(value);
 }
 
+// sort key
+
+Version::SortKey Version::makeSortKey() const
+{
+  // identifiers are compared pair by pair and trailing zeros are ignored, so this
+  // packs the identifiers without trailing zeros, one byte each, with 0 for the end,
+  // 1 to 250 for integers up to 249, 251 for larger ones and the release types above
+  // that
+  //
+  // a field that does not fit is clamped and everything after it is set to the same
+  // bound, so the keys still order correctly and only ties need the full comparison,
+  // this includes negative integers in pre-releases, which end the key
+  //
+  constexpr int MaxField = 0xffff, MaxInteger = 249;
+
+  SortKey key;
+
+  const int fields[] = {m_Major, m_Minor, m_Patch, m_SubPatch};
+  for (std::size_t i = 0; i < std::size(fields); ++i) {
+    if (fields[i] < 0 || fields[i] > MaxField) {
+      const std::uint64_t fill = fields[i] < 0 ? 0 : ~std::uint64_t(0);
+      const std::size_t bits   = 16 * (std::size(fields) - i);
+
+      key.high  = bits == 64 ? fill : (key.high << bits) | (fill >> (64 - bits));
+      key.low   = fill;
+      key.exact = false;
+      return key;
+    }
+
+    key.high = (key.high << 16) | std::uint64_t(fields[i]);
+  }
+
+  if (!isPreRelease()) {
+    key.low = std::uint64_t(1) << 56;
+    return key;
+  }
+
+  auto end = m_PreReleases.end();
+  while (end != m_PreReleases.begin() && std::holds_alternative<int>(*(end - 1)) &&
+         std::get<int>(*(end - 1)) == 0) {
+    --end;
+  }
+
+  int shift = 48;
+  for (auto it = m_PreReleases.begin(); it != end; ++it, shift -= 8) {
+    if (shift < 0) {
+      key.exact = false;
+      break;
+    }
+
+    std::uint64_t code;
+    if (const int* value = std::get_if<int>(&*it)) {
+      if (*value < 0 || *value > MaxInteger) {
+        if (*value > 0) {
+          key.low |= std::uint64_t(MaxInteger + 2) << shift;
+        }
+        key.exact = false;
+        break;
+      }
+      code = std::uint64_t(*value) + 1;
+    } else {
+      code = MaxInteger + 3 + std::uint64_t(std::get<ReleaseType>(*it));
+    }
+
+    key.low |= code << shift;
+  }
+
+  return key;
+}
+
 namespace
 {
   // consume the given iterator until the given end iterator or until a non-zero value
@@ -209,70 +450,81 @@ namespace
     }
     return it;
   };
-}  // namespace
 
-std::strong_ordering operator<=>(const Version& lhs, const Version& rhs)
-{
-  auto mmp_cmp =
-      std::forward_as_tuple(lhs.major(), lhs.minor(), lhs.patch(), lhs.subpatch()) <=>
-      std::forward_as_tuple(rhs.major(), rhs.minor(), rhs.patch(), rhs.subpatch());
+  std::strong_ordering compareFields(const Version& lhs, const Version& rhs)
+  {
+    auto mmp_cmp =
+        std::forward_as_tuple(lhs.major(), lhs.minor(), lhs.patch(), lhs.subpatch()) <=>
+        std::forward_as_tuple(rhs.major(), rhs.minor(), rhs.patch(), rhs.subpatch());
 
-  // major.minor.patch have precedence over everything else
-  if (mmp_cmp != std::strong_ordering::equal) {
-    return mmp_cmp;
-  }
+    // major.minor.patch have precedence over everything else
+    if (mmp_cmp != std::strong_ordering::equal) {
+      return mmp_cmp;
+    }
 
-  // handle cases were one is a pre-release and not the other - the pre-release is
-  // "less" than the release
-  if (lhs.isPreRelease() && !rhs.isPreRelease()) {
-    return std::strong_ordering::less;
-  }
+    // handle cases were one is a pre-release and not the other - the pre-release is
+    // "less" than the release
+    if (lhs.isPreRelease() && !rhs.isPreRelease()) {
+      return std::strong_ordering::less;
+    }
 
-  if (!lhs.isPreRelease() && rhs.isPreRelease()) {
-    return std::strong_ordering::greater;
-  }
+    if (!lhs.isPreRelease() && rhs.isPreRelease()) {
+      return std::strong_ordering::greater;
+    }
+
+    // compare pre-release fields
+    auto lhsIt = lhs.preReleases().begin(), rhsIt = rhs.preReleases().begin();
+    for (; lhsIt != lhs.preReleases().end() && rhsIt != rhs.preReleases().end();
+         ++lhsIt, ++rhsIt) {
 
-  // compare pre-release fields
-  auto lhsIt = lhs.preReleases().begin(), rhsIt = rhs.preReleases().begin();
-  for (; lhsIt != lhs.preReleases().end() && rhsIt != rhs.preReleases().end();
-       ++lhsIt, ++rhsIt) {
+      const auto &lhsPre = *lhsIt, rhsPre = *rhsIt;
 
-    const auto &lhsPre = *lhsIt, rhsPre = *rhsIt;
+      // if one is alpha/beta/etc. and the other is numeric, the alpha/beta/etc. is
+      // lower than the numeric one, which matches the index
+      auto pre_cmp = lhsPre.index() <=> rhsPre.index();
+      if (pre_cmp != std::strong_ordering::equal) {
+        return pre_cmp;
+      }
 
-    // if one is alpha/beta/etc. and the other is numeric, the alpha/beta/etc. is lower
-    // than the numeric one, which matches the index
-    auto pre_cmp = lhsPre.index() <=> rhsPre.index();
-    if (pre_cmp != std::strong_ordering::equal) {
-      return pre_cmp;
+      // compare the actual values
+      pre_cmp = lhsPre <=> rhsPre;
+      if (pre_cmp != std::strong_ordering::equal) {
+        return pre_cmp;
+      }
     }
 
-    // compare the actual values
-    pre_cmp = lhsPre <=> rhsPre;
-    if (pre_cmp != std::strong_ordering::equal) {
-      return pre_cmp;
+    // the code below does not follow semver 100% (I think) - basically, this makes
+    // stuff like 2.4.1rc1.0 equals to 2.4.1rc1, which according to semver is probably
+    // not right but is probably best for us
+    //
+
+    // if we land here, we have consumed one of the pre-release, we skip all the 0 in
+    // the remaining one
+    lhsIt = consumePreReleaseZeros(lhsIt, lhs.preReleases().end());
+    rhsIt = consumePreReleaseZeros(rhsIt, rhs.preReleases().end());
+
+    const auto lhsConsumed = lhsIt == lhs.preReleases().end(),
+               rhsConsumed = rhsIt == rhs.preReleases().end();
+
+    if (lhsConsumed && rhsConsumed) {
+      return std::strong_ordering::equal;
+    } else if (!lhsConsumed) {
+      return std::strong_ordering::greater;
+    } else {
+      return std::strong_ordering::less;
     }
   }
 
-  // the code below does not follow semver 100% (I think) - basically, this makes stuff
-  // like 2.4.1rc1.0 equals to 2.4.1rc1, which according to semver is probably not right
-  // but is probably best for us
-  //
-
-  // if we land here, we have consumed one of the pre-release, we skip all the 0 in the
-  // remaining one
-  lhsIt = consumePreReleaseZeros(lhsIt, lhs.preReleases().end());
-  rhsIt = consumePreReleaseZeros(rhsIt, rhs.preReleases().end());
-
-  const auto lhsConsumed = lhsIt == lhs.preReleases().end(),
-             rhsConsumed = rhsIt == rhs.preReleases().end();
+}  // namespace
 
-  if (lhsConsumed && rhsConsumed) {
-    return std::strong_ordering::equal;
-  } else if (!lhsConsumed) {
-    return std::strong_ordering::greater;
-  } else {
-    return std::strong_ordering::less;
+std::strong_ordering operator<=>(const Version& lhs, const Version& rhs)
+{
+  const auto cmp = lhs.sortKey() <=> rhs.sortKey();
+  if (cmp != 0 || (lhs.sortKey().exact && rhs.sortKey().exact)) {
+    return cmp;
   }
+
+  return compareFields(lhs, rhs);
 }
 
 }  // namespace MOBase
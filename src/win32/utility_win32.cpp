@@ -531,18 +531,27 @@ QDir getKnownFolder(KNOWNFOLDERID id, const QString& what)
 
 QIcon iconForExecutable(const QString& filePath)
 {
-  HICON winIcon;
-  UINT res = ::ExtractIconExW(ToWString(filePath).c_str(), 0, &winIcon, nullptr, 1);
-  if (res == 1) {
-    QImage image = QImage::fromHICON(winIcon);
-    QIcon result = QIcon(QPixmap::fromImage(image));
-    ::DestroyIcon(winIcon);
-    return result;
+  const QImage image = iconImageForExecutable(filePath);
+  if (!image.isNull()) {
+    return QIcon(QPixmap::fromImage(image));
   } else {
     return QIcon(":/MO/gui/executable");
   }
 }
 
+QImage iconImageForExecutable(const QString& filePath)
+{
+  HICON winIcon;
+  UINT res = ::ExtractIconExW(ToWString(filePath).c_str(), 0, &winIcon, nullptr, 1);
+  if (res != 1) {
+    return {};
+  }
+
+  QImage image = QImage::fromHICON(winIcon);
+  ::DestroyIcon(winIcon);
+  return image;
+}
+
 QString getFileVersion(QString const& filepath)
 {
   // This *really* needs to be factored out
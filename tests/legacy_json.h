@@ -0,0 +1,16 @@
+#ifndef LEGACY_JSON_H
+#define LEGACY_JSON_H
+
+#include <QString>
+#include <QVariant>
+
+namespace QtJson::legacy
+{
+/**
+ * The original character by character parser, only kept around as a reference
+ * for tests
+ */
+QVariant parse(const QString& json, bool& success);
+}  // namespace QtJson::legacy
+
+#endif  // LEGACY_JSON_H
@@ -0,0 +1,355 @@
+// the regular expression based parsers that Version::parse() and VersionInfo used
+// before the single pass ones, the tests check that both give the same results
+
+#include "legacy_versioning.h"
+
+#include <QDate>
+#include <QLocale>
+#include <QRegularExpression>
+#include <format>
+#include <map>
+#include <unordered_map>
+
+#include <uibase/formatters.h>
+
+namespace
+{
+
+const QRegularExpression s_SemVerStrictRegEx{
+    R"(^(?P<major>0|[1-9]\d*)\.(?P<minor>0|[1-9]\d*)\.(?P<patch>0|[1-9]\d*)(?:-(?P<prerelease>(?:0|[1-9]\d*|\d*[a-zA-Z-][0-9a-zA-Z-]*)(?:\.(?:0|[1-9]\d*|\d*[a-zA-Z-][0-9a-zA-Z-]*))*))?(?:\+(?P<buildmetadata>[0-9a-zA-Z-]+(?:\.[0-9a-zA-Z-]+)*))?$)"};
+
+// for MO2, to match stuff like 1.2.3rc1 or v1.2.3a1+XXX
+const QRegularExpression s_SemVerMO2RegEx{
+    R"(^v?(?P<major>0|[1-9]\d*)\.(?P<minor>0|[1-9]\d*)\.(?P<patch>0|[1-9]\d*)(?:\.(?P<subpatch>0|[1-9]\d*))?(?:(?P<type>dev|a|alpha|b|beta|rc)(?P<prerelease>0|[1-9](?:[.0-9])*))?(?:\+(?P<buildmetadata>[0-9a-zA-Z-]+(?:\.[0-9a-zA-Z-]+)*))?$)"};
+
+// match from value to release type
+const std::unordered_map<QString, MOBase::Version::ReleaseType>
+    s_StringToRelease{{"dev", MOBase::Version::Development},
+                      {"alpha", MOBase::Version::Alpha},
+                      {"a", MOBase::Version::Alpha},
+                      {"beta", MOBase::Version::Beta},
+                      {"b", MOBase::Version::Beta},
+                      {"rc", MOBase::Version::ReleaseCandidate}};
+
+const QRegularExpression VERSION_REGEX("^(\\d+)(\\.(\\d+))?(\\.(\\d+))?(\\.(\\d+))?");
+
+}  // namespace
+
+namespace MOBase::legacy
+{
+
+namespace
+{
+
+  Version parseVersionSemVerRegEx(QString const& value)
+  {
+    const auto match = s_SemVerStrictRegEx.match(value);
+
+    if (!match.hasMatch()) {
+      throw InvalidVersionException(
+          QString::fromStdString(std::format("invalid version string: '{}'", value)));
+    }
+
+    const auto major = match.captured("major").toInt();
+    const auto minor = match.captured("minor").toInt();
+    const auto patch = match.captured("patch").toInt();
+
+    std::vector<std::variant<int, Version::ReleaseType>> prereleases;
+    for (auto& part : match.captured("prerelease")
+                          .split(".", Qt::SplitBehaviorFlags::SkipEmptyParts)) {
+      // try to extract an int
+      bool ok             = true;
+      const auto intValue = part.toInt(&ok);
+      if (ok) {
+        prereleases.push_back(intValue);
+        continue;
+      }
+
+      // check if we have a valid prerelease type
+      const auto it = s_StringToRelease.find(part.toLower());
+      if (it == s_StringToRelease.end()) {
+        throw InvalidVersionException(
+            QString::fromStdString(std::format("invalid prerelease type: '{}'", part)));
+      }
+
+      prereleases.push_back(it->second);
+    }
+
+    const auto buildMetadata = match.captured("buildmetadata").trimmed();
+
+    return Version(major, minor, patch, 0, prereleases, buildMetadata);
+  }
+
+  Version parseVersionMO2RegEx(QString const& value)
+  {
+    const auto match = s_SemVerMO2RegEx.match(value);
+
+    if (!match.hasMatch()) {
+      throw InvalidVersionException(
+          QString::fromStdString(std::format("invalid version string: '{}'", value)));
+    }
+
+    const auto major = match.captured("major").toInt();
+    const auto minor = match.captured("minor").toInt();
+    const auto patch = match.captured("patch").toInt();
+
+    const auto subpatch = match.captured("subpatch").toInt();
+
+    // unlike semver, the regex will only match valid values
+    std::vector<std::variant<int, Version::ReleaseType>> prereleases;
+    if (match.hasCaptured("type")) {
+      prereleases.push_back(s_StringToRelease.at(match.captured("type")));
+
+      // for version with decimal point, e.g., 2.4.1rc1.1, we split the components into
+      // pre-release components to get {rc, 1, 1} - this works fine since {rc, 1} < {rc,
+      // 1, 1}
+      //
+      for (const auto& preVersion :
+           match.captured("prerelease").split(".", Qt::SkipEmptyParts)) {
+        prereleases.push_back(preVersion.toInt());
+      }
+    }
+
+    const auto buildMetadata = match.captured("buildmetadata").trimmed();
+
+    return Version(major, minor, patch, subpatch, prereleases, buildMetadata);
+  }
+
+}  // namespace
+
+Version parseVersion(QString const& value, Version::ParseMode mode)
+{
+  return mode == Version::ParseMode::SemVer ? parseVersionSemVerRegEx(value)
+                                            : parseVersionMO2RegEx(value);
+}
+
+QString ParsedVersionInfo::canonicalString() const
+{
+  if (!isValid()) {
+    return QString();
+  }
+
+  QString result;
+  if (m_Scheme == VersionInfo::SCHEME_REGULAR) {
+    result = QString("%1.%2.%3.%4")
+                 .arg(m_Major)
+                 .arg(m_Minor)
+                 .arg(m_SubMinor)
+                 .arg(m_SubSubMinor);
+  } else if (m_Scheme == VersionInfo::SCHEME_DECIMALMARK) {
+    result = QString("f%1.%2").arg(m_Major).arg(
+        QString("%1").arg(m_Minor).rightJustified(m_DecimalPositions, '0'));
+  } else if (m_Scheme == VersionInfo::SCHEME_NUMBERSANDLETTERS) {
+    result = QString("n%1.%2.%3.%4")
+                 .arg(m_Major)
+                 .arg(m_Minor)
+                 .arg(m_SubMinor)
+                 .arg(m_SubSubMinor);
+  } else if (m_Scheme == VersionInfo::SCHEME_DATE) {
+    // year.month.day was stored in the version fields
+    result = QString("d%1.%2.%3.%4")
+                 .arg(m_Major)
+                 .arg(m_Minor)
+                 .arg(m_SubMinor)
+                 .arg(m_SubSubMinor);
+  }
+  switch (m_ReleaseType) {
+  case VersionInfo::RELEASE_PREALPHA: {
+    result.append(" pre-alpha");
+  } break;
+  case VersionInfo::RELEASE_ALPHA: {
+    result.append("a");
+  } break;
+  case VersionInfo::RELEASE_BETA: {
+    result.append("b");
+  } break;
+  case VersionInfo::RELEASE_CANDIDATE: {
+    result.append("rc");
+  } break;
+  case VersionInfo::RELEASE_FINAL:  // fall-through
+  default: {
+    // nop
+  } break;
+  }
+
+  if (!m_Rest.isEmpty()) {
+    result.append(QString("%1").arg(m_Rest));
+  }
+
+  return result;
+}
+
+QString ParsedVersionInfo::displayString(int forcedVersionSegments) const
+{
+  if (!isValid()) {
+    return QString();
+  }
+
+  QString result;
+  if (m_Scheme == VersionInfo::SCHEME_REGULAR) {
+    if (forcedVersionSegments >= 4 || m_SubSubMinor != 0) {
+      result = QString("%1.%2.%3.%4")
+                   .arg(m_Major)
+                   .arg(m_Minor)
+                   .arg(m_SubMinor)
+                   .arg(m_SubSubMinor);
+    } else if (forcedVersionSegments == 3 || m_SubMinor != 0) {
+      result = QString("%1.%2.%3").arg(m_Major).arg(m_Minor).arg(m_SubMinor);
+    } else {
+      result = QString("%1.%2").arg(m_Major).arg(m_Minor);
+    }
+  } else if (m_Scheme == VersionInfo::SCHEME_DECIMALMARK) {
+    result = QString("%1.%2").arg(m_Major).arg(
+        QString("%1").arg(m_Minor).rightJustified(m_DecimalPositions, '0'));
+  } else if (m_Scheme == VersionInfo::SCHEME_NUMBERSANDLETTERS) {
+    result = QString("%1.%2.%3.%4")
+                 .arg(m_Major)
+                 .arg(m_Minor)
+                 .arg(m_SubMinor)
+                 .arg(m_SubSubMinor);
+  } else if (m_Scheme == VersionInfo::SCHEME_DATE) {
+    // year.month.day was stored in the version fields
+    const auto year  = m_Major;
+    const auto month = m_Minor;
+    const auto day   = m_SubMinor;
+
+    return QLocale::system().toString(QDate(year, month, day),
+                                      QLocale::FormatType::ShortFormat);
+  }
+  switch (m_ReleaseType) {
+  case VersionInfo::RELEASE_PREALPHA: {
+    result.append(" pre-alpha");
+  } break;
+  case VersionInfo::RELEASE_ALPHA: {
+    result.append("alpha");
+  } break;
+  case VersionInfo::RELEASE_BETA: {
+    result.append("beta");
+  } break;
+  case VersionInfo::RELEASE_CANDIDATE: {
+    result.append("rc");
+  } break;
+  case VersionInfo::RELEASE_FINAL:  // fall-through
+  default: {
+    // nop
+  } break;
+  }
+
+  if (!m_Rest.isEmpty()) {
+    result.append(QString("%1").arg(m_Rest));
+  }
+
+  return result;
+}
+
+ParsedVersionInfo parseVersionInfo(const QString& versionString, bool manualInput)
+{
+  ParsedVersionInfo info;
+  if (versionString.length() == 0) {
+    return info;
+  }
+
+  if (QString::compare(versionString, "final", Qt::CaseInsensitive) == 0) {
+    info.m_Major = 1;
+    info.m_Valid = true;
+    return info;
+  }
+
+  QString temp = versionString;
+  // first, determine the versioning scheme if there is a hint
+  if (!manualInput) {
+    if (temp.startsWith('f')) {
+      info.m_Scheme = VersionInfo::SCHEME_DECIMALMARK;
+      temp.remove(0, 1);
+    } else if (temp.startsWith('n')) {
+      info.m_Scheme = VersionInfo::SCHEME_NUMBERSANDLETTERS;
+      temp.remove(0, 1);
+    } else if (temp.startsWith('d')) {
+      info.m_Scheme = VersionInfo::SCHEME_DATE;
+      temp.remove(0, 1);
+    }
+  }
+
+  if (temp.startsWith('v', Qt::CaseInsensitive)) {
+    // v is often prepended to versions
+    temp.remove(0, 1);
+  }
+
+  auto match = VERSION_REGEX.match(temp);
+  if (match.hasMatch()) {
+    info.m_Major        = match.captured(1).toInt();
+    info.m_Minor        = match.captured(3).toInt();
+    QString subMinor    = match.captured(5);
+    QString subSubMinor = match.captured(7);
+    if (!subMinor.isEmpty() && (info.m_Scheme == VersionInfo::SCHEME_DECIMALMARK)) {
+      // nooooope, if there are two dots it can't be a decimal mark
+      info.m_Scheme = VersionInfo::SCHEME_REGULAR;
+    }
+    if (info.m_Scheme != VersionInfo::SCHEME_DECIMALMARK) {
+      info.m_SubMinor    = subMinor.toInt();
+      info.m_SubSubMinor = subSubMinor.toInt();
+    }
+    if (subMinor.isEmpty() && (match.captured(3).size() > 1) &&
+        match.captured(3).startsWith('0')) {
+      // this indicates a decimal scheme
+      info.m_Scheme           = VersionInfo::SCHEME_DECIMALMARK;
+      info.m_DecimalPositions = (int)match.captured(3).size();
+    }
+    temp.remove(VERSION_REGEX);
+  } else {
+    info.m_Scheme = VersionInfo::SCHEME_LITERAL;
+  }
+
+  if (info.m_Scheme == VersionInfo::SCHEME_REGULAR) {
+    static std::map<QString, VersionInfo::ReleaseType> typeStrings = {
+        {"prealpha", VersionInfo::RELEASE_PREALPHA},
+        {"alpha", VersionInfo::RELEASE_ALPHA},
+        {"beta", VersionInfo::RELEASE_BETA},
+        {"rc", VersionInfo::RELEASE_CANDIDATE}};
+
+    auto typeIter = typeStrings.begin();
+    int offset    = -1;
+
+    for (; (typeIter != typeStrings.end()) && (offset == -1); ++typeIter) {
+      offset = (int)temp.indexOf(typeIter->first, Qt::CaseInsensitive);
+      if (offset != -1) {
+        info.m_ReleaseType = typeIter->second;
+        break;
+      }
+    }
+
+    int length = 0;
+
+    if (typeIter != typeStrings.end()) {
+      length = (int)typeIter->first.length();
+    }
+
+    // also interpret the a/b letters, but only if they follow immediately on the
+    // version number, otherwise the margin for error is too big
+    if ((offset == -1) && (temp.length() > 0)) {
+      if (temp.at(0) == 'a') {
+        info.m_ReleaseType = VersionInfo::RELEASE_ALPHA;
+        offset             = 0;
+        length             = 1;
+      } else if (temp.at(0) == 'b') {
+        info.m_ReleaseType = VersionInfo::RELEASE_BETA;
+        offset             = 0;
+        length             = 1;
+      }
+    }
+
+    if (offset != -1) {
+      temp.remove(offset, length);
+    }
+    temp = temp.trimmed();
+  }
+
+  if ((info.m_Scheme == VersionInfo::SCHEME_DATE) && (info.m_Major < 1900)) {
+    info.m_Scheme = VersionInfo::SCHEME_REGULAR;
+  }
+  info.m_Rest  = temp.trimmed();
+  info.m_Valid = true;
+  return info;
+}
+
+}  // namespace MOBase::legacy
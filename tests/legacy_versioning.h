@@ -0,0 +1,50 @@
+#ifndef LEGACY_VERSIONING_H
+#define LEGACY_VERSIONING_H
+
+#include <QString>
+
+#include <uibase/versioninfo.h>
+#include <uibase/versioning.h>
+
+namespace MOBase::legacy
+{
+
+/**
+ * The original regular expression based parser of Version, only kept around as a
+ * reference for tests
+ */
+Version parseVersion(QString const& value,
+                     Version::ParseMode mode = Version::ParseMode::SemVer);
+
+/**
+ * The fields that the original regular expression based parser of VersionInfo
+ * filled, with the string conversions of VersionInfo so both can be compared
+ */
+struct ParsedVersionInfo
+{
+  VersionInfo::VersionScheme m_Scheme    = VersionInfo::SCHEME_REGULAR;
+  bool m_Valid                           = false;
+  VersionInfo::ReleaseType m_ReleaseType = VersionInfo::RELEASE_FINAL;
+  int m_Major                            = 0;
+  int m_Minor                            = 0;
+  int m_SubMinor                         = 0;
+  int m_SubSubMinor                      = 0;
+  int m_DecimalPositions                 = 0;
+  QString m_Rest;
+
+  bool isValid() const { return m_Valid; }
+  VersionInfo::VersionScheme scheme() const { return m_Scheme; }
+  QString canonicalString() const;
+  QString displayString(int forcedVersionSegments = 2) const;
+};
+
+/**
+ * The original regular expression based parser of VersionInfo, with
+ * SCHEME_DISCOVER, only kept around as a reference for tests
+ */
+ParsedVersionInfo parseVersionInfo(const QString& versionString,
+                                   bool manualInput = false);
+
+}  // namespace MOBase::legacy
+
+#endif  // LEGACY_VERSIONING_H
@@ -0,0 +1,421 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QSortFilterProxyModel>
+#include <QStandardItemModel>
+#include <QString>
+#include <QStringList>
+#include <QTreeView>
+
+#include <uibase/filterwidget.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace MOBase;
+
+namespace
+{
+
+FilterWidget::Compiled compile(const QString& text, bool useRegex = false)
+{
+  FilterWidget::Options options;
+  options.useRegex = useRegex;
+
+  return FilterWidget::compile(text, options);
+}
+
+// the result of background filtering is applied from the event loop
+template <class Pred>
+bool processEventsUntil(Pred pred)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  while (!pred() && timer.elapsed() < 10000) {
+    QCoreApplication::processEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return pred();
+}
+
+// remembers how many times the text of each row was fetched while counting
+class CountingModel : public QStandardItemModel
+{
+public:
+  bool counting = false;
+  mutable QHash<QString, int> fetched;
+
+  QVariant data(const QModelIndex& index, int role) const override
+  {
+    auto v = QStandardItemModel::data(index, role);
+
+    if (counting && role == Qt::DisplayRole) {
+      ++fetched[v.toString()];
+    }
+
+    return v;
+  }
+};
+
+// the proxy filters the rows of a parent the first time they are looked up
+void mapRows(const QAbstractItemModel& proxy, const QModelIndex& parent = QModelIndex())
+{
+  for (int r = 0; r < proxy.rowCount(parent); ++r) {
+    mapRows(proxy, proxy.index(r, 0, parent));
+  }
+}
+
+// text of every row shown by the proxy, depth first
+QStringList shownRows(const QAbstractItemModel& proxy,
+                      const QModelIndex& parent = QModelIndex())
+{
+  QStringList rows;
+
+  for (int r = 0; r < proxy.rowCount(parent); ++r) {
+    const auto index = proxy.index(r, 0, parent);
+    rows.push_back(index.data().toString());
+    rows.append(shownRows(proxy, index));
+  }
+
+  return rows;
+}
+
+// a filter widget on a tree of three levels, the rows are named after a few words
+// and their path; the same filter is given to a plain recursive proxy to compare
+//
+struct FilteredTree
+{
+  CountingModel model;
+  FilterWidget filter;
+  QLineEdit edit;
+  QTreeView view;
+  QSortFilterProxyModel reference;
+
+  FilteredTree()
+  {
+    int counter = 0;
+    fill(model.invisibleRootItem(), "", 3, counter);
+
+    view.setModel(&model);
+    filter.setEdit(&edit);
+    filter.setList(&view);
+
+    reference.setRecursiveFilteringEnabled(true);
+    reference.setSourceModel(&model);
+
+    // every row is mapped before filtering, like an expanded tree
+    shown();
+  }
+
+  ~FilteredTree() { filter.setList(nullptr); }
+
+  static void fill(QStandardItem* parent, const QString& path, int depth, int& counter)
+  {
+    static const char* const words[]{"alpha", "beta", "gamma", "delta", "kappa"};
+
+    for (int r = 0; r < 10; ++r) {
+      const auto rowPath = path + QString::number(r);
+      const auto text    = QString("%1 %2").arg(words[counter++ % 5]).arg(rowPath);
+      auto* item         = new QStandardItem(text);
+
+      if (depth > 1) {
+        fill(item, rowPath + ".", depth - 1, counter);
+      }
+
+      parent->appendRow(item);
+    }
+  }
+
+  // plain keywords, each one anywhere in the text regardless of case
+  void setFilter(const QString& text)
+  {
+    model.fetched.clear();
+    model.counting = true;
+    edit.setText(text);
+    model.counting = false;
+
+    QString pattern = "^";
+    for (auto&& keyword : text.split(" ", Qt::SkipEmptyParts)) {
+      pattern += "(?=.*" + QRegularExpression::escape(keyword) + ")";
+    }
+
+    reference.setFilterRegularExpression(QRegularExpression(
+        pattern, QRegularExpression::CaseInsensitiveOption |
+                     QRegularExpression::DotMatchesEverythingOption));
+  }
+
+  // the text of the rows is not counted, only what the filter fetched
+  QStringList shown()
+  {
+    model.counting = true;
+    mapRows(*filter.proxyModel());
+    model.counting = false;
+
+    return shownRows(*filter.proxyModel());
+  }
+
+  QStringList expected() const { return shownRows(reference); }
+};
+
+}  // namespace
+
+TEST(FilterWidgetTest, IsRefinement)
+{
+  struct Case
+  {
+    QString previous;
+    QString current;
+    bool useRegex;
+    bool refinement;
+  };
+
+  const Case cases[]{
+      // extended keyword
+      {"foo", "foob", false, true},
+      {"foo", "xfoo", false, true},
+      {"foo", "FOOB", false, true},
+      {"foob", "foo", false, false},
+      {"foo", "fob", false, false},
+
+      // added keyword
+      {"foo", "foo bar", false, true},
+      {"foo", "bar foo", false, true},
+      {"foo bar", "foo", false, false},
+      {"foo bar", "foo baz", false, false},
+
+      // OR segments
+      {"foo|bar", "foob|bar", false, true},
+      {"foo|bar", "foo OR barb", false, true},
+      {"foo", "foo|bar", false, false},
+      {"foo|bar", "foo", false, false},
+      {"foo|bar", "bar|foo", false, false},
+
+      // regular expressions
+      {"foo", "foob", true, false},
+      {"foo", "foo", true, false},
+
+      // empty previous filter
+      {"", "foo", false, false},
+      {"", "", false, false},
+      {"foo", "", false, false}};
+
+  for (const auto& c : cases) {
+    const auto previous = compile(c.previous, c.useRegex);
+    const auto current  = compile(c.current, c.useRegex);
+
+    EXPECT_EQ(c.refinement, FilterWidget::isRefinement(previous, current))
+        << c.previous.toStdString() << " -> " << c.current.toStdString()
+        << (c.useRegex ? " (regex)" : "");
+  }
+}
+
+TEST(FilterWidgetTest, Matches)
+{
+  struct Case
+  {
+    QString filter;
+    QString text;
+    bool matches;
+  };
+
+  const Case cases[]{
+      {"", "anything", true},
+      {"mod", "My Mod", true},
+      {"MOD", "my mod", true},
+      {"mod", "my mdo", false},
+      {"my mod", "MOD of MY", true},
+      {"my mod", "my thing", false},
+      {"foo|mod", "my mod", true},
+      {"foo|bar", "my mod", false},
+      {"ÄRGER", "ärger", true},
+      {"ΣΊΣΥΦΟΣ", "σίσυφος", true},
+      {"σίσυφος", "ΣΊΣΥΦΟΣ", true},
+      {"a.b", "axb", false},
+      {"a.b", "A.B", true}};
+
+  for (const auto& c : cases) {
+    EXPECT_EQ(c.matches, FilterWidget::matches(compile(c.filter), c.text))
+        << c.filter.toStdString() << " / " << c.text.toStdString();
+  }
+
+  // regular expressions are case insensitive unless asked otherwise
+  EXPECT_TRUE(FilterWidget::matches(compile("m.d$", true), "MY MOD"));
+
+  FilterWidget::Options options;
+  options.useRegex           = true;
+  options.regexCaseSensitive = true;
+
+  EXPECT_FALSE(
+      FilterWidget::matches(FilterWidget::compile("m.d$", options), "MY MOD"));
+  EXPECT_TRUE(FilterWidget::matches(FilterWidget::compile("M.D$", options), "MY MOD"));
+}
+
+TEST(FilterWidgetTest, ProxyFullPass)
+{
+  FilteredTree tree;
+
+  for (const QString filter : {"alpha", "ta 1", "KAPPA 3.", "nothing", ""}) {
+    tree.setFilter(filter);
+    EXPECT_EQ(tree.expected(), tree.shown()) << filter.toStdString();
+
+    // with the rows accepted for their descendants, each row is evaluated once
+    for (auto&& [text, count] : tree.model.fetched.asKeyValueRange()) {
+      EXPECT_EQ(1, count) << filter.toStdString() << " / " << text.toStdString();
+    }
+  }
+}
+
+TEST(FilterWidgetTest, ProxyRefinement)
+{
+  FilteredTree tree;
+
+  tree.setFilter("a");
+  ASSERT_EQ(tree.expected(), tree.shown());
+
+  QString previous = "a";
+
+  for (const QString filter : {"ta", "ta 2", "elta 2", "elta 2.3"}) {
+    ASSERT_TRUE(FilterWidget::isRefinement(compile(previous), compile(filter)));
+
+    tree.setFilter(filter);
+    EXPECT_EQ(tree.expected(), tree.shown()) << filter.toStdString();
+
+    // the rows rejected before are not looked at again
+    for (auto&& text : tree.model.fetched.keys()) {
+      EXPECT_TRUE(FilterWidget::matches(compile(previous), text))
+          << previous.toStdString() << " -> " << filter.toStdString() << " / "
+          << text.toStdString();
+    }
+
+    previous = filter;
+  }
+
+  // going back to a broader filter evaluates all the rows again
+  tree.setFilter("ta");
+  EXPECT_EQ(tree.expected(), tree.shown());
+}
+
+TEST(FilterWidgetTest, ProxyChildDataChanged)
+{
+  FilteredTree tree;
+
+  // nothing matches
+  tree.setFilter("zeta");
+  ASSERT_EQ(tree.expected(), tree.shown());
+  ASSERT_TRUE(tree.shown().isEmpty());
+
+  auto* parent = tree.model.item(3)->child(4);
+  auto* leaf   = parent->child(5);
+
+  // the ancestors are shown for the leaf
+  leaf->setText("zeta leaf");
+  EXPECT_EQ(tree.expected(), tree.shown());
+  EXPECT_EQ(QStringList({"delta 3", "delta 3.4", "zeta leaf"}), tree.shown());
+
+  // and hidden again
+  leaf->setText("omega leaf");
+  EXPECT_EQ(tree.expected(), tree.shown());
+  EXPECT_TRUE(tree.shown().isEmpty());
+
+  // a row in the middle that matches itself, but none of its children
+  parent->setText("zeta parent");
+  EXPECT_EQ(tree.expected(), tree.shown());
+
+  // a sibling of a shown row
+  parent->child(0)->setText("zeta sibling");
+  leaf->setText("zeta leaf");
+  parent->setText("delta 3.4");
+  EXPECT_EQ(tree.expected(), tree.shown());
+}
+
+TEST(FilterWidgetTest, ProxyBackgroundRowsInserted)
+{
+  FilteredTree tree;
+  tree.filter.setBackgroundFiltering(true);
+
+  // the result is applied from the event loop, the rows are still all shown
+  tree.setFilter("delta");
+  ASSERT_NE(tree.expected(), tree.shown());
+
+  // the snapshot of the job is stale, the rows are filtered again once it finishes
+  tree.model.insertRow(0, new QStandardItem("delta top"));
+  tree.model.item(5)->child(2)->appendRow(new QStandardItem("delta child"));
+  tree.model.item(6)->removeRow(0);
+
+  ASSERT_TRUE(processEventsUntil([&] {
+    return tree.expected() == tree.shown();
+  }));
+
+  EXPECT_TRUE(tree.shown().contains("delta top"));
+  EXPECT_TRUE(tree.shown().contains("delta child"));
+
+  // nothing else is pending
+  QCoreApplication::processEvents();
+  EXPECT_EQ(tree.expected(), tree.shown());
+}
+
+TEST(FilterWidgetTest, ProxyBackgroundDataChanged)
+{
+  FilteredTree tree;
+  tree.filter.setBackgroundFiltering(true);
+
+  tree.setFilter("kappa");
+
+  // the snapshot is kept, the changed rows are filtered again when it is applied;
+  // "kappa 0.0.2" matched before
+  auto* parent = tree.model.item(0)->child(0);
+  parent->child(1)->setText("kappa changed");
+  parent->child(2)->setText("omega changed");
+
+  ASSERT_TRUE(processEventsUntil([&] {
+    return tree.expected() == tree.shown();
+  }));
+
+  EXPECT_TRUE(tree.shown().contains("kappa changed"));
+  EXPECT_FALSE(tree.shown().contains("omega changed"));
+}
+
+TEST(FilterWidgetTest, ProxyBackgroundStaleFilter)
+{
+  FilteredTree tree;
+  tree.filter.setBackgroundFiltering(true);
+
+  // going from every row to a filter only hides rows, rows are only shown again if
+  // the result of a previous filter was applied in between
+  int inserted = 0;
+  QObject::connect(tree.filter.proxyModel(), &QAbstractItemModel::rowsInserted,
+                   tree.filter.proxyModel(), [&] {
+                     ++inserted;
+                   });
+
+  // typing before the first result is applied, its result is dropped
+  tree.setFilter("beta");
+  tree.setFilter("gamma 1");
+
+  ASSERT_TRUE(processEventsUntil([&] {
+    return tree.expected() == tree.shown();
+  }));
+
+  QCoreApplication::processEvents();
+  EXPECT_EQ(tree.expected(), tree.shown());
+  EXPECT_EQ(0, inserted);
+
+  // a refinement of the applied result
+  tree.setFilter("gamma 1.2");
+
+  ASSERT_TRUE(processEventsUntil([&] {
+    return tree.expected() == tree.shown();
+  }));
+
+  EXPECT_EQ(0, inserted);
+  EXPECT_FALSE(tree.shown().isEmpty());
+}
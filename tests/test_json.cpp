@@ -0,0 +1,268 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <QBuffer>
+#include <QElapsedTimer>
+
+#include <uibase/json.h>
+
+#include <format>
+#include <iostream>
+#include <limits>
+
+#include "legacy_json.h"
+
+using namespace QtJson;
+
+TEST(JsonTest, Scalars)
+{
+  bool ok = false;
+
+  ASSERT_EQ(QVariant(true), parse("true", ok));
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(QVariant(false), parse("  false  "));
+  ASSERT_FALSE(parse("null", ok).isValid());
+  ASSERT_TRUE(ok);
+
+  ASSERT_EQ(QVariant("hello"), parse("\"hello\""));
+  ASSERT_EQ(QVariant(QString::fromUtf8("Fran\xc3\xa7" "ais")),
+            parse(QString::fromUtf8("\"Fran\xc3\xa7" "ais\"")));
+}
+
+TEST(JsonTest, Numbers)
+{
+  // same types as the original parser
+  ASSERT_EQ(QMetaType::UInt, parse("42").typeId());
+  ASSERT_EQ(42u, parse("42").toUInt());
+  ASSERT_EQ(QMetaType::Int, parse("-42").typeId());
+  ASSERT_EQ(-42, parse("-42").toInt());
+  ASSERT_EQ(QMetaType::LongLong, parse("-9000000000").typeId());
+  ASSERT_EQ(QMetaType::ULongLong, parse("9000000000").typeId());
+  ASSERT_EQ(QMetaType::Double, parse("1.5").typeId());
+  ASSERT_DOUBLE_EQ(-1500.0, parse("-1.5e3").toDouble());
+  ASSERT_EQ(QMetaType::QString, parse("99999999999999999999999").typeId());
+}
+
+TEST(JsonTest, Strings)
+{
+  ASSERT_EQ("a\"b\\c/d\te\nf", parse(R"("a\"b\\c\/d\te\nf")").toString());
+  ASSERT_EQ(QString(QChar(0xe9)), parse(R"("\u00e9")").toString());
+
+  // surrogate pairs
+  ASSERT_EQ(QString::fromUtf8("\xf0\x9f\x98\x80"),
+            parse(R"("\ud83d\ude00")").toString());
+
+  // a run of backslashes across the 64 byte blocks of the scanner
+  for (int pad = 50; pad < 70; ++pad) {
+    const QString json =
+        "[" + QString(pad, ' ') + R"("x\\\"y", { "k" : "v,:]" }, 1])";
+    const QVariantList list = parse(json).toList();
+
+    ASSERT_EQ(3, list.size());
+    ASSERT_EQ("x\\\"y", list[0].toString());
+    ASSERT_EQ("v,:]", list[1].toMap()["k"].toString());
+  }
+}
+
+TEST(JsonTest, Containers)
+{
+  const QVariant v = parse(R"({ "a" : [1, 2, [3]], "b" : { "c" : null } })");
+  const QVariantMap map = v.toMap();
+
+  ASSERT_EQ(2, map.size());
+  ASSERT_EQ(3, map["a"].toList().size());
+  ASSERT_EQ(3u, map["a"].toList()[2].toList()[0].toUInt());
+  ASSERT_TRUE(map["b"].toMap().contains("c"));
+
+  ASSERT_EQ(QVariantList(), parse("[]").toList());
+  ASSERT_EQ(QVariantMap(), parse("{}").toMap());
+}
+
+TEST(JsonTest, Lenient)
+{
+  bool ok = false;
+
+  // stray commas and trailing data have always been accepted
+  ASSERT_EQ(2, parse("[1,,2,]", ok).toList().size());
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(1, parse(R"({"a" : 1,} trailing)", ok).toMap().size());
+  ASSERT_TRUE(ok);
+
+  // a null string is an empty document, an empty one is an error
+  parse(QString(), ok);
+  ASSERT_TRUE(ok);
+  parse(QString(""), ok);
+  ASSERT_FALSE(ok);
+}
+
+TEST(JsonTest, Errors)
+{
+  for (const char* json : {"\"unterminated", "[1, 2", "[1}", "{\"a\" 1}", "{a : 1}",
+                           "[truex]", "[12abc]", "nope", R"("\u12")",
+                           R"(["\u00e"])"}) {
+    bool ok = true;
+    parse(json, ok);
+    ASSERT_FALSE(ok) << json;
+  }
+
+  bool ok = true;
+  parse(QString(5000, '['), ok);
+  ASSERT_FALSE(ok);
+}
+
+TEST(JsonTest, Document)
+{
+  const Document doc =
+      Document::parse(R"({ "name" : "SkyUI", "files" : )"
+                      R"([ { "id" : 1 }, { "id" : 2, "size" : 3.5 } ] })");
+
+  ASSERT_TRUE(doc.isValid());
+
+  const Value root = doc.root();
+  ASSERT_TRUE(root.isObject());
+  ASSERT_EQ(2, root.size());
+  ASSERT_EQ(QStringList({"name", "files"}), root.keys());
+  ASSERT_EQ("files", root.keyAt(1));
+  ASSERT_EQ("SkyUI", root["name"].toString());
+  ASSERT_FALSE(root["missing"].isValid());
+
+  const Value files = root["files"];
+  ASSERT_TRUE(files.isArray());
+  ASSERT_EQ(2, files.size());
+  ASSERT_DOUBLE_EQ(3.5, files.at(1)["size"].toDouble());
+  ASSERT_EQ("2", files.at(1)["id"].toString());
+  ASSERT_FALSE(files.at(2).isValid());
+
+  ASSERT_EQ(2u, files.at(1).toVariant().toMap()["id"].toUInt());
+
+  ASSERT_FALSE(Document::parse("[1, 2").isValid());
+  ASSERT_FALSE(Document::parse("[1, 2").root().isValid());
+}
+
+TEST(JsonTest, Serialize)
+{
+  QVariantMap map;
+  map["b"] = QVariantList{1, -2, 1.5, 2.0, true, QVariant()};
+  map["a"] = QStringList{"x\"y\\z", "tab\tnew\nline"};
+  map["c"] = QVariantMap();
+  map["d"] = QString::fromUtf8("caf\xc3\xa9 \x01");
+
+  const QByteArray expected =
+      R"({ "a" : [ "x\"y\\z", "tab\tnew\nline" ], "b" : [ 1, -2, 1.5, 2.0, true, )"
+      R"(null ], "c" : {  }, "d" : "caf)"
+      "\xc3\xa9"
+      R"( \u0001" })";
+
+  ASSERT_EQ(expected, serialize(map));
+  ASSERT_EQ(QString::fromUtf8(expected), serializeStr(map));
+  ASSERT_EQ(map["d"], parse(serializeStr(map)).toMap()["d"]);
+
+  bool ok = true;
+  ASSERT_TRUE(serialize(QVariantList{std::numeric_limits<double>::infinity()}, ok)
+                  .isNull());
+  ASSERT_FALSE(ok);
+
+  QBuffer buffer;
+  buffer.open(QIODevice::WriteOnly);
+
+  {
+    Writer writer(&buffer);
+    ASSERT_TRUE(writer.write(map));
+  }
+
+  ASSERT_EQ(expected, buffer.data());
+}
+
+namespace
+{
+
+// something shaped like the file lists and user data that come from Nexus
+//
+QString makePayload(int files)
+{
+  QString json = "[ ";
+
+  for (int i = 0; i < files; ++i) {
+    if (i > 0) {
+      json += ", ";
+    }
+
+    json += QString(R"({ "file_id" : %1, "name" : "Main File %1", )"
+                    R"("version" : "1.%1.2", )"
+                    R"("category_id" : %2, "size_kb" : %3, "size_in_bytes" : %4, )"
+                    R"("is_primary" : %5, "uploaded_timestamp" : 1600000000, )"
+                    R"("rating" : %6, "changelog" : [ "fixed \"quoted\" thing", )"
+                    R"("path C:\\Games\\Skyrim\\Data", "caf\u00e9" ], )"
+                    R"("description" : "%7", "user_data" : { "endorsed" : false, )"
+                    R"("tracked" : null, "tags" : [ ] } })")
+                .arg(i)
+                .arg(i % 7)
+                .arg(i * 13)
+                .arg(qulonglong(i) * 4096 * 1024 * 1024)
+                .arg(QString(i % 2 == 0 ? "true" : "false"))
+                .arg(double(i) / 3.0)
+                .arg(QString(i % 97, 'x'));
+  }
+
+  json += " ]";
+  return json;
+}
+
+}  // namespace
+
+TEST(JsonTest, MatchesLegacy)
+{
+  const QString json = makePayload(200);
+
+  bool legacyOk = false, ok = false;
+  const QVariant expected = legacy::parse(json, legacyOk);
+  const QVariant actual   = parse(json, ok);
+
+  ASSERT_TRUE(legacyOk);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(expected, actual);
+}
+
+// prints timings instead of checking anything new, run it with
+// --gtest_also_run_disabled_tests
+//
+TEST(JsonTest, DISABLED_Benchmark)
+{
+  // a few MB, the size of the larger metadata payloads
+  const QString json     = makePayload(8000);
+  const QByteArray utf8  = json.toUtf8();
+  const double megabytes = utf8.size() / (1024.0 * 1024.0);
+
+  QElapsedTimer timer;
+  bool ok = false;
+
+  timer.start();
+  const QVariant expected = legacy::parse(json, ok);
+  const qint64 legacyMs   = timer.elapsed();
+  ASSERT_TRUE(ok);
+
+  timer.restart();
+  const QVariant fromString = parse(json, ok);
+  const qint64 stringMs     = timer.elapsed();
+  ASSERT_TRUE(ok);
+
+  timer.restart();
+  const QVariant fromUtf8 = parseUtf8(utf8, ok);
+  const qint64 utf8Ms     = timer.elapsed();
+  ASSERT_TRUE(ok);
+
+  timer.restart();
+  const Document doc  = Document::parse(utf8);
+  const QString name  = doc.root().at(7999)["name"].toString();
+  const qint64 lazyMs = timer.elapsed();
+  ASSERT_EQ("Main File 7999", name);
+
+  ASSERT_EQ(expected, fromString);
+  ASSERT_EQ(expected, fromUtf8);
+
+  std::cout << std::format("parsing {:.1f} MB: legacy {} ms, parse() {} ms, "
+                           "parseUtf8() {} ms, Document lookup {} ms\n",
+                           megabytes, legacyMs, stringMs, utf8Ms, lazyMs);
+}
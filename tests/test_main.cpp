@@ -1,11 +1,22 @@
 #include <gtest/gtest.h>
 
-#include <QCoreApplication>
+#include <QApplication>
 #include <QTranslator>
 
+#include <uibase/log.h>
+
 int main(int argc, char** argv)
 {
-  QCoreApplication app(argc, argv);
+  // some tests drive widgets, they are never shown
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+
+  QApplication app(argc, argv);
+
+  // some of the code under test logs, only errors are shown
+  MOBase::log::createDefault({.name = "tests", .maxLevel = MOBase::log::Error});
+
   QTranslator translator;
   if (translator.load("tests_fr", "tests/translations")) {
     app.installTranslator(&translator);
@@ -0,0 +1,163 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <uibase/qinipp.h>
+
+using namespace qinipp;
+
+namespace
+{
+
+QString value(const Table& table, const char* section, const char* key)
+{
+  const auto* entry = table.find(section, key);
+  return entry ? QString::fromUtf8(entry->value) : QString("<none>");
+}
+
+}  // namespace
+
+TEST(QinippTest, Table)
+{
+  const Table table("\xef\xbb\xbf"
+                    "global=1\r\n"
+                    "[General]\r\n"
+                    "  sLanguage = ENGLISH \r\n"
+                    "; comment\n"
+                    "[Display]\n"
+                    "iSize H=1080\n"
+                    "[general]\n"
+                    "sLanguage=duplicate\n"
+                    "bFoo=1\n"
+                    "[Empty]\n"
+                    "[broken\n"
+                    "no assignment\n");
+
+  ASSERT_EQ(4, table.sections().size());
+  ASSERT_EQ("", table.sections()[0].name);
+  ASSERT_EQ("General", table.sections()[1].name);
+  ASSERT_EQ("Display", table.sections()[2].name);
+  ASSERT_EQ("Empty", table.sections()[3].name);
+
+  // entries of a section that appears twice are kept together, in order
+  const auto general = table.entries(table.sections()[1]);
+  ASSERT_EQ(2, general.size());
+  ASSERT_EQ("sLanguage", general[0].key);
+  ASSERT_EQ("bFoo", general[1].key);
+
+  ASSERT_EQ("ENGLISH", value(table, "GENERAL", "slanguage"));
+  ASSERT_EQ("1", value(table, "general", "BFOO"));
+  ASSERT_EQ("1080", value(table, "display", "isize h"));
+  ASSERT_EQ("1", value(table, "", "global"));
+  ASSERT_EQ("<none>", value(table, "display", "sLanguage"));
+  ASSERT_EQ("<none>", value(table, "missing", "global"));
+
+  ASSERT_EQ(QStringList({"sLanguage=duplicate", "[broken", "no assignment"}),
+            table.errors());
+}
+
+TEST(QinippTest, Sections)
+{
+  Ini ini;
+  ini.parse(QByteArray("[A]\nx = 1\n[B]\ny=2\n[A]\nz=3\nx=4\n"));
+
+  ASSERT_EQ(2, ini.sections.size());
+  ASSERT_EQ("1", ini.sections["A"]["x"]);
+  ASSERT_EQ("3", ini.sections["A"]["z"]);
+  ASSERT_EQ("2", ini.sections["B"]["y"]);
+  ASSERT_EQ(1, ini.errors.size());
+}
+
+TEST(QinippTest, CaseSensitiveSections)
+{
+  // Table merges names regardless of case, Ini never did
+  Ini ini;
+  ini.parse(QByteArray("[General]\nName = a\nname = b\n[general]\nName = c\n"
+                       "[Empty]\n"));
+
+  ASSERT_EQ(2, ini.sections.size());
+  ASSERT_EQ("a", ini.sections["General"]["Name"]);
+  ASSERT_EQ("b", ini.sections["General"]["name"]);
+  ASSERT_EQ("c", ini.sections["general"]["Name"]);
+  ASSERT_TRUE(ini.errors.isEmpty());
+}
+
+TEST(QinippTest, Interpolate)
+{
+  Ini ini;
+  ini.parse(QByteArray("[paths]\n"
+                       "root = C:/Games\n"
+                       "data = ${root}/Data\n"
+                       "mods = ${data}/${missing}\n"
+                       "[game]\n"
+                       "plugins = ${paths:data}/Plugins\n"
+                       "a = ${b}\n"
+                       "b = x${a}\n"));
+  ini.interpolate();
+
+  ASSERT_EQ("C:/Games/Data", ini.sections["paths"]["data"]);
+  ASSERT_EQ("C:/Games/Data/${missing}", ini.sections["paths"]["mods"]);
+  ASSERT_EQ("C:/Games/Data/Plugins", ini.sections["game"]["plugins"]);
+  ASSERT_EQ("x${a}", ini.sections["game"]["a"]);
+  ASSERT_EQ("x${a}", ini.sections["game"]["b"]);
+
+  ASSERT_EQ(2, ini.errors.size());
+  ASSERT_TRUE(ini.errors[0].startsWith("circular reference ${a}"));
+  ASSERT_TRUE(ini.errors[1].startsWith("unresolved reference ${missing}"));
+}
+
+TEST(QinippTest, InterpolateLongChain)
+{
+  // deep enough to overflow the stack if every reference was a call
+  constexpr int count = 200000;
+
+  QByteArray data = "[chain]\n";
+  for (int i = 0; i < count; ++i) {
+    data += "k" + QByteArray::number(i) + " = ${k" + QByteArray::number(i + 1) + "}\n";
+  }
+  data += "k" + QByteArray::number(count) + " = end\n";
+
+  Ini ini;
+  ini.parse(data);
+  ini.interpolate();
+
+  ASSERT_EQ("end", ini.sections["chain"]["k0"]);
+  ASSERT_TRUE(ini.errors.isEmpty());
+}
+
+TEST(QinippTest, Editor)
+{
+  const QByteArray original = "; comment\r\n"
+                              "[General]\r\n"
+                              "sLanguage = ENGLISH\r\n"
+                              "bFoo=0\r\n"
+                              "\r\n"
+                              "[Display]\r\n"
+                              "iSize H=1080\r\n"
+                              "[Remove]\r\n"
+                              "x=1\r\n";
+
+  Editor unchanged(original);
+  ASSERT_FALSE(unchanged.modified());
+  ASSERT_EQ(original, unchanged.result());
+
+  Editor editor(original);
+  editor.set("general", "slanguage", "FRENCH");
+  editor.remove("General", "bFoo");
+  editor.set("Display", "iSize W", "1920");
+  editor.remove_section("remove");
+  editor.set("New", "key", "value");
+
+  ASSERT_TRUE(editor.modified());
+  ASSERT_EQ("; comment\r\n"
+            "[General]\r\n"
+            "sLanguage = FRENCH\r\n"
+            "\r\n"
+            "[Display]\r\n"
+            "iSize H=1080\r\n"
+            "iSize W=1920\r\n"
+            "[New]\r\n"
+            "key=value\r\n",
+            editor.result());
+}
@@ -0,0 +1,100 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QTemporaryDir>
+
+#include <uibase/questionboxmemory.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace MOBase;
+
+namespace
+{
+
+using BB = QDialogButtonBox;
+
+// the delayed writes happen from the event loop
+template <class Pred>
+bool processEventsUntil(Pred pred)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  while (!pred() && timer.elapsed() < 10000) {
+    QCoreApplication::processEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return pred();
+}
+
+// number of choices in the ini file
+int storedChoices(const QString& path)
+{
+  QSettings settings(path, QSettings::IniFormat);
+  const int count = settings.beginReadArray("choices");
+  settings.endArray();
+
+  return count;
+}
+
+}  // namespace
+
+TEST(QuestionBoxMemoryTest, StorageFile)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path = dir.filePath("choices.ini");
+
+  QuestionBoxMemory::setStorageFile(path);
+  EXPECT_EQ(BB::NoButton, QuestionBoxMemory::getMemory("install", "mod.7z"));
+
+  QuestionBoxMemory::setWindowMemory("install", BB::Yes);
+  QuestionBoxMemory::setFileMemory("install", "mod.7z", BB::No);
+  QuestionBoxMemory::setFileMemory("overwrite", "other.7z", BB::Ignore);
+  QuestionBoxMemory::setFileMemory("overwrite", "other.7z", BB::NoButton);
+
+  // answered from memory before anything is written, the choice for a file takes
+  // precedence over the one for its window
+  EXPECT_EQ(BB::No, QuestionBoxMemory::getMemory("install", "mod.7z"));
+  EXPECT_EQ(BB::Yes, QuestionBoxMemory::getMemory("install", "other.7z"));
+  EXPECT_EQ(BB::Yes, QuestionBoxMemory::getMemory("install", ""));
+  EXPECT_EQ(BB::NoButton, QuestionBoxMemory::getMemory("overwrite", "other.7z"));
+
+  QuestionBoxMemory::flushMemory();
+  EXPECT_EQ(2, storedChoices(path));
+
+  // the file is written when going back to the callbacks, and read again
+  QuestionBoxMemory::setWindowMemory("extract", BB::Retry);
+  QuestionBoxMemory::setStorageFile("");
+  EXPECT_EQ(BB::NoButton, QuestionBoxMemory::getMemory("install", "mod.7z"));
+  EXPECT_EQ(3, storedChoices(path));
+
+  QuestionBoxMemory::setStorageFile(path);
+  EXPECT_EQ(BB::No, QuestionBoxMemory::getMemory("install", "mod.7z"));
+  EXPECT_EQ(BB::Yes, QuestionBoxMemory::getMemory("install", "other.7z"));
+  EXPECT_EQ(BB::Retry, QuestionBoxMemory::getMemory("extract", ""));
+  EXPECT_EQ(BB::NoButton, QuestionBoxMemory::getMemory("overwrite", "other.7z"));
+
+  // a choice remembered on another thread is written by the writer of the
+  // application thread
+  std::thread([] {
+    QuestionBoxMemory::setFileMemory("thread", "archive.7z", BB::YesToAll);
+  }).join();
+
+  EXPECT_EQ(BB::YesToAll, QuestionBoxMemory::getMemory("thread", "archive.7z"));
+
+  EXPECT_TRUE(processEventsUntil([&] {
+    return storedChoices(path) == 4;
+  }));
+
+  QuestionBoxMemory::setStorageFile("");
+}
@@ -0,0 +1,572 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <uibase/steamutility.h>
+
+#ifdef __unix__
+
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QTemporaryDir>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace MOBase;
+
+namespace
+{
+
+// writes binary vdf documents, key names are written inline unless a string table
+// is given
+class VdfWriter
+{
+public:
+  explicit VdfWriter(std::vector<std::string>* strings = nullptr) : m_strings(strings)
+  {}
+
+  const std::vector<std::uint8_t>& bytes() const { return m_bytes; }
+
+  VdfWriter& begin(std::string_view name)
+  {
+    header(BinaryVdfView::Type::Document, name);
+    return *this;
+  }
+
+  VdfWriter& end()
+  {
+    // end of document marker
+    m_bytes.push_back(8);
+    return *this;
+  }
+
+  VdfWriter& string(std::string_view name, std::string_view value)
+  {
+    header(BinaryVdfView::Type::String, name);
+    m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+    m_bytes.push_back(0);
+    return *this;
+  }
+
+  VdfWriter& wideString(std::string_view name, std::u16string_view value)
+  {
+    header(BinaryVdfView::Type::WideString, name);
+    raw(static_cast<std::uint32_t>(value.size()));
+    for (char16_t c : value) {
+      raw(c);
+    }
+    return *this;
+  }
+
+  VdfWriter& integer(std::string_view name, std::int32_t value)
+  {
+    header(BinaryVdfView::Type::Int, name);
+    raw(value);
+    return *this;
+  }
+
+  VdfWriter& real(std::string_view name, float value)
+  {
+    header(BinaryVdfView::Type::Float, name);
+    raw(value);
+    return *this;
+  }
+
+  VdfWriter& color(std::string_view name, std::int32_t value)
+  {
+    header(BinaryVdfView::Type::Color, name);
+    raw(value);
+    return *this;
+  }
+
+  VdfWriter& uint64(std::string_view name, std::uint64_t value)
+  {
+    header(BinaryVdfView::Type::UInt64, name);
+    raw(value);
+    return *this;
+  }
+
+  template <class T>
+  void raw(T value)
+  {
+    const auto* p = reinterpret_cast<const std::uint8_t*>(&value);
+    m_bytes.insert(m_bytes.end(), p, p + sizeof(T));
+  }
+
+private:
+  std::vector<std::uint8_t> m_bytes;
+  std::vector<std::string>* m_strings;
+
+  void header(BinaryVdfView::Type type, std::string_view name)
+  {
+    m_bytes.push_back(static_cast<std::uint8_t>(type));
+
+    if (m_strings == nullptr) {
+      m_bytes.insert(m_bytes.end(), name.begin(), name.end());
+      m_bytes.push_back(0);
+      return;
+    }
+
+    std::uint32_t index = 0;
+    while (index < m_strings->size() && (*m_strings)[index] != name) {
+      ++index;
+    }
+
+    if (index == m_strings->size()) {
+      m_strings->emplace_back(name);
+    }
+
+    raw(index);
+  }
+};
+
+// the document Steam stores for an app, its root is named "appinfo"
+std::vector<std::uint8_t> appDocument(std::uint32_t appID, std::string_view name,
+                                      std::vector<std::string>* strings = nullptr)
+{
+  VdfWriter w(strings);
+
+  w.begin("appinfo")
+      .integer("appid", static_cast<std::int32_t>(appID))
+      .begin("common")
+      .string("name", name)
+      .end()
+      .end();
+
+  return w.bytes();
+}
+
+// an appinfo.vdf with the given documents, versions 41 and later also get the string
+// table the documents refer to
+std::vector<std::uint8_t>
+appInfo(std::uint8_t version,
+        const std::vector<std::pair<std::uint32_t, std::vector<std::uint8_t>>>& apps,
+        const std::vector<std::string>& strings = {})
+{
+  VdfWriter w;
+
+  // magic, the first byte is the version, then the universe
+  w.raw(static_cast<std::uint32_t>(0x07564400 | version));
+  w.raw(std::uint32_t(1));
+
+  if (version >= 41) {
+    // offset of the string table, filled in below
+    w.raw(std::int64_t(0));
+  }
+
+  // size, last change, PICS token and checksums before the document
+  std::size_t entryHeader = 12;
+  if (version >= 40) {
+    entryHeader += 48;
+  } else if (version >= 38) {
+    entryHeader += 28;
+  }
+
+  for (const auto& [appID, document] : apps) {
+    w.raw(appID);
+    w.raw(static_cast<std::uint32_t>(entryHeader + document.size()));
+
+    for (std::size_t i = 0; i < entryHeader; ++i) {
+      w.raw(std::uint8_t(0));
+    }
+
+    for (std::uint8_t b : document) {
+      w.raw(b);
+    }
+  }
+
+  w.raw(std::uint32_t(0));
+
+  std::vector<std::uint8_t> bytes = w.bytes();
+
+  if (version >= 41) {
+    const auto offset = static_cast<std::int64_t>(bytes.size());
+    std::memcpy(bytes.data() + 8, &offset, sizeof(offset));
+
+    VdfWriter table;
+    table.raw(static_cast<std::uint32_t>(strings.size()));
+    for (const auto& s : strings) {
+      for (char c : s) {
+        table.raw(c);
+      }
+      table.raw('\0');
+    }
+
+    bytes.insert(bytes.end(), table.bytes().begin(), table.bytes().end());
+  }
+
+  return bytes;
+}
+
+// replaces the file instead of overwriting it, an index may still have it mapped
+void writeFile(const QString& path, const std::vector<std::uint8_t>& bytes,
+               const QDateTime& modified)
+{
+  QSaveFile out(path);
+  ASSERT_TRUE(out.open(QIODevice::WriteOnly));
+  out.write(reinterpret_cast<const char*>(bytes.data()),
+            static_cast<qint64>(bytes.size()));
+  ASSERT_TRUE(out.commit());
+
+  QFile f(path);
+  ASSERT_TRUE(f.open(QIODevice::ReadWrite));
+  ASSERT_TRUE(f.setFileTime(modified, QFileDevice::FileModificationTime));
+}
+
+std::string appName(AppInfoIndex& index, std::uint32_t appID)
+{
+  const auto entry = index.find(appID);
+  if (!entry) {
+    return {};
+  }
+
+  const auto name = entry.vdf().find("common/name");
+  return name ? std::string(name->asString()) : std::string();
+}
+
+// a few nested documents in front of the values that are looked for
+std::vector<std::uint8_t> appConfig(std::vector<std::string>* strings = nullptr)
+{
+  VdfWriter w(strings);
+
+  w.begin("depots")
+      .begin("1")
+      .begin("manifests")
+      .begin("public")
+      .uint64("gid", 1234567890123ull)
+      .integer("size", 42)
+      .end()
+      .end()
+      .wideString("label", u"d\u00e9p\u00f4t")
+      .real("ratio", 0.5f)
+      .color("tint", 0x11223344)
+      .end()
+      .begin("2")
+      .string("name", "ignored")
+      .end()
+      .end();
+
+  w.begin("common").string("name", "Game").string("type", "game").end();
+
+  w.begin("config")
+      .begin("app_mappings")
+      .begin("0")
+      .string("platform", "linux")
+      .string("tool", "runtime")
+      .end()
+      .begin("1")
+      .string("platform", "windows")
+      .string("tool", "proton")
+      .end()
+      .end()
+      .end();
+
+  return w.bytes();
+}
+
+std::vector<std::string_view> names(const std::vector<BinaryVdfView::Value>& values)
+{
+  std::vector<std::string_view> v;
+  for (const auto& value : values) {
+    v.push_back(value.name());
+  }
+
+  return v;
+}
+
+}  // namespace
+
+TEST(BinaryVdfViewTest, Paths)
+{
+  const auto bytes = appConfig();
+  const BinaryVdfView vdf(bytes);
+
+  const auto name = vdf.find("common/name");
+  ASSERT_TRUE(name.has_value());
+  ASSERT_EQ(BinaryVdfView::Type::String, name->type());
+  ASSERT_EQ("name", name->name());
+  ASSERT_EQ("Game", name->asString());
+  ASSERT_EQ(QString("Game"), name->toString());
+
+  ASSERT_FALSE(vdf.find("common/missing").has_value());
+  ASSERT_FALSE(vdf.find("missing/name").has_value());
+  ASSERT_FALSE(vdf.find("common/name/deeper").has_value());
+
+  using Names = std::vector<std::string_view>;
+  ASSERT_EQ(Names({"depots", "common", "config"}), names(vdf.query("*")));
+  ASSERT_EQ(Names({"name", "type"}), names(vdf.query("common/*")));
+
+  const auto tools = vdf.query("config/app_mappings/*/tool");
+  ASSERT_EQ(2u, tools.size());
+  ASSERT_EQ("runtime", tools[0].asString());
+  ASSERT_EQ("proton", tools[1].asString());
+
+  // the value of a document is a view of its children
+  const auto mappings = vdf.find("config/app_mappings");
+  ASSERT_TRUE(mappings.has_value());
+  ASSERT_EQ(BinaryVdfView::Type::Document, mappings->type());
+  ASSERT_EQ("windows", mappings->asDocument().find("1/platform")->asString());
+  ASSERT_TRUE(name->asDocument().query("*").empty());
+}
+
+TEST(BinaryVdfViewTest, Types)
+{
+  const auto bytes = appConfig();
+  const BinaryVdfView vdf(bytes);
+
+  ASSERT_EQ(1234567890123ull, vdf.find("depots/1/manifests/public/gid")->asUInt64());
+  ASSERT_EQ(42, vdf.find("depots/1/manifests/public/size")->asInt());
+  ASSERT_EQ(0.5f, vdf.find("depots/1/ratio")->asFloat());
+  ASSERT_EQ(0x11223344, vdf.find("depots/1/tint")->asInt());
+
+  const auto label = vdf.find("depots/1/label");
+  ASSERT_EQ(BinaryVdfView::Type::WideString, label->type());
+  ASSERT_EQ(QString::fromUtf8("d\xc3\xa9p\xc3\xb4t"), label->toString());
+  ASSERT_TRUE(label->asString().empty());
+
+  // conversions to other types give nothing
+  ASSERT_EQ(0, vdf.find("common/name")->asInt());
+  ASSERT_EQ(0u, vdf.find("depots/1/manifests/public/size")->asUInt64());
+  ASSERT_EQ(0.0f, vdf.find("depots/1/tint")->asFloat());
+}
+
+TEST(BinaryVdfViewTest, SkipsNestedDocuments)
+{
+  const auto bytes = appConfig();
+  const BinaryVdfView vdf(bytes);
+
+  // "depots" has documents three levels deep and every type of value, all of it is
+  // stepped over to get to the documents after it
+  ASSERT_EQ("game", vdf.find("common/type")->asString());
+  ASSERT_EQ("ignored", vdf.find("depots/2/name")->asString());
+
+  // a wildcard only descends into the documents that have the rest of the path
+  const auto sizes = vdf.query("depots/*/manifests/public/size");
+  ASSERT_EQ(1u, sizes.size());
+  ASSERT_EQ(42, sizes[0].asInt());
+
+  // the walk stops when the callback returns false
+  int calls = 0;
+  vdf.forEach("*", [&](const BinaryVdfView::Value&) {
+    ++calls;
+    return false;
+  });
+  ASSERT_EQ(1, calls);
+}
+
+TEST(BinaryVdfViewTest, StringTable)
+{
+  std::vector<std::string> strings;
+  const auto bytes = appConfig(&strings);
+
+  const std::vector<std::string_view> table(strings.begin(), strings.end());
+  const BinaryVdfView vdf(bytes, table);
+
+  ASSERT_EQ("Game", vdf.find("common/name")->asString());
+  ASSERT_EQ("proton", vdf.find("config/app_mappings/1/tool")->asString());
+  ASSERT_EQ(42, vdf.find("depots/1/manifests/public/size")->asInt());
+
+  // an index past the end of the table
+  const BinaryVdfView missing(bytes, std::span(table).first(2));
+  ASSERT_THROW(missing.find("common/name"), std::runtime_error);
+}
+
+TEST(BinaryVdfViewTest, Malformed)
+{
+  const auto bytes = appConfig();
+
+  // cut in the middle of the documents before "common"
+  const BinaryVdfView truncated(std::span(bytes).first(20));
+  ASSERT_THROW(truncated.find("common/name"), std::runtime_error);
+
+  // not a value type
+  auto invalid = bytes;
+  invalid[0]   = 9;
+  ASSERT_THROW(BinaryVdfView(invalid).find("common"), std::runtime_error);
+
+  // an empty view has nothing
+  ASSERT_FALSE(BinaryVdfView().find("*").has_value());
+}
+
+TEST(AppInfoIndexTest, Find)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path = dir.filePath("appinfo.vdf");
+  const auto time    = QDateTime::fromSecsSinceEpoch(1700000000);
+
+  const auto ten    = appDocument(10, "Ten");
+  const auto twenty = appDocument(20, "Twenty");
+
+  writeFile(path, appInfo(39, {{10, ten}, {20, twenty}}), time);
+
+  AppInfoIndex index(path);
+  ASSERT_EQ("Ten", appName(index, 10));
+  ASSERT_EQ("Twenty", appName(index, 20));
+  ASSERT_FALSE(index.find(30).isValid());
+
+  const auto entry = index.find(20);
+  ASSERT_EQ(20u, entry.appID());
+  ASSERT_TRUE(entry.strings().empty());
+  ASSERT_EQ(20, entry.vdf().find("appid")->asInt());
+}
+
+TEST(AppInfoIndexTest, StringTable)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path = dir.filePath("appinfo.vdf");
+
+  std::vector<std::string> strings;
+  const auto first  = appDocument(10, "Ten", &strings);
+  const auto second = appDocument(20, "Twenty", &strings);
+
+  writeFile(path, appInfo(41, {{10, first}, {20, second}}, strings),
+            QDateTime::fromSecsSinceEpoch(1700000000));
+
+  AppInfoIndex index(path);
+  ASSERT_EQ("Ten", appName(index, 10));
+  ASSERT_EQ("Twenty", appName(index, 20));
+  ASSERT_EQ(strings.size(), index.find(10).strings().size());
+}
+
+TEST(AppInfoIndexTest, UnsupportedVersion)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path = dir.filePath("appinfo.vdf");
+  writeFile(path, appInfo(35, {{10, appDocument(10, "Ten")}}),
+            QDateTime::fromSecsSinceEpoch(1700000000));
+
+  AppInfoIndex index(path);
+  ASSERT_THROW(index.find(10), std::runtime_error);
+}
+
+TEST(AppInfoIndexTest, RebuiltWhenFileChanges)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path = dir.filePath("appinfo.vdf");
+
+  writeFile(path, appInfo(39, {{10, appDocument(10, "Ten")}}),
+            QDateTime::fromSecsSinceEpoch(1700000000));
+
+  AppInfoIndex index(path);
+  const auto old = index.find(10);
+  ASSERT_EQ("Ten", appName(index, 10));
+
+  const auto ten    = appDocument(10, "TEN");
+  const auto twenty = appDocument(20, "Twenty");
+
+  writeFile(path, appInfo(39, {{20, twenty}, {10, ten}}),
+            QDateTime::fromSecsSinceEpoch(1700000100));
+
+  ASSERT_EQ("TEN", appName(index, 10));
+  ASSERT_EQ("Twenty", appName(index, 20));
+
+  // entries keep the file they were found in
+  ASSERT_EQ("Ten", old.vdf().find("common/name")->asString());
+}
+
+TEST(AppInfoIndexTest, CacheFile)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path  = dir.filePath("appinfo.vdf");
+  const QString cache = dir.filePath("appinfo.index");
+  const auto time     = QDateTime::fromSecsSinceEpoch(1700000000);
+
+  // both names have the same length, swapping the apps keeps the file size
+  const auto ten    = appDocument(10, "AAAA");
+  const auto twenty = appDocument(20, "BBBB");
+
+  writeFile(path, appInfo(39, {{10, ten}, {20, twenty}}), time);
+
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("AAAA", appName(index, 10));
+  }
+
+  ASSERT_TRUE(QFile::exists(cache));
+
+  // same size and time, the offsets are taken from the cache without looking at the
+  // file, which shows that the cache was used
+  writeFile(path, appInfo(39, {{20, twenty}, {10, ten}}), time);
+
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("BBBB", appName(index, 10));
+  }
+
+  // a different time makes the cache stale, the file is scanned again
+  writeFile(path, appInfo(39, {{20, twenty}, {10, ten}}), time.addSecs(60));
+
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("AAAA", appName(index, 10));
+    ASSERT_EQ("BBBB", appName(index, 20));
+  }
+
+  // the cache was rewritten for the new file
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("AAAA", appName(index, 10));
+  }
+}
+
+TEST(AppInfoIndexTest, InvalidCacheFile)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  const QString path  = dir.filePath("appinfo.vdf");
+  const QString cache = dir.filePath("appinfo.index");
+  const auto time     = QDateTime::fromSecsSinceEpoch(1700000000);
+
+  // both names have the same length, swapping the apps keeps the file size
+  const auto ten    = appDocument(10, "AAAA");
+  const auto twenty = appDocument(20, "BBBB");
+
+  writeFile(path, appInfo(39, {{10, ten}, {20, twenty}}), time);
+
+  // not an index
+  {
+    QFile f(cache);
+    ASSERT_TRUE(f.open(QIODevice::WriteOnly));
+    f.write("garbage");
+  }
+
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("AAAA", appName(index, 10));
+  }
+
+  // the index is for a file with another version but the same size and time, its
+  // offsets would give the wrong app
+  writeFile(path, appInfo(38, {{20, twenty}, {10, ten}}), time);
+
+  {
+    AppInfoIndex index(path);
+    index.setCacheFile(cache);
+    ASSERT_EQ("AAAA", appName(index, 10));
+    ASSERT_EQ("BBBB", appName(index, 20));
+  }
+}
+
+#endif  // __unix__
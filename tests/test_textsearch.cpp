@@ -0,0 +1,256 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <uibase/textsearch.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MOBase;
+
+namespace
+{
+
+// matches are merged by a timer on the gui thread
+void waitFor(const TextSearch& search)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  while (!search.isComplete() && timer.elapsed() < 10000) {
+    QCoreApplication::processEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  ASSERT_TRUE(search.isComplete());
+}
+
+std::vector<qint64> begins(const TextSearch& search)
+{
+  std::vector<qint64> v;
+  for (qint64 i = 0; i < search.count(); ++i) {
+    v.push_back(search.at(i).begin);
+  }
+
+  return v;
+}
+
+// a few MB of log lines, so that the text is split in several chunks
+QString makeLog(int lines)
+{
+  QString log;
+
+  for (int i = 0; i < lines; ++i) {
+    log += QString("[%1] %2 loading plugin %3.esp\n")
+               .arg(i)
+               .arg(QString(i % 13 == 0 ? "error" : "info"))
+               .arg(i % 97);
+  }
+
+  return log;
+}
+
+}  // namespace
+
+TEST(TextSearchTest, Literal)
+{
+  TextSearch search;
+  search.setText("Hello hello\nHELLO");
+  search.setPattern("hello", false);
+  waitFor(search);
+
+  ASSERT_TRUE(search.isValid());
+  ASSERT_EQ(std::vector<qint64>({0, 6, 12}), begins(search));
+  ASSERT_EQ(17, search.at(2).end);
+
+  // matches can overlap
+  search.setText("aaaa");
+  search.setPattern("aa", false);
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0, 1, 2}), begins(search));
+
+  search.setPattern("", false);
+  ASSERT_TRUE(search.isComplete());
+  ASSERT_EQ(0, search.count());
+}
+
+TEST(TextSearchTest, Regex)
+{
+  TextSearch search;
+  search.setText("error: a\nwarning: b\nerror: c");
+  search.setPattern("^error: (\\w)$", true);
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0, 20}), begins(search));
+  ASSERT_EQ(28, search.at(1).end);
+
+  search.setPattern("(unclosed", true);
+  waitFor(search);
+
+  ASSERT_FALSE(search.isValid());
+  ASSERT_EQ(0, search.count());
+}
+
+TEST(TextSearchTest, Utf8)
+{
+  const auto data =
+      std::make_shared<QByteArray>("caf\xc3\xa9 Error\n"
+                                   "na\xc3\xafve ERROR \xf0\x9f\x98\x80 error\n");
+
+  const std::vector<qint64> expected = {6, 19, 30};
+
+  TextSearch search;
+  search.setData(data, data->constData(), 0, data->size());
+  search.setPattern("error", false);
+  waitFor(search);
+
+  ASSERT_EQ(expected, begins(search));
+
+  // offsets of regular expressions are converted back to bytes
+  search.setPattern("e\\w+r", true);
+  waitFor(search);
+
+  ASSERT_EQ(expected, begins(search));
+  ASSERT_EQ(35, search.at(2).end);
+}
+
+TEST(TextSearchTest, InvalidUtf8)
+{
+  // invalid bytes, a truncated sequence and a last line without a newline
+  const auto data = std::make_shared<QByteArray>("\xff\xfe\xfd error\n"
+                                                 "x \xe2\x82 ERROR\n"
+                                                 "error");
+
+  const std::vector<qint64> expected = {4, 15, 21};
+
+  TextSearch search;
+  search.setData(data, data->constData(), 0, data->size());
+  search.setPattern("error", false);
+  waitFor(search);
+
+  ASSERT_EQ(expected, begins(search));
+
+  // the offsets do not drift past invalid bytes
+  search.setPattern("e\\w+r", true);
+  waitFor(search);
+
+  ASSERT_EQ(expected, begins(search));
+  ASSERT_EQ(9, search.at(0).end);
+  ASSERT_EQ(20, search.at(1).end);
+  ASSERT_EQ(data->size(), search.at(2).end);
+}
+
+TEST(TextSearchTest, Extend)
+{
+  const auto before = std::make_shared<QByteArray>("error a\nerr");
+  const auto after  = std::make_shared<QByteArray>("error a\nerror b\nerror");
+
+  TextSearch search;
+  search.setData(before, before->constData(), 0, before->size());
+  search.setPattern("error", false);
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0}), begins(search));
+
+  search.setCurrent(0);
+
+  // the last line was continued
+  search.extendData(after, after->constData(), after->size());
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0, 8, 16}), begins(search));
+  ASSERT_EQ(0, search.current());
+}
+
+TEST(TextSearchTest, AppendText)
+{
+  TextSearch search;
+  search.setText("error a\nerr");
+  search.setPattern("error", false);
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0}), begins(search));
+
+  search.setCurrent(0);
+
+  // the last line was continued
+  search.appendText(u"or b\nerror");
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0, 8, 16}), begins(search));
+  ASSERT_EQ(0, search.current());
+  ASSERT_EQ(21, search.end());
+
+  // more than the buffer holds
+  search.appendText(QString(" x").repeated(100) + "\nerror");
+  waitFor(search);
+
+  ASSERT_EQ(std::vector<qint64>({0, 8, 16, 222}), begins(search));
+  ASSERT_EQ(227, search.end());
+}
+
+TEST(TextSearchTest, Refine)
+{
+  const QString log = makeLog(100000);
+  const auto data   = std::make_shared<QByteArray>(log.toUtf8());
+
+  for (const bool bytes : {false, true}) {
+    TextSearch refined, fresh;
+
+    if (bytes) {
+      refined.setData(data, data->constData(), 0, data->size());
+      fresh.setData(data, data->constData(), 0, data->size());
+    } else {
+      refined.setText(log);
+      fresh.setText(log);
+    }
+
+    // as if typed
+    for (const char* pattern : {"e", "er", "err", "ERROR", "error loading"}) {
+      refined.setPattern(pattern, false);
+      waitFor(refined);
+    }
+
+    fresh.setPattern("error loading", false);
+    waitFor(fresh);
+
+    ASSERT_EQ(100000 / 13 + 1, fresh.count());
+    ASSERT_EQ(begins(fresh), begins(refined));
+  }
+}
+
+TEST(TextSearchTest, Navigation)
+{
+  TextSearch search;
+  search.setText("one two one two one");
+  search.setPattern("one", false);
+  waitFor(search);
+
+  ASSERT_EQ(3, search.count());
+
+  // from an offset without a current match
+  ASSERT_EQ(1, search.nextIndex(5));
+  ASSERT_EQ(0, search.previousIndex(5));
+  ASSERT_EQ(0, search.nextIndex(17));
+  ASSERT_EQ(2, search.previousIndex(0));
+
+  // from the current match, wrapping around
+  search.setCurrent(2);
+  ASSERT_EQ(0, search.nextIndex(0));
+  ASSERT_EQ(1, search.previousIndex(0));
+
+  search.setCurrent(0);
+  ASSERT_EQ(2, search.previousIndex(0));
+
+  // a new pattern forgets the current match
+  search.setPattern("two", false);
+  ASSERT_EQ(-1, search.current());
+}
@@ -0,0 +1,157 @@
+#pragma warning(push)
+#pragma warning(disable : 4668)
+#include <gtest/gtest.h>
+#pragma warning(pop)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <uibase/utility.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace MOBase;
+
+namespace
+{
+
+// callbacks of background loads are called from the event loop
+template <class Pred>
+bool processEventsUntil(Pred pred)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  while (!pred() && timer.elapsed() < 10000) {
+    QCoreApplication::processEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return pred();
+}
+
+// digit runs of different lengths, leading zeros, case and punctuation
+const QStringList s_Names{
+    "file10.txt", "file2.txt", "File1.txt", "file1.txt", "file01.txt", "a", "B",
+    "b10",        "b9",        "x001",      "x1",        "x01",        "10", "9",
+    "v1.10",      "v1.9",      "V1.9",      "",          "file 2",     "Z", "z"};
+
+QStringList naturalCompareSorted(QStringList list, Qt::CaseSensitivity cs)
+{
+  std::ranges::stable_sort(list, [cs](const QString& a, const QString& b) {
+    return naturalCompare(a, b, cs) < 0;
+  });
+
+  return list;
+}
+
+}  // namespace
+
+TEST(UtilityTest, NaturalSortMatchesNaturalCompare)
+{
+  for (const auto cs : {Qt::CaseInsensitive, Qt::CaseSensitive}) {
+    QStringList actual = s_Names;
+    naturalSort(actual, std::identity(), cs);
+
+    ASSERT_EQ(naturalCompareSorted(s_Names, cs), actual) << static_cast<int>(cs);
+  }
+
+  QStringList actual = s_Names;
+  naturalSort(actual);
+
+  // numbers are compared by value
+  ASSERT_LT(actual.indexOf("file2.txt"), actual.indexOf("file10.txt"));
+  ASSERT_LT(actual.indexOf("b9"), actual.indexOf("b10"));
+  ASSERT_LT(actual.indexOf("9"), actual.indexOf("10"));
+  ASSERT_LT(actual.indexOf("v1.9"), actual.indexOf("v1.10"));
+}
+
+TEST(UtilityTest, NaturalSortProjection)
+{
+  struct Item
+  {
+    QString name;
+    int id;
+  };
+
+  std::vector<Item> items;
+  for (int i = 0; i < s_Names.size(); ++i) {
+    items.push_back({s_Names[i], i});
+  }
+
+  for (const auto cs : {Qt::CaseInsensitive, Qt::CaseSensitive}) {
+    std::vector<Item> expected = items;
+    std::ranges::stable_sort(expected, [cs](const Item& a, const Item& b) {
+      return naturalCompare(a.name, b.name, cs) < 0;
+    });
+
+    std::vector<Item> actual = items;
+    naturalSort(actual, &Item::name, cs);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(expected[i].id, actual[i].id) << i;
+    }
+  }
+
+  // a projection that isn't a member
+  std::vector<int> numbers{10, 2, 33, 1, 20};
+  naturalSort(numbers, [](int n) {
+    return QString("item%1").arg(n);
+  });
+  ASSERT_EQ(std::vector<int>({1, 2, 10, 20, 33}), numbers);
+}
+
+TEST(UtilityTest, FileVersionAsyncCallsEveryCaller)
+{
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+
+  // not an executable, there is no version to find
+  const QString path = dir.filePath("tool.exe");
+  {
+    QFile f(path);
+    ASSERT_TRUE(f.open(QIODevice::WriteOnly));
+    f.write("not a PE file");
+  }
+
+  QObject first, second;
+  auto destroyed = std::make_unique<QObject>();
+
+  std::vector<const QObject*> called;
+  bool destroyedCalled = false;
+
+  // all of these are made before the event loop runs, so they wait for the same load
+  fileVersionAsync(path, &first, [&](const QString& version) {
+    EXPECT_TRUE(version.isEmpty());
+    called.push_back(&first);
+  });
+
+  fileVersionAsync(path, destroyed.get(), [&](const QString&) {
+    destroyedCalled = true;
+  });
+
+  fileVersionAsync(path, &second, [&](const QString& version) {
+    EXPECT_TRUE(version.isEmpty());
+    called.push_back(&second);
+  });
+
+  destroyed.reset();
+
+  ASSERT_TRUE(processEventsUntil([&] {
+    return called.size() >= 2;
+  }));
+
+  // nothing else is pending
+  QCoreApplication::processEvents();
+
+  ASSERT_EQ(std::vector<const QObject*>({&first, &second}), called);
+  ASSERT_FALSE(destroyedCalled);
+}
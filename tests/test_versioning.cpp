@@ -3,12 +3,20 @@
 #include <gtest/gtest.h>
 #pragma warning(pop)
 
+#include <QElapsedTimer>
 #include <QString>
+#include <QStringList>
 #include <vector>
 
+#include <uibase/versioninfo.h>
 #include <uibase/versioning.h>
 
+#include "legacy_versioning.h"
+
 #include <format>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
 
 using namespace MOBase;
 
@@ -88,3 +96,197 @@ TEST(VersioningTest, VersionCompare)
               v(2, 4, 1, 0, {ReleaseCandidate, 1, 1}));
   ASSERT_TRUE(v(1, 0, 0) < v(2, 0, 0, Alpha));
 }
+
+TEST(VersioningTest, VersionSortKey)
+{
+  // shortcuts, the pre-releases need a type when they start with 0
+  using v   = Version;
+  using pre = std::vector<std::variant<int, Version::ReleaseType>>;
+
+  // keys that differ must order like the versions, and equal versions must have equal
+  // keys, including for fields that do not fit in them
+  const std::vector<Version> versions{v(1, 0, 0),
+                                      v(1, 0, 0, Alpha),
+                                      v(1, 0, 0, Alpha, 1),
+                                      v(1, 0, 0, 0, {Alpha, 1, 0}),
+                                      v(1, 0, 0, 0, {Alpha, 1, 0, 2}),
+                                      v(1, 0, 0, Beta, 11),
+                                      v(1, 0, 0, Beta, 249),
+                                      v(1, 0, 0, Beta, 250),
+                                      v(1, 0, 0, Beta, 100000),
+                                      v(1, 0, 0, 0, pre{0}),
+                                      v(1, 0, 0, 0, pre{-1}),
+                                      v(1, 0, 0, 0, {1, 2, 3, 4, 5, 6, 7}),
+                                      v(1, 0, 0, 0, {1, 2, 3, 4, 5, 6, 7, 8}),
+                                      v(2, 4, 1, ReleaseCandidate, 1),
+                                      v(65535, 0, 0),
+                                      v(65536, 0, 0),
+                                      v(70000, 2, 0),
+                                      v(1, -1, 0)};
+
+  for (const auto& lhs : versions) {
+    for (const auto& rhs : versions) {
+      const auto cmp    = lhs <=> rhs;
+      const auto keyCmp = lhs.sortKey() <=> rhs.sortKey();
+
+      if (keyCmp != 0) {
+        ASSERT_TRUE(keyCmp == cmp);
+      } else if (lhs.sortKey().exact && rhs.sortKey().exact) {
+        ASSERT_TRUE(cmp == 0);
+      }
+
+      if (cmp == 0) {
+        ASSERT_TRUE(lhs.sortKey() == rhs.sortKey());
+      }
+    }
+  }
+
+  ASSERT_TRUE(v(1, 0, 0, Beta, 249) < v(1, 0, 0, Beta, 250));
+  ASSERT_TRUE(v(1, 0, 0, Beta, 250) < v(1, 0, 0, Beta, 100000));
+  ASSERT_TRUE(v(1, 0, 0, 0, pre{-1}) < v(1, 0, 0, 0, pre{0}));
+  ASSERT_TRUE(v(1, 0, 0, 0, {1, 2, 3, 4, 5, 6, 7}) <
+              v(1, 0, 0, 0, {1, 2, 3, 4, 5, 6, 7, 8}));
+  ASSERT_TRUE(v(65535, 0, 0) < v(65536, 0, 0));
+  ASSERT_TRUE(v(65536, 0, 0) < v(70000, 2, 0));
+  ASSERT_TRUE(v(1, -1, 0) < v(1, 0, 0, Alpha));
+
+  ASSERT_TRUE(v(1, 0, 0, Beta, 2).sortKey().exact);
+  ASSERT_FALSE(v(70000, 0, 0).sortKey().exact);
+
+  // equal versions hash the same
+  std::unordered_map<Version, int> map;
+  map[v(2, 4, 1, ReleaseCandidate, 1)] = 1;
+  ASSERT_EQ(1, map[v(2, 4, 1, 0, {ReleaseCandidate, 1, 0})]);
+  ASSERT_EQ(qHash(v(1, 0, 0, 0, pre{0, 0})), qHash(v(1, 0, 0, 0, pre{0})));
+}
+
+namespace
+{
+
+// versions from MO2 releases, plugins and mods, valid and invalid for both modes
+//
+const QStringList s_Versions{
+    "1.0.0", "2.5.2", "2.5.2-rc.1", "1.0.0-dev.1", "1.0.0-alpha.1.b", "1.0.0-Beta.2",
+    "1.0.0-rc.1+build.5", "1.0.0+20240101", "0.3.0-1", "1.0.0--1", "1.0.0-x",
+    "1.0.0-01", "1.0.0-", "1.0.0+", "1.0.0+a..b", "01.0.0", "1.0", "1.0.0.0",
+    "2.4.1rc1.1", "2.2.2.1beta2", "v2.5.2rc1", "2.5.2rc0", "2.5.2rc01", "2.5.2rc",
+    "1.0.0alpha1", "1.0.0a1+abc", "1.0.0dev2", "1.0.0gamma1", "2.4.0.1", "2.4.0.01",
+    "1.0.0\n", "99999999999.0.0", "1.0.0 ", "", "v1.0.0", "1.2.3rc1..2"};
+
+// the same kind of strings as found in mod meta.ini files
+//
+const QStringList s_ModVersions{
+    "1.0", "1.2.3", "v2.0.1", "V3", "1.0.0rc1", "2.3 beta 4", "1.05", "f1.05", "f1.2.3",
+    "n1.0.1a", "d2021.3.4", "d12.3.4", "final", "FINAL", "1.0a", "0.9b", "3.1.4.1.5",
+    "1.0 Alpha", "prealpha 3", "1..2", "1.", "beta", "SE 1.2", "2.0 hotfix",
+    "1.0.0-RC2", "0.0.0.1", "12345678901", "1.0.0.0 final", "a1", "v"};
+
+}  // namespace
+
+TEST(VersioningTest, VersionParseMatchesLegacy)
+{
+  for (const auto mode : {ParseMode::SemVer, ParseMode::MO2}) {
+    for (const auto& value : s_Versions) {
+      std::optional<Version> expected, actual;
+      QString expectedError, actualError;
+
+      try {
+        expected = legacy::parseVersion(value, mode);
+      } catch (InvalidVersionException& e) {
+        expectedError = e.what();
+      }
+
+      try {
+        actual = Version::parse(value, mode);
+      } catch (InvalidVersionException& e) {
+        actualError = e.what();
+      }
+
+      ASSERT_EQ(expectedError, actualError) << value.toStdString();
+      ASSERT_EQ(expected.has_value(), actual.has_value()) << value.toStdString();
+
+      if (expected) {
+        ASSERT_EQ(*expected, *actual) << value.toStdString();
+        ASSERT_EQ(expected->string(), actual->string()) << value.toStdString();
+      }
+    }
+  }
+}
+
+TEST(VersioningTest, VersionInfoParseMatchesLegacy)
+{
+  for (const bool manualInput : {false, true}) {
+    for (const auto& value : s_ModVersions) {
+      const auto expected = legacy::parseVersionInfo(value, manualInput);
+      const VersionInfo actual(value, VersionInfo::SCHEME_DISCOVER, manualInput);
+
+      ASSERT_EQ(expected.isValid(), actual.isValid()) << value.toStdString();
+      ASSERT_EQ(expected.scheme(), actual.scheme()) << value.toStdString();
+      ASSERT_EQ(expected.canonicalString(), actual.canonicalString())
+          << value.toStdString();
+      ASSERT_EQ(expected.displayString(), actual.displayString())
+          << value.toStdString();
+    }
+  }
+}
+
+// prints timings instead of checking anything new, run it with
+// --gtest_also_run_disabled_tests
+//
+TEST(VersioningTest, DISABLED_Benchmark)
+{
+  constexpr int iterations = 2000;
+
+  // only the strings that both parsers accept, exceptions would dominate
+  QStringList versions;
+  for (const auto& value : s_Versions) {
+    try {
+      legacy::parseVersion(value, ParseMode::MO2);
+      versions.push_back(value);
+    } catch (InvalidVersionException&) {
+    }
+  }
+
+  QElapsedTimer timer;
+  int count = 0;
+
+  timer.start();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& value : versions) {
+      count += legacy::parseVersion(value, ParseMode::MO2).major();
+    }
+  }
+  const qint64 legacyMs = timer.elapsed();
+
+  timer.restart();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& value : versions) {
+      count -= Version::parse(value, ParseMode::MO2).major();
+    }
+  }
+  const qint64 versionMs = timer.elapsed();
+
+  timer.restart();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& value : s_ModVersions) {
+      count += legacy::parseVersionInfo(value).isValid();
+    }
+  }
+  const qint64 legacyInfoMs = timer.elapsed();
+
+  timer.restart();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& value : s_ModVersions) {
+      count -= VersionInfo(value).isValid();
+    }
+  }
+  const qint64 versionInfoMs = timer.elapsed();
+
+  ASSERT_EQ(0, count);
+
+  std::cout << std::format("parsing {} versions: legacy {} ms, Version::parse() {} ms; "
+                           "{} mod versions: legacy {} ms, VersionInfo {} ms\n",
+                           versions.size() * iterations, legacyMs, versionMs,
+                           s_ModVersions.size() * iterations, legacyInfoMs,
+                           versionInfoMs);
+}